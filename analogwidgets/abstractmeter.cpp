@@ -40,12 +40,19 @@ bool AbstractMeter::calcMaxMin()
  return range(m_minimum,m_maximum,m_min,m_max,8,true); 
 }
 
+QRegion AbstractMeter::valueRegion()
+{
+ return QRegion(rect());
+}
+
 void AbstractMeter::setValue( double val )
 {
   if ( m_value != val )
   {
+    // repaint only where the old and the new value are shown
+    QRegion dirty = valueRegion();
     m_value = val;
-    update(); 
+    update(dirty + valueRegion());
     emit valueChanged(val);
     emit valueChanged((int)val); 
   }
@@ -55,8 +62,9 @@ void AbstractMeter::setValue( int val )
 {
   if ( m_value != val )
   {
+    QRegion dirty = valueRegion();
     m_value = val;
-    update(); // Ciekawe czy tak jest lepiej ??
+    update(dirty + valueRegion()); // Ciekawe czy tak jest lepiej ??
     // to znaczy najpierw odmalowa a potem generowa sygna ? 
     emit valueChanged(val);
     emit valueChanged(double(val));
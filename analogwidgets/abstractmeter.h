@@ -23,6 +23,7 @@
 #ifndef ABSTRACTMETER_H
 #define ABSTRACTMETER_H
 
+#include <QRegion>
 #include "widgetwithbackground.h"
 
    /**
@@ -94,6 +95,13 @@
 	 */
        
 	bool calcMaxMin();
+
+       /**
+         * Region of the widget that shows the current value (needle, value
+	 * string etc.), repainted when the value changes. By default this is
+	 * the whole widget.
+	 */
+	virtual QRegion valueRegion();
         
 	/** Starting value on meter  this value is less than m_minimum */
 	double m_min;
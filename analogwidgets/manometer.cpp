@@ -31,6 +31,24 @@ using namespace Qt;
 ManoMeter::ManoMeter(QWidget *parent)
         : AbstractMeter(parent)
 {
+	static const int hand[12] = {-4, 0, -1, 129, 1, 129, 4, 0, 8,-50, -8,-50};
+
+        // The needle outline never changes, so it's built here rather than
+        // on every paint. It has to exist before the first setValue().
+        m_handPath.moveTo(QPointF(hand[0],hand[1]));
+
+        for (int i=2;i<10;i+=2)
+	 m_handPath.lineTo(hand[i],hand[i+1]);
+
+	m_handPath.cubicTo ( 8.1,-51.0, 5.0,-48.0,   0.0,-48.0);
+	m_handPath.cubicTo(  -5.0,-48.0, -8.1,-51.0, -8.0,-50.0);
+
+        // Rendered needles are costed in KB; a few MB holds every angle the
+        // needle normally sits at, at any reasonable widget size.
+        m_needleCache.setMaxCost(4096);
+        m_valueText.setTextFormat(Qt::PlainText);
+        m_valueTextAscent = 0;
+
         m_max=300.0;
         m_min=0.0;
 
@@ -56,13 +74,125 @@ ManoMeter::ManoMeter(QWidget *parent)
 
 
 
-void ManoMeter::initCoordinateSystem(QPainter & painter)
+QTransform ManoMeter::coordinateTransform() const
 {
         int side = qMin(width(), height());
+        QTransform transform;
+        transform.translate(width() / 2, height() / 2);
+        transform.scale(side / 335.0, side / 335.0);
+        return transform;
+}
+
+void ManoMeter::initCoordinateSystem(QPainter & painter)
+{
         // painter initialization
         painter.setRenderHint(QPainter::Antialiasing);
-        painter.translate(width() / 2, height() / 2);
-        painter.scale(side / 335.0, side / 335.0);
+        painter.setTransform(coordinateTransform(), true);
+}
+
+/**
+ * Angle of the needle for a value, in tenths of a degree from the start of
+ * the scale. The needle is only ever drawn at these angles, which is fine
+ * enough to be invisible and lets rendered needles be reused.
+ */
+int ManoMeter::needleAngle(double value) const
+{
+        return qRound(((value - m_min) * 2400.0) / (m_max - m_min));
+}
+
+QTransform ManoMeter::needleTransform(int angle) const
+{
+        QTransform transform = coordinateTransform();
+        transform.rotate(60.0 + angle / 10.0);
+        return transform;
+}
+
+/** Widget area covered by the needle (and its hub) at an angle. */
+QRect ManoMeter::needleRect(int angle) const
+{
+        QTransform transform = needleTransform(angle);
+        QRectF bounds = transform.map(m_handPath).boundingRect() |
+                        transform.mapRect(QRectF(-10,-10,20,20));
+        // leave room for antialiasing
+        return bounds.toAlignedRect().adjusted(-1,-1,1,1);
+}
+
+/**
+ * Returns the needle rendered at an angle, rendering it if it isn't cached.
+ * Returns 0 if it couldn't be cached, in which case it has to be drawn
+ * directly.
+ */
+const ManoMeter::NeedleSprite * ManoMeter::needleSprite(int angle)
+{
+        if (m_needleCacheSize != size())
+        {
+          m_needleCache.clear();
+          m_needleCacheSize = size();
+        }
+
+        NeedleSprite * sprite = m_needleCache.object(angle);
+        if (!sprite)
+        {
+          QRect rect = needleRect(angle);
+          int ratio = devicePixelRatio();
+
+          sprite = new NeedleSprite;
+          sprite->position = rect.topLeft();
+          sprite->pixmap = QPixmap(rect.size() * ratio);
+          sprite->pixmap.setDevicePixelRatio(ratio);
+          sprite->pixmap.fill(Qt::transparent);
+
+          QPainter painter(&sprite->pixmap);
+          painter.setRenderHint(QPainter::Antialiasing);
+          painter.translate(-rect.topLeft());
+          painter.setTransform(needleTransform(angle), true);
+          painter.setPen(Qt::NoPen);
+          painter.setBrush(QBrush(Qt::black));
+          painter.drawPath(m_handPath);
+          painter.drawEllipse(-10,-10,20,20);
+          painter.end();
+
+          int cost = (rect.width() * rect.height() * ratio * ratio * 4) / 1024 + 1;
+          // the cache deletes the sprite if it won't fit
+          if (!m_needleCache.insert(angle, sprite, cost))
+            return 0;
+        }
+        return sprite;
+}
+
+/** Lays out the value string again if it (or its font) has changed. */
+void ManoMeter::updateValueText()
+{
+        QString str = prefix() + QString("%1").arg(value()) + suffix();
+        if (str != m_valueString || valueFont() != m_valueStringFont)
+        {
+          QFontMetrics metrics(valueFont(), this);
+          m_valueString = str;
+          m_valueStringFont = valueFont();
+          m_valueText.setText(str);
+          m_valueTextSize = metrics.size(Qt::TextSingleLine, str);
+          m_valueTextAscent = metrics.ascent();
+        }
+}
+
+/** Box around the value string, in scale coordinates. */
+QRectF ManoMeter::valueTextRect() const
+{
+        return QRectF(m_valueTextSize.width() / -2.0,
+                      static_cast<int>( 0 - valueOffset()) - m_valueTextAscent,
+                      m_valueTextSize.width(), m_valueTextSize.height());
+}
+
+/** Only the needle and the value string change with the value. */
+QRegion ManoMeter::valueRegion()
+{
+        QRegion region(needleRect(needleAngle(value())));
+        if (valueOffset())
+        {
+          updateValueText();
+          region += coordinateTransform().mapRect(valueTextRect()).toAlignedRect().adjusted(-2,-2,2,2);
+        }
+        return region;
 }
 
 void ManoMeter::paintBackground(QPainter & painter)
@@ -172,42 +302,31 @@ void ManoMeter::paintEvent(QPaintEvent * )
 {
 	drawBackground();
 	QPainter painter(this);
-        initCoordinateSystem(painter);
-      // --------------------------------------------- ///
-	static const int hand[12] = {-4, 0, -1, 129, 1, 129, 4, 0, 8,-50, -8,-50};
-
-
-        QPainterPath hand_path;
-        hand_path.moveTo(QPointF(hand[0],hand[1]));
-
-        for (int i=2;i<10;i+=2)
-	 hand_path.lineTo(hand[i],hand[i+1]);
-
-	hand_path.cubicTo ( 8.1,-51.0, 5.0,-48.0,   0.0,-48.0);
-	hand_path.cubicTo(  -5.0,-48.0, -8.1,-51.0, -8.0,-50.0);
 
         // Rysowanie wskazwki
-	painter.save();
-	painter.rotate(60.0);
-	painter.setPen(Qt::NoPen);
-	painter.setBrush(QBrush(Qt::black));
-   	painter.rotate(  ((  value()-m_min) * 240.0) / static_cast<double> (m_max - m_min) );
-
-	painter.drawPath(hand_path);
-
-	painter.drawEllipse(-10,-10,20,20);
-
-
-        painter.restore();// Przywrocenie do wychylenia o 60 stopni
+        int angle = needleAngle(value());
+        const NeedleSprite * sprite = needleSprite(angle);
+        if (sprite)
+          painter.drawPixmap(sprite->position, sprite->pixmap);
+        else
+        {
+          painter.save();
+          painter.setRenderHint(QPainter::Antialiasing);
+          painter.setTransform(needleTransform(angle));
+          painter.setPen(Qt::NoPen);
+          painter.setBrush(QBrush(Qt::black));
+          painter.drawPath(m_handPath);
+          painter.drawEllipse(-10,-10,20,20);
+          painter.restore();
+        }
 
 	// Rysowanie wywietlanej wartoci
         if (valueOffset())
         {
-
+          initCoordinateSystem(painter);
+          updateValueText();
 	  if (value() >= critical() ) painter.setPen(Qt::red);
 	  painter.setFont(valueFont());
-          QString Str = prefix() + QString("%1").arg(value()) + suffix();
-          QSize Size = painter.fontMetrics().size(Qt::TextSingleLine, Str);
-          painter.drawText( QPointF( Size.width() / -2.0,static_cast<int>( 0 - valueOffset())) , Str);
+          painter.drawStaticText(valueTextRect().topLeft(), m_valueText);
         }
 }// paintEvent
@@ -23,6 +23,11 @@
 #ifndef BARMETER_H
 #define BARMETER_H
 
+#include <QCache>
+#include <QPainterPath>
+#include <QPixmap>
+#include <QStaticText>
+#include <QTransform>
 #include "abstractmeter.h"
 
 class ManoMeter : public AbstractMeter
@@ -34,5 +39,35 @@ class ManoMeter : public AbstractMeter
     void paintEvent(QPaintEvent *event); 	 // inherited from WidgetWithBackground 
     void paintBackground(QPainter & painter);// inherited form WidgetWithBackground 
     void initCoordinateSystem(QPainter & painter);
+    QRegion valueRegion();                   // inherited from AbstractMeter
+
+  private:
+    /** Needle rendered at one angle, and where it goes on the widget */
+    struct NeedleSprite
+    {
+      QPixmap pixmap;
+      QPoint position;
+    };
+
+    QTransform coordinateTransform() const;
+    int needleAngle(double value) const;
+    QTransform needleTransform(int angle) const;
+    QRect needleRect(int angle) const;
+    const NeedleSprite * needleSprite(int angle);
+    void updateValueText();
+    QRectF valueTextRect() const;
+
+    /** Outline of the needle, built once */
+    QPainterPath m_handPath;
+    /** Rendered needles by angle (in tenths of a degree) at the current size */
+    QCache<int, NeedleSprite> m_needleCache;
+    QSize m_needleCacheSize;
+
+    /** Value string laid out for drawing, and the font it was laid out in */
+    QString m_valueString;
+    QFont m_valueStringFont;
+    QStaticText m_valueText;
+    QSize m_valueTextSize;
+    int m_valueTextAscent;
 };
 #endif // BARMETER_H
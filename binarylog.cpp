@@ -0,0 +1,802 @@
+#include <QDataStream>
+#include <QFileInfo>
+#include <QtEndian>
+#include <string.h>
+#include "binarylog.h"
+
+namespace
+{
+// Largest encoding of a single record: a mask and, for each of up to 32
+// channels, at most a ten-byte variable-length integer
+const int s_maxEncodedRecordSize = 4 + (32 * 10);
+
+quint64 zigzag(qint64 v)
+{
+  return ((quint64)v << 1) ^ (quint64)(v >> 63);
+}
+
+qint64 unzigzag(quint64 v)
+{
+  return (qint64)(v >> 1) ^ -(qint64)(v & 1);
+}
+
+/**
+ * Writes an unsigned integer seven bits at a time, least significant first,
+ * with the top bit of each byte set if more bytes follow.
+ * @return Pointer to the byte after the last one written
+ */
+uchar* putVarint(uchar* p, quint64 v)
+{
+  while (v >= 0x80)
+  {
+    *p++ = (uchar)(v | 0x80);
+    v >>= 7;
+  }
+  *p++ = (uchar)v;
+  return p;
+}
+
+/**
+ * Reads an integer written by putVarint().
+ * @return False if the data ends before the integer does
+ */
+bool getVarint(const uchar*& p, const uchar* end, quint64& v)
+{
+  v = 0;
+
+  for (int shift = 0; (p < end) && (shift < 64); shift += 7)
+  {
+    const uchar b = *p++;
+    v |= (quint64)(b & 0x7F) << shift;
+
+    if ((b & 0x80) == 0)
+    {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+/**
+ * Converts a channel value to the raw integer that's stored for it.
+ */
+qint64 rawValue(const LogChannel& c, double value)
+{
+  const qint64 raw = qRound64(value / c.scale);
+  return (c.type == LogChannelType_Int16) ? qBound((qint64)-32768, raw, (qint64)32767) : raw;
+}
+
+uchar* putFloat(uchar* p, float f)
+{
+  quint32 bits;
+  memcpy(&bits, &f, sizeof(bits));
+  qToLittleEndian<quint32>(bits, p);
+  return p + 4;
+}
+
+float getFloat(const uchar* p)
+{
+  const quint32 bits = qFromLittleEndian<quint32>(p);
+  float f;
+  memcpy(&f, &bits, sizeof(f));
+  return f;
+}
+}
+
+/**
+ * Constructor.
+ */
+BinaryLogWriter::BinaryLogWriter() :
+  m_timeChannel(0),
+  m_recordSize(0),
+  m_bufferedRecords(0),
+  m_ok(false),
+  m_changesOnly(false),
+  m_followerMask(0),
+  m_chunkStartUs(0)
+{
+}
+
+/**
+ * Destructor. Writes out any buffered records.
+ */
+BinaryLogWriter::~BinaryLogWriter()
+{
+  close();
+}
+
+/**
+ * Opens a binary log for appending, creating it if necessary, and writes a
+ * header chunk describing the channels.
+ * @param fileName Path of the log file
+ * @param epoch Wall-clock time that corresponds to zero on the sample clock
+ * @param timeChannel Index of the channel that holds the sample time
+ * @param channels Descriptions of the channels in each record
+ * @param changesOnly True to write only the channels that have changed in
+ *  each record; false to write every channel of every record
+ * @return True if the log was opened and the header written; false otherwise
+ */
+bool BinaryLogWriter::open(QString fileName, const QDateTime& epoch, int timeChannel,
+                           const QVector<LogChannel>& channels, bool changesOnly)
+{
+  const bool alreadyExists = QFileInfo(fileName).exists() && (QFileInfo(fileName).size() > 0);
+
+  close();
+
+  // the channel mask of a delta record has room for 32 channels
+  if (changesOnly && (channels.size() > 32))
+  {
+    return false;
+  }
+
+  m_file.setFileName(fileName);
+
+  if (!m_file.open(QFile::WriteOnly | QFile::Append))
+  {
+    return false;
+  }
+
+  m_ok = true;
+  m_channels = channels;
+  m_timeChannel = timeChannel;
+  m_changesOnly = changesOnly;
+  m_recordSize = 0;
+  m_followerMask = 0;
+
+  for (int idx = 0; idx < m_channels.size(); idx++)
+  {
+    const LogChannel& c = m_channels.at(idx);
+    m_recordSize += LogChannels::typeSize(c.type);
+
+    // time channels are written along with their readings rather than
+    // being compared on their own
+    if ((c.timeChannel >= 0) && (c.timeChannel < 32))
+    {
+      m_followerMask |= (1u << c.timeChannel);
+    }
+  }
+
+  m_lastValues.fill(0.0, m_channels.size());
+  m_lastRaw.fill(0, m_channels.size());
+  m_buffer.reserve(s_recordsPerChunk * (m_changesOnly ? s_maxEncodedRecordSize : m_recordSize));
+  m_buffer.resize(0);
+  m_bufferedRecords = 0;
+
+  if (!alreadyExists)
+  {
+    uchar preamble[6];
+    qToLittleEndian<quint32>(BinaryLog::s_magic, preamble);
+    qToLittleEndian<quint16>(BinaryLog::s_version, preamble + 4);
+    m_ok = (m_file.write((const char*)preamble, sizeof(preamble)) == sizeof(preamble));
+  }
+
+  QByteArray header;
+  QDataStream out(&header, QIODevice::WriteOnly);
+  out.setByteOrder(QDataStream::LittleEndian);
+  out.setFloatingPointPrecision(QDataStream::DoublePrecision);
+
+  out << (qint64)epoch.toMSecsSinceEpoch() << (quint16)timeChannel << (quint16)m_channels.size();
+  foreach(const LogChannel& c, m_channels)
+  {
+    const QByteArray name = c.name.toUtf8();
+    const QByteArray units = c.units.toUtf8();
+
+    out << (quint8)name.size();
+    out.writeRawData(name.constData(), name.size());
+    out << (quint8)units.size();
+    out.writeRawData(units.constData(), units.size());
+    out << (quint8)c.type << c.scale;
+  }
+
+  m_ok = m_ok && writeChunk(BinaryLog::ChunkType_Header, header);
+
+  return m_ok;
+}
+
+/**
+ * Writes out any buffered records and closes the log.
+ */
+void BinaryLogWriter::close()
+{
+  if (m_file.isOpen())
+  {
+    flush();
+    m_file.close();
+  }
+}
+
+bool BinaryLogWriter::isOpen() const
+{
+  return m_file.isOpen();
+}
+
+/**
+ * Returns the size of the log, including records that are still buffered.
+ */
+qint64 BinaryLogWriter::size() const
+{
+  return m_file.size() + m_buffer.size() + (m_bufferedRecords ? BinaryLog::s_chunkPrefixSize : 0);
+}
+
+/**
+ * Writes a chunk with the given type and payload.
+ */
+bool BinaryLogWriter::writeChunk(BinaryLog::ChunkType type, const QByteArray& payload)
+{
+  uchar prefix[BinaryLog::s_chunkPrefixSize];
+  prefix[0] = (uchar)type;
+  qToLittleEndian<quint32>(payload.size(), prefix + 1);
+
+  return (m_file.write((const char*)prefix, sizeof(prefix)) == sizeof(prefix)) &&
+         (m_file.write(payload) == payload.size());
+}
+
+/**
+ * Writes any buffered records out as a chunk. In change-only mode, the next
+ * record written will be a keyframe.
+ * @return False if a write has failed since the log was opened
+ */
+bool BinaryLogWriter::flush()
+{
+  if (m_file.isOpen() && (m_bufferedRecords > 0))
+  {
+    m_ok = writeChunk(m_changesOnly ? BinaryLog::ChunkType_DeltaRecords : BinaryLog::ChunkType_Records,
+                      m_buffer) && m_ok;
+    m_ok = m_file.flush() && m_ok;
+    m_buffer.resize(0);
+    m_bufferedRecords = 0;
+  }
+
+  return m_ok;
+}
+
+/**
+ * Appends a fixed-width record to the buffer.
+ */
+void BinaryLogWriter::encodeRecord(const LogRecord& record)
+{
+  const int offset = m_buffer.size();
+  m_buffer.resize(offset + m_recordSize);
+  uchar* p = (uchar*)m_buffer.data() + offset;
+
+  for (int idx = 0; idx < m_channels.size(); idx++)
+  {
+    const LogChannel& c = m_channels.at(idx);
+
+    switch (c.type)
+    {
+    case LogChannelType_Int16:
+      qToLittleEndian<qint16>((qint16)rawValue(c, record.values[idx]), p);
+      p += 2;
+      break;
+    case LogChannelType_Int32:
+      qToLittleEndian<qint32>((qint32)rawValue(c, record.values[idx]), p);
+      p += 4;
+      break;
+    case LogChannelType_Int64:
+      qToLittleEndian<qint64>(rawValue(c, record.values[idx]), p);
+      p += 8;
+      break;
+    case LogChannelType_Float32:
+      p = putFloat(p, (float)(record.values[idx] / c.scale));
+      break;
+    }
+  }
+}
+
+/**
+ * Appends a change-only record to the buffer. The first record of a chunk
+ * holds every channel.
+ */
+void BinaryLogWriter::encodeDeltaRecord(const LogRecord& record)
+{
+  uchar encoded[s_maxEncodedRecordSize];
+  uchar* p = encoded + 4;
+  quint32 mask = 0;
+
+  if (m_bufferedRecords == 0)
+  {
+    mask = (m_channels.size() < 32) ? ((1u << m_channels.size()) - 1) : 0xFFFFFFFF;
+    m_lastRaw.fill(0);
+    m_chunkStartUs = (qint64)record.values[m_timeChannel];
+  }
+  else
+  {
+    for (int idx = 0; idx < m_channels.size(); idx++)
+    {
+      const LogChannel& c = m_channels.at(idx);
+
+      if (!(m_followerMask & (1u << idx)) &&
+          ((c.deadband < 0.0) || (qAbs(record.values[idx] - m_lastValues[idx]) > c.deadband)))
+      {
+        mask |= (1u << idx);
+        if (c.timeChannel >= 0)
+        {
+          mask |= (1u << c.timeChannel);
+        }
+      }
+    }
+  }
+
+  qToLittleEndian<quint32>(mask, encoded);
+
+  for (int idx = 0; idx < m_channels.size(); idx++)
+  {
+    if (mask & (1u << idx))
+    {
+      const LogChannel& c = m_channels.at(idx);
+
+      if (c.type == LogChannelType_Float32)
+      {
+        p = putFloat(p, (float)(record.values[idx] / c.scale));
+      }
+      else
+      {
+        const qint64 raw = rawValue(c, record.values[idx]);
+        p = putVarint(p, zigzag(raw - m_lastRaw[idx]));
+        m_lastRaw[idx] = raw;
+      }
+
+      m_lastValues[idx] = record.values[idx];
+    }
+  }
+
+  m_buffer.append((const char*)encoded, p - encoded);
+}
+
+/**
+ * Encodes a record into the buffer, writing the buffer out when it's full.
+ * @return False if a write has failed since the log was opened
+ */
+bool BinaryLogWriter::write(const LogRecord& record)
+{
+  if (!m_file.isOpen())
+  {
+    return false;
+  }
+
+  if (m_changesOnly)
+  {
+    encodeDeltaRecord(record);
+  }
+  else
+  {
+    encodeRecord(record);
+  }
+
+  m_bufferedRecords++;
+  if ((m_bufferedRecords == s_recordsPerChunk) ||
+      (m_changesOnly && ((qint64)record.values[m_timeChannel] - m_chunkStartUs >= s_maxKeyframeIntervalUs)))
+  {
+    flush();
+  }
+
+  return m_ok;
+}
+
+/**
+ * Constructor.
+ */
+BinaryLogReader::BinaryLogReader() :
+  m_data(0),
+  m_size(0),
+  m_pos(0),
+  m_mapped(false),
+  m_timeChannel(0),
+  m_recordSize(0),
+  m_chunkPos(0),
+  m_chunkIsDelta(false),
+  m_chunkOffset(0),
+  m_headerOffset(0),
+  m_headerCount(0)
+{
+}
+
+BinaryLogReader::~BinaryLogReader()
+{
+  close();
+}
+
+/**
+ * Opens a binary log and reads its first header.
+ * @return True if the file is a binary log; false otherwise
+ */
+bool BinaryLogReader::open(QString fileName)
+{
+  close();
+  m_file.setFileName(fileName);
+
+  if (!m_file.open(QFile::ReadOnly))
+  {
+    m_errorString = m_file.errorString();
+    return false;
+  }
+
+  m_size = m_file.size();
+  m_data = (m_size > 0) ? m_file.map(0, m_size) : 0;
+  m_mapped = (m_data != 0);
+
+  if (!m_mapped)
+  {
+    m_fileData = m_file.readAll();
+    m_data = (const uchar*)m_fileData.constData();
+    m_size = m_fileData.size();
+  }
+
+  if ((m_size < 6) || (qFromLittleEndian<quint32>(m_data) != BinaryLog::s_magic))
+  {
+    m_errorString = "Not a RoverGauge binary log.";
+    return false;
+  }
+
+  if (qFromLittleEndian<quint16>(m_data + 4) != BinaryLog::s_version)
+  {
+    m_errorString = "Unsupported binary log version.";
+    return false;
+  }
+
+  m_pos = 6;
+
+  // the first chunk must be a header
+  if (!readChunk() || m_channels.isEmpty())
+  {
+    m_errorString = "Binary log has no valid header.";
+    return false;
+  }
+
+  return true;
+}
+
+void BinaryLogReader::close()
+{
+  m_chunk.clear();
+
+  if (m_mapped)
+  {
+    m_file.unmap((uchar*)m_data);
+  }
+  m_file.close();
+  m_fileData.clear();
+  m_data = 0;
+  m_size = 0;
+  m_pos = 0;
+  m_mapped = false;
+
+  m_channels.clear();
+  m_chunkPos = 0;
+  m_chunkIsDelta = false;
+  m_chunkOffset = 0;
+  m_headerOffset = 0;
+  m_recordSize = 0;
+  m_headerCount = 0;
+}
+
+/**
+ * Positions the reader at the start of a chunk, so that the next record read
+ * is the first in that chunk.
+ * @param headerOffset Offset of the header chunk that describes the chunk
+ * @param chunkOffset Offset of the records chunk
+ * @return True on success; false if there's no valid header at the offset
+ */
+bool BinaryLogReader::seekToChunk(qint64 headerOffset, qint64 chunkOffset)
+{
+  if ((headerOffset < 6) || (headerOffset >= m_size) || (m_data[headerOffset] != BinaryLog::ChunkType_Header))
+  {
+    return false;
+  }
+
+  m_pos = headerOffset;
+  if (!readChunk())
+  {
+    return false;
+  }
+
+  m_pos = chunkOffset;
+  m_chunk.clear();
+  m_chunkPos = 0;
+  m_chunkIsDelta = false;
+  return true;
+}
+
+/**
+ * Parses the payload of a header chunk.
+ */
+bool BinaryLogReader::parseHeader(const QByteArray& payload)
+{
+  QDataStream in(payload);
+  in.setByteOrder(QDataStream::LittleEndian);
+  in.setFloatingPointPrecision(QDataStream::DoublePrecision);
+
+  qint64 epochMs = 0;
+  quint16 timeChannel = 0;
+  quint16 count = 0;
+  QVector<LogChannel> channels;
+  int recordSize = 0;
+
+  in >> epochMs >> timeChannel >> count;
+
+  for (int idx = 0; (idx < count) && (in.status() == QDataStream::Ok); idx++)
+  {
+    LogChannel c;
+    quint8 len = 0;
+    quint8 type = 0;
+    QByteArray text;
+
+    in >> len;
+    text.resize(len);
+    in.readRawData(text.data(), len);
+    c.name = QString::fromUtf8(text);
+
+    in >> len;
+    text.resize(len);
+    in.readRawData(text.data(), len);
+    c.units = QString::fromUtf8(text);
+
+    in >> type >> c.scale;
+    c.type = (LogChannelType)type;
+    c.deadband = 0.0;
+    c.timeChannel = -1;
+
+    if (type > LogChannelType_Float32)
+    {
+      in.setStatus(QDataStream::ReadCorruptData);
+    }
+
+    recordSize += LogChannels::typeSize(c.type);
+    channels.append(c);
+  }
+
+  if ((in.status() != QDataStream::Ok) || (timeChannel >= count))
+  {
+    return false;
+  }
+
+  m_epoch = QDateTime::fromMSecsSinceEpoch(epochMs);
+  m_timeChannel = timeChannel;
+  m_channels = channels;
+  m_recordSize = recordSize;
+  m_values.fill(0.0, count);
+  m_lastRaw.fill(0, count);
+  m_headerCount++;
+  return true;
+}
+
+/**
+ * Reads the next chunk from the file. Header chunks are applied immediately;
+ * a records chunk becomes the source of subsequent records.
+ * @return False at the end of the file, or if the file is truncated or corrupt
+ */
+bool BinaryLogReader::readChunk()
+{
+  if (m_size - m_pos < BinaryLog::s_chunkPrefixSize)
+  {
+    return false;
+  }
+
+  const uchar* prefix = m_data + m_pos;
+  const quint32 length = qFromLittleEndian<quint32>(prefix + 1);
+
+  if (m_size - m_pos - BinaryLog::s_chunkPrefixSize < (qint64)length)
+  {
+    return false;
+  }
+
+  const qint64 offset = m_pos;
+  const QByteArray payload =
+    QByteArray::fromRawData((const char*)prefix + BinaryLog::s_chunkPrefixSize, length);
+  m_pos += BinaryLog::s_chunkPrefixSize + length;
+
+  bool status = true;
+
+  if (prefix[0] == BinaryLog::ChunkType_Header)
+  {
+    status = parseHeader(payload);
+    m_headerOffset = offset;
+    m_chunk.clear();
+    m_chunkPos = 0;
+  }
+  else if ((prefix[0] == BinaryLog::ChunkType_Records) ||
+           (prefix[0] == BinaryLog::ChunkType_DeltaRecords))
+  {
+    m_chunk = payload;
+    m_chunkPos = 0;
+    m_chunkOffset = offset;
+    m_chunkIsDelta = (prefix[0] == BinaryLog::ChunkType_DeltaRecords);
+    m_lastRaw.fill(0);
+  }
+
+  // chunks of unknown types are skipped
+
+  return status;
+}
+
+/**
+ * Decodes the fixed-width record at the current position in the chunk.
+ */
+void BinaryLogReader::decodeRecord()
+{
+  const uchar* p = (const uchar*)m_chunk.constData() + m_chunkPos;
+
+  for (int idx = 0; idx < m_channels.size(); idx++)
+  {
+    const LogChannel& c = m_channels.at(idx);
+
+    switch (c.type)
+    {
+    case LogChannelType_Int16:
+      m_values[idx] = qFromLittleEndian<qint16>(p) * c.scale;
+      p += 2;
+      break;
+    case LogChannelType_Int32:
+      m_values[idx] = qFromLittleEndian<qint32>(p) * c.scale;
+      p += 4;
+      break;
+    case LogChannelType_Int64:
+      m_values[idx] = qFromLittleEndian<qint64>(p) * c.scale;
+      p += 8;
+      break;
+    case LogChannelType_Float32:
+      m_values[idx] = getFloat(p) * c.scale;
+      p += 4;
+      break;
+    }
+  }
+
+  m_chunkPos += m_recordSize;
+}
+
+/**
+ * Decodes the change-only record at the current position in the chunk,
+ * updating the channels that it holds.
+ * @return False if the record is truncated or corrupt
+ */
+bool BinaryLogReader::decodeDeltaRecord()
+{
+  const uchar* p = (const uchar*)m_chunk.constData() + m_chunkPos;
+  const uchar* end = (const uchar*)m_chunk.constData() + m_chunk.size();
+
+  if (end - p < 4)
+  {
+    return false;
+  }
+
+  const quint32 mask = qFromLittleEndian<quint32>(p);
+  p += 4;
+
+  if ((m_channels.size() < 32) && (mask >> m_channels.size()))
+  {
+    return false;
+  }
+
+  for (int idx = 0; idx < m_channels.size(); idx++)
+  {
+    if (mask & (1u << idx))
+    {
+      const LogChannel& c = m_channels.at(idx);
+
+      if (c.type == LogChannelType_Float32)
+      {
+        if (end - p < 4)
+        {
+          return false;
+        }
+        m_values[idx] = getFloat(p) * c.scale;
+        p += 4;
+      }
+      else
+      {
+        quint64 v = 0;
+        if (!getVarint(p, end, v))
+        {
+          return false;
+        }
+        m_lastRaw[idx] += unzigzag(v);
+        m_values[idx] = m_lastRaw[idx] * c.scale;
+      }
+    }
+  }
+
+  m_chunkPos = p - (const uchar*)m_chunk.constData();
+  return true;
+}
+
+/**
+ * Reads the next record from the log.
+ * @param values Populated with the value of each channel, in the order given
+ *  by channels() (which may change if the log contains more than one header)
+ * @return True if a record was read; false at the end of the log
+ */
+bool BinaryLogReader::readRecord(QVector<double>& values)
+{
+  forever
+  {
+    if (m_chunkIsDelta && (m_chunkPos < m_chunk.size()))
+    {
+      if (decodeDeltaRecord())
+      {
+        break;
+      }
+
+      // the rest of a corrupt chunk is skipped
+      m_chunkPos = m_chunk.size();
+    }
+    else if (!m_chunkIsDelta && (m_recordSize > 0) && (m_chunkPos + m_recordSize <= m_chunk.size()))
+    {
+      decodeRecord();
+      break;
+    }
+    else if (!readChunk())
+    {
+      return false;
+    }
+  }
+
+  values = m_values;
+  return true;
+}
+
+/**
+ * Converts a binary log to the CSV layout written by the text logger.
+ * @param binaryFileName Path of the binary log to read
+ * @param csvFileName Path of the CSV file to write
+ * @param errorString Set to a description of the problem on failure
+ * @return True on success; false otherwise
+ */
+bool BinaryLogReader::convertToCsv(QString binaryFileName, QString csvFileName, QString& errorString)
+{
+  BinaryLogReader reader;
+
+  if (!reader.open(binaryFileName))
+  {
+    errorString = reader.errorString();
+    return false;
+  }
+
+  QFile csvFile(csvFileName);
+  if (!csvFile.open(QFile::WriteOnly | QFile::Truncate))
+  {
+    errorString = csvFile.errorString();
+    return false;
+  }
+
+  QTextStream out(&csvFile);
+  QVector<double> values;
+  const int firstHeader = reader.headerCount();
+  QVector<LogChannel> channels = reader.channels();
+
+  LogChannels::writeCsvHeader(out, channels);
+
+  while (reader.readRecord(values))
+  {
+    // every session appended to the log must share the same columns
+    if (reader.headerCount() != firstHeader)
+    {
+      if (reader.channels().size() != channels.size())
+      {
+        errorString = "The sessions in the binary log have different channels.";
+        return false;
+      }
+
+      for (int idx = 0; idx < channels.size(); idx++)
+      {
+        if (reader.channels().at(idx).name != channels.at(idx).name)
+        {
+          errorString = "The sessions in the binary log have different channels.";
+          return false;
+        }
+      }
+    }
+
+    LogChannels::writeCsvRow(out, reader.epoch(), reader.timeChannel(), reader.channels(), values.constData());
+  }
+
+  out.flush();
+  if (out.status() != QTextStream::Ok)
+  {
+    errorString = csvFile.errorString();
+    return false;
+  }
+
+  return true;
+}
@@ -0,0 +1,180 @@
+#ifndef BINARYLOG_H
+#define BINARYLOG_H
+
+#include <QFile>
+#include <QString>
+#include <QVector>
+#include <QByteArray>
+#include <QDateTime>
+#include "logchannels.h"
+
+/**
+ * Layout of the binary data log.
+ *
+ * The file begins with a magic number and format version, followed by a
+ * sequence of chunks. Each chunk is a one-byte type and a four-byte payload
+ * length, followed by the payload. A header chunk describes the channels
+ * (name, units, storage type and scale), the index of the channel that holds
+ * the sample time, and the wall-clock time that corresponds to zero on the
+ * sample clock. Each records chunk holds one or more fixed-width records laid
+ * out according to the most recent header. A new header is written each time
+ * the log is reopened, so sessions may be appended to an existing file.
+ *
+ * Change-only logs use delta chunks instead of records chunks. Each record in
+ * a delta chunk starts with a 32-bit mask of the channels that it holds;
+ * floating-point values follow as in a fixed-width record, and integer values
+ * as zigzag-encoded variable-length differences from the previous value of
+ * the channel in the same chunk. Channels that are absent keep their previous
+ * values. The first record of every delta chunk holds all channels (with
+ * differences taken from zero), so decoding can begin at any chunk.
+ *
+ * All values are little-endian.
+ */
+namespace BinaryLog
+{
+  const quint32 s_magic = 0x4C475252; // "RRGL"
+  const quint16 s_version = 1;
+
+  enum ChunkType
+  {
+    ChunkType_Header = 1,
+    ChunkType_Records = 2,
+    ChunkType_DeltaRecords = 3
+  };
+
+  const int s_chunkPrefixSize = 5;
+}
+
+/**
+ * Writes the binary data log. Records are encoded into a buffer and written
+ * out a chunk at a time. In change-only mode, a channel is written only when
+ * it has moved by more than its deadband, and chunks are closed often enough
+ * that a full keyframe appears at least every few seconds of sample time.
+ */
+class BinaryLogWriter
+{
+public:
+  BinaryLogWriter();
+  ~BinaryLogWriter();
+
+  bool open(QString fileName, const QDateTime& epoch, int timeChannel,
+            const QVector<LogChannel>& channels, bool changesOnly = false);
+  void close();
+  bool isOpen() const;
+  qint64 size() const;
+  bool write(const LogRecord& record);
+  bool flush();
+
+private:
+  // Number of records gathered into each records chunk
+  static const int s_recordsPerChunk = 256;
+
+  // Longest span of sample time covered by a delta chunk, which bounds the
+  // distance between keyframes
+  static const qint64 s_maxKeyframeIntervalUs = 5000000;
+
+  QFile m_file;
+  QVector<LogChannel> m_channels;
+  int m_timeChannel;
+  int m_recordSize;
+  int m_bufferedRecords;
+  QByteArray m_buffer;
+  bool m_ok;
+
+  bool m_changesOnly;
+  quint32 m_followerMask;
+  qint64 m_chunkStartUs;
+  QVector<double> m_lastValues;
+  QVector<qint64> m_lastRaw;
+
+  bool writeChunk(BinaryLog::ChunkType type, const QByteArray& payload);
+  void encodeRecord(const LogRecord& record);
+  void encodeDeltaRecord(const LogRecord& record);
+};
+
+/**
+ * Reads a binary data log written by BinaryLogWriter. The file is mapped into
+ * memory (or read in whole if it can't be mapped), so chunks are decoded in
+ * place without copying.
+ */
+class BinaryLogReader
+{
+public:
+  BinaryLogReader();
+  ~BinaryLogReader();
+
+  bool open(QString fileName);
+  void close();
+
+  QString errorString() const
+  {
+    return m_errorString;
+  }
+
+  const QVector<LogChannel>& channels() const
+  {
+    return m_channels;
+  }
+
+  QDateTime epoch() const
+  {
+    return m_epoch;
+  }
+
+  int timeChannel() const
+  {
+    return m_timeChannel;
+  }
+
+  // Number of headers read so far; changes when a new session begins
+  int headerCount() const
+  {
+    return m_headerCount;
+  }
+
+  // Offsets of the chunk holding the last record read, and of the header
+  // that describes it; together these allow reading to resume at that chunk
+  qint64 chunkOffset() const
+  {
+    return m_chunkOffset;
+  }
+
+  qint64 headerOffset() const
+  {
+    return m_headerOffset;
+  }
+
+  bool readRecord(QVector<double>& values);
+  bool seekToChunk(qint64 headerOffset, qint64 chunkOffset);
+
+  static bool convertToCsv(QString binaryFileName, QString csvFileName, QString& errorString);
+
+private:
+  QFile m_file;
+  const uchar* m_data;
+  qint64 m_size;
+  qint64 m_pos;
+  bool m_mapped;
+  QByteArray m_fileData;
+
+  QVector<LogChannel> m_channels;
+  QDateTime m_epoch;
+  int m_timeChannel;
+  int m_recordSize;
+  QByteArray m_chunk;
+  int m_chunkPos;
+  bool m_chunkIsDelta;
+  qint64 m_chunkOffset;
+  qint64 m_headerOffset;
+  QVector<double> m_values;
+  QVector<qint64> m_lastRaw;
+  int m_headerCount;
+  QString m_errorString;
+
+  bool readChunk();
+  bool parseHeader(const QByteArray& payload);
+  void decodeRecord();
+  bool decodeDeltaRecord();
+};
+
+#endif // BINARYLOG_H
@@ -0,0 +1,196 @@
+#include <string.h>
+#include "comm14cuxtransport.h"
+
+/**
+ * Constructor.
+ */
+Comm14CUXTransport::Comm14CUXTransport()
+{
+  memset(&m_cuxinfo, 0, sizeof(m_cuxinfo));
+}
+
+/**
+ * Initializes the library's state. This should be called from the thread that
+ * will use the transport.
+ */
+void Comm14CUXTransport::init()
+{
+  c14cux_init(&m_cuxinfo);
+}
+
+/**
+ * Opens the serial device connected to the 14CUX.
+ * @param device Name of (or path to) the serial device
+ * @param baud Baud rate to use on the serial link
+ * @return True if the device was opened successfully; false otherwise
+ */
+bool Comm14CUXTransport::connect(QString device, unsigned int baud)
+{
+  return c14cux_connect(&m_cuxinfo, device.toStdString().c_str(), baud);
+}
+
+/**
+ * Closes the serial device.
+ */
+void Comm14CUXTransport::disconnect()
+{
+  c14cux_disconnect(&m_cuxinfo);
+}
+
+/**
+ * Indicates whether the serial device is open.
+ */
+bool Comm14CUXTransport::isConnected()
+{
+  return c14cux_isConnected(&m_cuxinfo);
+}
+
+/**
+ * Cancels the read operation in progress (if any.) May be called from any thread.
+ */
+void Comm14CUXTransport::cancelRead()
+{
+  c14cux_cancelRead(&m_cuxinfo);
+}
+
+/**
+ * Discards the information that the library has cached about the connected
+ * ECU (PROM revision and voltage conversion factors), so that it's determined
+ * again after reconnecting.
+ */
+void Comm14CUXTransport::resetState()
+{
+  m_cuxinfo.promRev = C14CUX_DataOffsets_Unset;
+  m_cuxinfo.voltageFactorA = 0;
+  m_cuxinfo.voltageFactorB = 0;
+  m_cuxinfo.voltageFactorC = 0;
+}
+
+/**
+ * Performs an operation by calling the corresponding libcomm14cux function.
+ */
+bool Comm14CUXTransport::call(const EcuRequest& request, uint8_t* result, unsigned int resultSize)
+{
+  bool status = false;
+
+  Q_UNUSED(resultSize);
+
+  switch (request.op)
+  {
+  case EcuOp_ReadMem:
+    status = c14cux_readMem(&m_cuxinfo, request.args[0], request.args[1], result);
+    break;
+
+  case EcuOp_WriteMem:
+    status = c14cux_writeMem(&m_cuxinfo, request.args[0], (uint8_t)request.args[1]);
+    break;
+
+  case EcuOp_DumpROM:
+    status = c14cux_dumpROM(&m_cuxinfo, result);
+    break;
+
+  case EcuOp_GetFaultCodes:
+    status = c14cux_getFaultCodes(&m_cuxinfo, (c14cux_faultcodes*)result);
+    break;
+
+  case EcuOp_ClearFaultCodes:
+    status = c14cux_clearFaultCodes(&m_cuxinfo);
+    break;
+
+  case EcuOp_GetFuelMap:
+    {
+      EcuFuelMapResult* map = (EcuFuelMapResult*)result;
+      status = c14cux_getFuelMap(&m_cuxinfo, (int8_t)request.args[0],
+                                 &map->adjustmentFactor, &map->rowScaler, map->data);
+    }
+    break;
+
+  case EcuOp_GetRpmTable:
+    status = c14cux_getRpmTable(&m_cuxinfo, (c14cux_rpmtable*)result);
+    break;
+
+  case EcuOp_GetTuneRevision:
+    {
+      EcuTuneRevisionResult* rev = (EcuTuneRevisionResult*)result;
+      status = c14cux_getTuneRevision(&m_cuxinfo, &rev->tune, &rev->checksumFixer, &rev->ident);
+    }
+    break;
+
+  case EcuOp_GetRPMLimit:
+    status = c14cux_getRPMLimit(&m_cuxinfo, (uint16_t*)result);
+    break;
+
+  case EcuOp_RunFuelPump:
+    status = c14cux_runFuelPump(&m_cuxinfo);
+    break;
+
+  case EcuOp_DriveIdleAirControlMotor:
+    status = c14cux_driveIdleAirControlMotor(&m_cuxinfo, (uint8_t)request.args[0], (uint8_t)request.args[1]);
+    break;
+
+  case EcuOp_GetMAFReading:
+    status = c14cux_getMAFReading(&m_cuxinfo, (c14cux_airflow_type)request.args[0], (float*)result);
+    break;
+
+  case EcuOp_GetThrottlePosition:
+    status = c14cux_getThrottlePosition(&m_cuxinfo, (c14cux_throttle_pos_type)request.args[0], (float*)result);
+    break;
+
+  case EcuOp_GetLambdaTrimShort:
+    status = c14cux_getLambdaTrimShort(&m_cuxinfo, (c14cux_bank)request.args[0], (int16_t*)result);
+    break;
+
+  case EcuOp_GetLambdaTrimLong:
+    status = c14cux_getLambdaTrimLong(&m_cuxinfo, (c14cux_bank)request.args[0], (int16_t*)result);
+    break;
+
+  case EcuOp_GetIdleBypassMotorPosition:
+    status = c14cux_getIdleBypassMotorPosition(&m_cuxinfo, (float*)result);
+    break;
+
+  case EcuOp_GetMainVoltage:
+    status = c14cux_getMainVoltage(&m_cuxinfo, (float*)result);
+    break;
+
+  case EcuOp_GetTargetIdle:
+    status = c14cux_getTargetIdle(&m_cuxinfo, (uint16_t*)result);
+    break;
+
+  case EcuOp_GetIdleMode:
+    status = c14cux_getIdleMode(&m_cuxinfo, (bool*)result);
+    break;
+
+  case EcuOp_GetFuelPumpRelayState:
+    status = c14cux_getFuelPumpRelayState(&m_cuxinfo, (bool*)result);
+    break;
+
+  case EcuOp_GetGearSelection:
+    status = c14cux_getGearSelection(&m_cuxinfo, (c14cux_gear*)result);
+    break;
+
+  case EcuOp_GetCoolantTemp:
+    status = c14cux_getCoolantTemp(&m_cuxinfo, (int16_t*)result);
+    break;
+
+  case EcuOp_GetFuelTemp:
+    status = c14cux_getFuelTemp(&m_cuxinfo, (int16_t*)result);
+    break;
+
+  case EcuOp_IsMILOn:
+    status = c14cux_isMILOn(&m_cuxinfo, (bool*)result);
+    break;
+
+  case EcuOp_GetCurrentFuelMap:
+    status = c14cux_getCurrentFuelMap(&m_cuxinfo, result);
+    break;
+
+  case EcuOp_GetCOTrimVoltage:
+    status = c14cux_getCOTrimVoltage(&m_cuxinfo, (float*)result);
+    break;
+
+  default:
+    break;
+  }
+
+  return status;
+}
@@ -0,0 +1,28 @@
+#ifndef COMM14CUXTRANSPORT_H
+#define COMM14CUXTRANSPORT_H
+
+#include "ecutransport.h"
+
+/**
+ * Transport that talks to a real 14CUX over a serial device, using
+ * libcomm14cux.
+ */
+class Comm14CUXTransport : public EcuTransport
+{
+public:
+  Comm14CUXTransport();
+
+  void init();
+  bool connect(QString device, unsigned int baud);
+  void disconnect();
+  bool isConnected();
+  void cancelRead();
+  void resetState();
+
+  bool call(const EcuRequest& request, uint8_t* result, unsigned int resultSize);
+
+private:
+  c14cux_info m_cuxinfo;
+};
+
+#endif // COMM14CUXTRANSPORT_H
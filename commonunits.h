@@ -15,6 +15,13 @@ enum TemperatureUnits
   Celsius
 };
 
+enum LogFormat
+{
+  LogFormat_CSV,
+  LogFormat_Binary,
+  LogFormat_BinaryDelta
+};
+
 enum SampleType
 {
   SampleType_EngineTemperature,
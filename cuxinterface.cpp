@@ -1,11 +1,13 @@
 #include <QThread>
-#include <QDateTime>
-#include <QCoreApplication>
+#include <QMutexLocker>
+#include <QVarLengthArray>
 #include <string.h>
 #include "cuxinterface.h"
 
 /**
  * Constructor. Sets the serial device and measurement units.
+ * @param transport Transport used to communicate with the ECU. The interface
+ *  takes ownership of the transport.
  * @param device Name of (or path to) the serial device used to comminucate
  *  with the 14CUX.
  * @param baud Baud rate to use when communicatin with the ECU. Note that
@@ -13,16 +15,20 @@
  * @param sUnits Units to be used when expressing road speed
  * @param tUnits Units to be used when expressing coolant/fuel temperature
  */
-CUXInterface::CUXInterface(QString device, unsigned int baud, SpeedUnits sUnits,
+CUXInterface::CUXInterface(EcuTransport* transport, QString device, unsigned int baud, SpeedUnits sUnits,
                            TemperatureUnits tUnits, bool fuelMapRefresh, QObject* parent) :
   QObject(parent),
   m_deviceName(device),
   m_baudRate(baud),
-  m_stopPolling(false),
-  m_shutdownThread(false),
+  m_transport(transport),
+  m_polling(false),
+  m_pollTimer(0),
   m_batteryBackedMem(0),
   m_readCanceled(false),
   m_readTuneId(false),
+  m_sampleSequence(0),
+  m_sampleSink(0),
+  m_lastResidencyTimeUs(0),
   m_lambdaTrimType(C14CUX_LambdaTrimType_ShortTerm),
   m_feedbackMode(C14CUX_FeedbackMode_ClosedLoop),
   m_airflowType(C14CUX_AirflowType_Linearized),
@@ -51,7 +57,15 @@ CUXInterface::CUXInterface(QString device, unsigned int baud, SpeedUnits sUnits,
   m_idleMode(false),
   m_injectorPulseWidthUs(0),
   m_injectorPulseWidthMs(0.0),
+  m_mafScalerVerified(false),
   m_romImage(0),
+  m_romReadInProgress(false),
+  m_romCacheCheckInProgress(false),
+  m_romChunkFailures(0),
+  m_romReadTuneKey(0),
+  m_fuelMapChangeCount(0),
+  m_rpmTableIsCurrent(false),
+  m_rpmTableVerified(false),
   m_speedUnits(sUnits),
   m_tempUnits(tUnits),
   m_fuelMapRefresh(fuelMapRefresh),
@@ -65,15 +79,56 @@ CUXInterface::CUXInterface(QString device, unsigned int baud, SpeedUnits sUnits,
   {
     m_fuelMaps[idx].fill(0x00, 128);
     m_fuelMapDataIsCurrent[idx] = false;
+    m_fuelMapVerified[idx] = false;
     m_rowScaler[idx] = 0;
   }
 
   memset(&m_rpmTable, 0, sizeof(m_rpmTable));
-
-  for (int type = 0; type < (int)SampleType_NumSampleTypes; type++)
-  {
-    m_lastReadTime.insert((SampleType)type, 0);
-  }
+  memset(m_readTimeUs, 0, sizeof(m_readTimeUs));
+  memset(&m_lastResidencyPosition, 0, sizeof(m_lastResidencyPosition));
+
+  // Smallest change in each reading (in the units returned by
+  // getSampleValue()) that is treated as real movement rather than noise
+  // when read intervals are being adapted. Samples that aren't listed here
+  // are always read at their fixed interval.
+  m_scheduler.setDeadband(SampleType_EngineTemperature, 1.0);
+  m_scheduler.setDeadband(SampleType_RoadSpeed, 1.0);
+  m_scheduler.setDeadband(SampleType_EngineRPM, 50.0);
+  m_scheduler.setDeadband(SampleType_FuelTemperature, 1.0);
+  m_scheduler.setDeadband(SampleType_MAF, 0.01);
+  m_scheduler.setDeadband(SampleType_Throttle, 0.01);
+  m_scheduler.setDeadband(SampleType_IdleBypassPosition, 0.02);
+  m_scheduler.setDeadband(SampleType_TargetIdleRPM, 10.0);
+  m_scheduler.setDeadband(SampleType_GearSelection, 0.5);
+  m_scheduler.setDeadband(SampleType_MainVoltage, 0.1);
+  m_scheduler.setDeadband(SampleType_LambdaTrimShort, 2.0);
+  m_scheduler.setDeadband(SampleType_LambdaTrimLong, 2.0);
+  m_scheduler.setDeadband(SampleType_COTrimVoltage, 0.02);
+  m_scheduler.setDeadband(SampleType_FuelPumpRelay, 0.5);
+  m_scheduler.setDeadband(SampleType_FuelMapRowCol, 2.0);
+  m_scheduler.setDeadband(SampleType_InjectorPulseWidth, 0.1);
+  m_scheduler.setDeadband(SampleType_FuelMapData, 0.5);
+
+  // Each refresh of the fuel map transfers the whole map, and the map rarely
+  // changes, so refreshes back off while it's stable (and speed up again
+  // when it changes) whether or not the other intervals are adaptive.
+  m_scheduler.setAlwaysAdaptive(SampleType_FuelMapData, true);
+
+  // The timer is a child of this object, so it moves to the worker thread
+  // along with the interface and fires in that thread's event loop.
+  m_pollTimer = new QTimer(this);
+  m_pollTimer->setSingleShot(true);
+  m_pollTimer->setTimerType(Qt::PreciseTimer);
+  connect(m_pollTimer, SIGNAL(timeout()), this, SLOT(onPollTimerExpired()));
+
+  // The wall-clock time at which the monotonic clock was started lets
+  // consumers convert sample timestamps to dates without reading the wall
+  // clock (which can jump) for every sample.
+  m_clock.start();
+  m_clockEpoch = QDateTime::currentDateTime();
+
+  // publish an initial snapshot so that readers never see an uninitialized one
+  publishSample();
 }
 
 /**
@@ -81,6 +136,7 @@ CUXInterface::CUXInterface(QString device, unsigned int baud, SpeedUnits sUnits,
  */
 CUXInterface::~CUXInterface()
 {
+  delete m_transport;
 }
 
 /**
@@ -88,11 +144,11 @@ CUXInterface::~CUXInterface()
  */
 void CUXInterface::onFaultCodesRequested()
 {
-  if (m_initComplete && c14cux_isConnected(&m_cuxinfo))
+  if (m_initComplete && m_transport->isConnected())
   {
     memset(&m_faultCodes, 0, sizeof(m_faultCodes));
 
-    if (c14cux_getFaultCodes(&m_cuxinfo, &m_faultCodes))
+    if (m_transport->getFaultCodes(&m_faultCodes))
     {
       emit faultCodesReady();
     }
@@ -112,14 +168,14 @@ void CUXInterface::onFaultCodesRequested()
  */
 void CUXInterface::onBatteryBackedMemRequested()
 {
-  if (m_initComplete && c14cux_isConnected(&m_cuxinfo))
+  if (m_initComplete && m_transport->isConnected())
   {
     if (m_batteryBackedMem == 0)
     {
       m_batteryBackedMem = new QByteArray(21, 0x00);
     }
 
-    if (c14cux_readMem(&m_cuxinfo, 0x0040, 21, (uint8_t*)m_batteryBackedMem->data()))
+    if (m_transport->readMem(0x0040, 21, (uint8_t*)m_batteryBackedMem->data()))
     {
       emit batteryBackedMemReady();
     }
@@ -139,10 +195,10 @@ void CUXInterface::onBatteryBackedMemRequested()
  */
 void CUXInterface::onFaultCodesClearRequested()
 {
-  if (m_initComplete && c14cux_isConnected(&m_cuxinfo))
+  if (m_initComplete && m_transport->isConnected())
   {
-    if (c14cux_clearFaultCodes(&m_cuxinfo) &&
-        c14cux_getFaultCodes(&m_cuxinfo, &m_faultCodes))
+    if (m_transport->clearFaultCodes() &&
+        m_transport->getFaultCodes(&m_faultCodes))
     {
       emit faultCodesClearSuccess(m_faultCodes);
     }
@@ -158,33 +214,36 @@ void CUXInterface::onFaultCodesClearRequested()
 }
 
 /**
- * Reads the entire 16KB ROM.
+ * Reads the entire 16KB ROM, either from the cache or (a chunk at a time,
+ * between polling passes) from the ECU.
  */
 void CUXInterface::onReadROMImageRequested()
 {
-  if (m_initComplete && c14cux_isConnected(&m_cuxinfo))
+  if (m_initComplete && m_transport->isConnected())
   {
     if (m_romImage == 0)
     {
-      m_romImage = new QByteArray(16384, 0x00);
+      m_romImage = new QByteArray(EcuTransport::s_romSize, 0x00);
     }
 
-    if (c14cux_dumpROM(&m_cuxinfo, (uint8_t*)m_romImage->data()))
+    if (m_dataCache.getROMImage().isEmpty())
     {
-      if (!m_readCanceled)
-      {
-        emit romImageReady();
-      }
+      startROMRead();
+    }
+    else if (cachedDataIsVerified())
+    {
+      passOnCachedROMImage();
     }
     else
     {
-      if (!m_readCanceled)
-      {
-        emit romImageReadFailed();
-      }
+      // a cached image is only used once the rest of the data loaded from the
+      // cache has been found to match the ECU; that's checked an item at a
+      // time between polling passes, as the ROM itself would be read
+      m_readCanceled = false;
+      m_romChunkFailures = 0;
+      m_romCacheCheckInProgress = true;
+      m_pollTimer->start(0);
     }
-
-    m_readCanceled = false;
   }
   else
   {
@@ -192,6 +251,159 @@ void CUXInterface::onReadROMImageRequested()
   }
 }
 
+/**
+ * Starts reading the ROM image from the ECU. If an earlier read of the same
+ * tune was canceled or cut short, it's resumed from the chunks that were
+ * already read.
+ */
+void CUXInterface::startROMRead()
+{
+  const quint64 key = tuneKey();
+
+  if (!m_readTuneId || (key != m_romReadTuneKey) || (m_romChunkRead.size() != s_romChunkCount))
+  {
+    m_romReadBuffer.fill(0x00, EcuTransport::s_romSize);
+    m_romChunkRead.fill(false, s_romChunkCount);
+    m_romReadTuneKey = key;
+  }
+
+  m_readCanceled = false;
+  m_romChunkFailures = 0;
+  m_romReadInProgress = true;
+
+  emit romImageProgress(romBytesRead(), EcuTransport::s_romSize);
+
+  // start on the first chunk as soon as the current pass is finished
+  m_pollTimer->start(0);
+}
+
+/**
+ * Reads the next chunk of the ROM image that hasn't been read yet. Called
+ * between polling passes while a read is in progress. A chunk that fails is
+ * retried on the following passes; if it fails repeatedly, the read is
+ * abandoned, but the chunks already read are kept so that it can be resumed.
+ */
+void CUXInterface::readROMChunk()
+{
+  if (m_readCanceled)
+  {
+    m_romReadInProgress = false;
+    m_readCanceled = false;
+    return;
+  }
+
+  int chunk = m_romChunkRead.indexOf(false);
+
+  if (chunk >= 0)
+  {
+    const int offset = chunk * s_romChunkSize;
+
+    if (m_transport->readMem(s_romBaseAddress + offset, s_romChunkSize,
+                             (uint8_t*)m_romReadBuffer.data() + offset))
+    {
+      m_romChunkRead[chunk] = true;
+      m_romChunkFailures = 0;
+      emit romImageProgress(romBytesRead(), EcuTransport::s_romSize);
+
+      chunk = m_romChunkRead.indexOf(false);
+    }
+    else if (++m_romChunkFailures >= s_maxROMChunkAttempts)
+    {
+      m_romReadInProgress = false;
+      emit romImageReadFailed();
+    }
+  }
+
+  if (chunk < 0)
+  {
+    if (m_romImage == 0)
+    {
+      m_romImage = new QByteArray();
+    }
+
+    *m_romImage = m_romReadBuffer;
+    m_romChunkRead.clear();
+    m_romReadInProgress = false;
+
+    m_dataCache.setROMImage(*m_romImage);
+    m_dataCache.save();
+
+    emit romImageReady();
+  }
+}
+
+/**
+ * Checks the next item of the data loaded from the cache while a request for
+ * the ROM image is waiting on it. Called between polling passes. Once
+ * everything has been checked, the cached image is passed on (or, if a
+ * difference caused it to be dropped from the cache, the ROM is read from
+ * the ECU instead.) If the checks fail repeatedly, the request is abandoned.
+ */
+void CUXInterface::checkROMCache()
+{
+  if (m_readCanceled)
+  {
+    m_romCacheCheckInProgress = false;
+    m_readCanceled = false;
+    return;
+  }
+
+  if (!cachedDataIsVerified())
+  {
+    if (verifyCachedData())
+    {
+      m_romChunkFailures = 0;
+    }
+    else if (++m_romChunkFailures >= s_maxROMChunkAttempts)
+    {
+      m_romCacheCheckInProgress = false;
+      emit romImageReadFailed();
+      return;
+    }
+  }
+
+  if (cachedDataIsVerified())
+  {
+    m_romCacheCheckInProgress = false;
+
+    if (m_dataCache.getROMImage().isEmpty())
+    {
+      startROMRead();
+    }
+    else
+    {
+      passOnCachedROMImage();
+    }
+  }
+}
+
+/**
+ * Copies the cached ROM image to the one that's passed on, and signals that
+ * it's ready.
+ */
+void CUXInterface::passOnCachedROMImage()
+{
+  *m_romImage = m_dataCache.getROMImage();
+  emit romImageReady();
+}
+
+/**
+ * Returns the number of bytes of the ROM image read so far.
+ */
+int CUXInterface::romBytesRead() const
+{
+  return m_romChunkRead.count(true) * s_romChunkSize;
+}
+
+/**
+ * Combines the tune revision, checksum fixer and ident into a single value
+ * that identifies the tune of the connected ECU.
+ */
+quint64 CUXInterface::tuneKey() const
+{
+  return ((quint64)m_tune << 32) | ((quint64)m_checksumFixer << 16) | m_ident;
+}
+
 /**
  * Respond to a signal requesting fuel map data by reading the desired fuel
  * map from the ECU, and emitting a signal when done.
@@ -199,14 +411,29 @@ void CUXInterface::onReadROMImageRequested()
  */
 void CUXInterface::onFuelMapRequested(unsigned int fuelMapId)
 {
-  if (m_initComplete && c14cux_isConnected(&m_cuxinfo))
+  if (m_initComplete && m_transport->isConnected())
   {
-    if (readFuelMap(fuelMapId))
+    bool mapChanged = false;
+    bool tableChanged = false;
+
+    // a map that was loaded from the cache is shown straight away, and shown
+    // again only if reading it from the ECU finds that it's different
+    if (m_fuelMapDataIsCurrent[fuelMapId] && !m_fuelMapVerified[fuelMapId])
+    {
+      emit fuelMapReady(fuelMapId);
+
+      if (readFuelMap(fuelMapId, &mapChanged) && mapChanged)
+      {
+        emit fuelMapReady(fuelMapId);
+      }
+    }
+    else if (readFuelMap(fuelMapId))
     {
       emit fuelMapReady(fuelMapId);
     }
 
-    if (c14cux_getRpmTable(&m_cuxinfo, &m_rpmTable))
+    // the RPM table is a constant in the ROM, so it's only read once
+    if (!m_rpmTableVerified && readRPMTable(&tableChanged) && tableChanged)
     {
       emit rpmTableReady();
     }
@@ -214,22 +441,99 @@ void CUXInterface::onFuelMapRequested(unsigned int fuelMapId)
 }
 
 /**
- * Reads a single fuel map (along with its multiplier factor) from the ECU
+ * Reads the table of engine speeds that divide the fuel map columns.
+ * @param changed If non-null, set to true when the table differs from the
+ *  stored copy (or there wasn't one); false otherwise
+ * @return True when the table was read successfully, false otherwise
+ */
+bool CUXInterface::readRPMTable(bool* changed)
+{
+  c14cux_rpmtable table;
+  bool status = false;
+
+  if (m_transport->getRpmTable(&table))
+  {
+    const bool isChanged = !m_rpmTableIsCurrent || (memcmp(&table, &m_rpmTable, sizeof(table)) != 0);
+
+    if (isChanged)
+    {
+      m_rpmTable = table;
+      m_dataCache.setRPMTable(table);
+    }
+
+    if (changed != 0)
+    {
+      *changed = isChanged;
+    }
+
+    m_rpmTableIsCurrent = true;
+    m_rpmTableVerified = true;
+    status = true;
+  }
+
+  return status;
+}
+
+/**
+ * Reads a single fuel map (along with its multiplier factor) from the ECU,
+ * and compares it with the copy already held so that refreshes of a map that
+ * hasn't changed can be ignored.
  * @param fuelMapId Index of the fuel map to read
+ * @param changed If non-null, set to true when the map differs from the
+ *  stored copy (or there wasn't one); false otherwise
  * @return True when the map was read successfully, false otherwise
  */
-bool CUXInterface::readFuelMap(unsigned int fuelMapId)
+bool CUXInterface::readFuelMap(unsigned int fuelMapId, bool* changed)
 {
-  uint8_t* buffer = (uint8_t*)(m_fuelMaps[fuelMapId].data());
+  uint8_t buffer[FUEL_MAP_ROWS * FUEL_MAP_COLUMNS];
   uint16_t adjFactor = 0;
+  uint8_t rowScaler = 0;
+  uint16_t mafScaler = m_mafScaler;
   bool status = false;
 
-  if (c14cux_getFuelMap(&m_cuxinfo, (int8_t)fuelMapId, &adjFactor, &m_rowScaler[fuelMapId], buffer) &&
-      c14cux_readMem(&m_cuxinfo, C14CUX_MAFRowScalerOffset, 2, (uint8_t*)&m_mafScaler))
+  // The MAF row scaler is a constant in the ROM, so it's only re-read along
+  // with the first read of a map rather than with every refresh. A scaler
+  // that was loaded from the cache is read once, to check it.
+  const bool readMAFScaler = !m_fuelMapDataIsCurrent[fuelMapId] || !m_mafScalerVerified;
+
+  if (m_transport->getFuelMap((int8_t)fuelMapId, &adjFactor, &rowScaler, buffer) &&
+      (!readMAFScaler ||
+       m_transport->readMem(C14CUX_MAFRowScalerOffset, 2, (uint8_t*)&mafScaler)))
   {
-    m_mafScaler = swapShort(m_mafScaler);
-    m_fuelMapAdjFactors[fuelMapId] = adjFactor;
+    if (readMAFScaler)
+    {
+      mafScaler = swapShort(mafScaler);
+    }
+
+    const bool isChanged = !m_fuelMapDataIsCurrent[fuelMapId] ||
+                           (adjFactor != m_fuelMapAdjFactors[fuelMapId]) ||
+                           (rowScaler != m_rowScaler[fuelMapId]) ||
+                           (mafScaler != m_mafScaler) ||
+                           (memcmp(buffer, m_fuelMaps[fuelMapId].constData(), sizeof(buffer)) != 0);
+
+    if (readMAFScaler)
+    {
+      m_mafScaler = mafScaler;
+      m_mafScalerVerified = true;
+      m_dataCache.setMAFRowScaler(m_mafScaler);
+    }
+
+    if (isChanged)
+    {
+      memcpy(m_fuelMaps[fuelMapId].data(), buffer, sizeof(buffer));
+      m_fuelMapAdjFactors[fuelMapId] = adjFactor;
+      m_rowScaler[fuelMapId] = rowScaler;
+      m_fuelMapChangeCount++;
+      m_dataCache.setFuelMap(fuelMapId, m_fuelMaps[fuelMapId], adjFactor, rowScaler);
+    }
+
+    if (changed != 0)
+    {
+      *changed = isChanged;
+    }
+
     m_fuelMapDataIsCurrent[fuelMapId] = true;
+    m_fuelMapVerified[fuelMapId] = true;
     status = true;
   }
 
@@ -241,9 +545,9 @@ bool CUXInterface::readFuelMap(unsigned int fuelMapId)
  */
 void CUXInterface::onFuelPumpRunRequest()
 {
-  if (m_initComplete && c14cux_isConnected(&m_cuxinfo))
+  if (m_initComplete && m_transport->isConnected())
   {
-    c14cux_runFuelPump(&m_cuxinfo);
+    m_transport->runFuelPump();
   }
 }
 
@@ -255,9 +559,9 @@ void CUXInterface::onFuelPumpRunRequest()
  */
 void CUXInterface::onIdleAirControlMovementRequest(int direction, int steps)
 {
-  if (m_initComplete && c14cux_isConnected(&m_cuxinfo))
+  if (m_initComplete && m_transport->isConnected())
   {
-    c14cux_driveIdleAirControlMotor(&m_cuxinfo, (uint8_t)direction, (uint8_t)steps);
+    m_transport->driveIdleAirControlMotor((uint8_t)direction, (uint8_t)steps);
   }
   else
   {
@@ -271,7 +575,7 @@ void CUXInterface::onIdleAirControlMovementRequest(int direction, int steps)
  */
 bool CUXInterface::connectToECU()
 {
-  bool status = c14cux_connect(&m_cuxinfo, m_deviceName.toStdString().c_str(), m_baudRate);
+  bool status = m_transport->connect(m_deviceName, m_baudRate);
 
   if (status)
   {
@@ -280,7 +584,7 @@ bool CUXInterface::connectToECU()
 #ifdef ENABLE_FORCE_OPEN_LOOP
     uint8_t openLoopByte = 0;
 
-    if (c14cux_readMem(&m_cuxinfo, 0x0087, 1, &openLoopByte))
+    if (m_transport->readMem(0x0087, 1, &openLoopByte))
     {
       emit forceOpenLoopState(openLoopByte & 0x10);
     }
@@ -292,11 +596,14 @@ bool CUXInterface::connectToECU()
 }
 
 /**
- * Sets a flag that will cause us to stop polling and disconnect from the serial device.
+ * Responds to a request to stop polling and disconnect from the serial device.
  */
-void CUXInterface::disconnectFromECU()
+void CUXInterface::onDisconnectRequest()
 {
-  m_stopPolling = true;
+  if (m_polling)
+  {
+    stopPolling();
+  }
 }
 
 /**
@@ -315,19 +622,19 @@ void CUXInterface::clearFlagsAndData()
   for (unsigned int idx = 0; idx < fuelMapCount; ++idx)
   {
     m_fuelMapDataIsCurrent[idx] = false;
+    m_fuelMapVerified[idx] = false;
   }
+  m_mafScalerVerified = false;
+  m_rpmTableIsCurrent = false;
+  m_rpmTableVerified = false;
+  m_dataCache.close();
 
   m_fuelMapIndexRead = false;
+  m_lastResidencyTimeUs = 0;
+  m_lastResidencyPosition.valid = false;
+  m_scheduler.restart();
 
-  for (int type = 0; type < (int)SampleType_NumSampleTypes; type++)
-  {
-    m_lastReadTime[(SampleType)type] = 0;
-  }
-
-  m_cuxinfo.promRev = C14CUX_DataOffsets_Unset;
-  m_cuxinfo.voltageFactorA = 0;
-  m_cuxinfo.voltageFactorB = 0;
-  m_cuxinfo.voltageFactorC = 0;
+  m_transport->resetState();
   m_readTuneId = false;
   m_rpmLimitRead = false;
 }
@@ -337,16 +644,12 @@ void CUXInterface::clearFlagsAndData()
  */
 void CUXInterface::onShutdownThreadRequest()
 {
-  // If we're currently connected, just set a flag to let the polling loop
-  // shut the thread down. Otherwise, shut it down here.
-  if (c14cux_isConnected(&m_cuxinfo))
+  if (m_polling)
   {
-    m_shutdownThread = true;
-  }
-  else
-  {
-    QThread::currentThread()->quit();
+    stopPolling();
   }
+
+  QThread::currentThread()->quit();
 }
 
 /**
@@ -355,7 +658,7 @@ void CUXInterface::onShutdownThreadRequest()
  */
 bool CUXInterface::isConnected()
 {
-  return (m_initComplete && c14cux_isConnected(&m_cuxinfo));
+  return (m_initComplete && m_transport->isConnected());
 }
 
 /**
@@ -369,7 +672,7 @@ void CUXInterface::onParentThreadStarted()
   // it's in the context of the thread that will use it.
   if (!m_initComplete)
   {
-    c14cux_init(&m_cuxinfo);
+    m_transport->init();
     m_initComplete = true;
   }
 
@@ -381,11 +684,11 @@ void CUXInterface::onParentThreadStarted()
  */
 void CUXInterface::onStartPollingRequest()
 {
-  if (connectToECU())
+  if (!m_polling && connectToECU())
   {
-    m_stopPolling = false;
-    m_shutdownThread = false;
-    runServiceLoop();
+    m_polling = true;
+    m_scheduler.restart();
+    m_pollTimer->start(0);
   }
   else
   {
@@ -406,52 +709,323 @@ void CUXInterface::onStartPollingRequest()
 }
 
 /**
- * Calls readData() in a loop until commanded to disconnect and possibly
- * shut down the thread.
+ * Runs a single polling pass each time the poll timer expires: reads whatever
+ * samples are due, reports the result, and re-arms the timer for the next
+ * deadline. Between passes the worker thread sits idle in its event loop, so
+ * queued requests (fault codes, fuel pump, etc.) are serviced as soon as the
+ * current pass completes.
+ */
+void CUXInterface::onPollTimerExpired()
+{
+  if (!m_polling)
+  {
+    return;
+  }
+
+  if (!m_transport->isConnected())
+  {
+    stopPolling();
+    return;
+  }
+
+  ReadResult res = readData();
+
+  if (res != ReadResult_NoStatement)
+  {
+    m_linkMetrics.recordPass();
+  }
+
+  if (res == ReadResult_Success)
+  {
+    if (!m_readTuneId &&
+        m_transport->getTuneRevision(&m_tune, &m_checksumFixer, &m_ident))
+    {
+      m_readTuneId = true;
+      emit revisionNumberReady(m_tune, m_checksumFixer, m_ident);
+      loadCachedData();
+    }
+
+    publishSample();
+
+    emit readSuccess();
+    emit dataReady();
+
+    verifyCachedData();
+  }
+  else if (res == ReadResult_Failure)
+  {
+    emit readError();
+  }
+
+  if (m_romCacheCheckInProgress)
+  {
+    checkROMCache();
+  }
+
+  if (m_romReadInProgress)
+  {
+    readROMChunk();
+  }
+
+  qint64 waitMs = m_scheduler.msecsUntilNextDue();
+
+  if (m_romReadInProgress || m_romCacheCheckInProgress)
+  {
+    // come straight back for the next chunk of the ROM (or the next item of
+    // the cached data that it's waiting on)
+    waitMs = 0;
+  }
+  else if (waitMs < 0)
+  {
+    // nothing is enabled; check back occasionally in case that changes
+    waitMs = s_idlePollIntervalMs;
+  }
+
+  m_pollTimer->start((int)waitMs);
+}
+
+/**
+ * Opens the cache entry for the connected ECU once its tune has been
+ * identified. Anything already read from the ECU is stored in the cache, and
+ * the rest is filled in from the cache so that it can be shown without
+ * waiting for it to be read; verifyCachedData() later checks it against the
+ * ECU.
  */
-void CUXInterface::runServiceLoop()
+void CUXInterface::loadCachedData()
 {
-  ReadResult res = ReadResult_NoStatement;
+  bool anyMapRead = false;
+  uint16_t mafScaler = 0;
+  c14cux_rpmtable table;
+
+  m_dataCache.open(m_tune, m_checksumFixer, m_ident);
 
-  bool connected = c14cux_isConnected(&m_cuxinfo);
+  for (unsigned int idx = 0; idx < fuelMapCount; ++idx)
+  {
+    if (m_fuelMapDataIsCurrent[idx])
+    {
+      m_dataCache.setFuelMap(idx, m_fuelMaps[idx], m_fuelMapAdjFactors[idx], m_rowScaler[idx]);
+      anyMapRead = true;
+    }
+  }
 
-  while (!m_stopPolling && !m_shutdownThread && connected)
+  if (anyMapRead)
   {
-    res = readData();
+    m_dataCache.setMAFRowScaler(m_mafScaler);
+  }
 
-    if (res == ReadResult_Success)
+  // a cached map can't be used without the MAF row scaler that goes with it
+  if (m_dataCache.getMAFRowScaler(mafScaler))
+  {
+    for (unsigned int idx = 0; idx < fuelMapCount; ++idx)
     {
-      if (!m_readTuneId &&
-          c14cux_getTuneRevision(&m_cuxinfo, &m_tune, &m_checksumFixer, &m_ident))
+      if (!m_fuelMapDataIsCurrent[idx] &&
+          m_dataCache.getFuelMap(idx, m_fuelMaps[idx], m_fuelMapAdjFactors[idx], m_rowScaler[idx]))
       {
-        m_readTuneId = true;
-        emit revisionNumberReady(m_tune, m_checksumFixer, m_ident);
+        m_mafScaler = mafScaler;
+        m_fuelMapDataIsCurrent[idx] = true;
+        m_fuelMapVerified[idx] = false;
+
+        if (m_fuelMapIndexRead && (idx == m_currentFuelMapIndex))
+        {
+          emit fuelMapReady(idx);
+        }
       }
+    }
+  }
+
+  if (m_rpmTableIsCurrent)
+  {
+    m_dataCache.setRPMTable(m_rpmTable);
+  }
+  else if (m_dataCache.getRPMTable(table))
+  {
+    m_rpmTable = table;
+    m_rpmTableIsCurrent = true;
+    m_rpmTableVerified = false;
+    emit rpmTableReady();
+  }
+}
+
+/**
+ * Checks one item of the data that was loaded from the cache against the
+ * ECU, and passes it on again if it turns out to be different. Called after
+ * each polling pass, so that the checks are spread out between readings
+ * rather than holding up the first screen of data.
+ * @return True if an item was checked; false if there was nothing left to
+ *  check or the read failed
+ */
+bool CUXInterface::verifyCachedData()
+{
+  bool changed = false;
+  bool checked = false;
 
-      emit readSuccess();
-      emit dataReady();
+  if (m_rpmTableIsCurrent && !m_rpmTableVerified)
+  {
+    checked = readRPMTable(&changed);
+
+    if (checked && changed)
+    {
+      emit rpmTableReady();
     }
-    else if (res == ReadResult_Failure)
+  }
+  else
+  {
+    unsigned int idx = 0;
+
+    while ((idx < fuelMapCount) && (!m_fuelMapDataIsCurrent[idx] || m_fuelMapVerified[idx]))
     {
-      emit readError();
+      idx++;
     }
 
-    QCoreApplication::processEvents();
+    if (idx < fuelMapCount)
+    {
+      checked = readFuelMap(idx, &changed);
+
+      if (checked && changed && m_fuelMapIndexRead && (idx == m_currentFuelMapIndex))
+      {
+        emit fuelMapReady(idx);
+      }
+    }
   }
 
-  if (connected)
+  if (checked && cachedDataIsVerified())
   {
-    c14cux_disconnect(&m_cuxinfo);
+    m_dataCache.save();
   }
 
-  emit disconnected();
+  return checked;
+}
 
-  clearFlagsAndData();
+/**
+ * Indicates whether all of the data that was loaded from the cache has been
+ * checked against the ECU.
+ */
+bool CUXInterface::cachedDataIsVerified() const
+{
+  bool verified = !m_rpmTableIsCurrent || m_rpmTableVerified;
+  bool anyMapCurrent = false;
 
-  if (m_shutdownThread)
+  for (unsigned int idx = 0; idx < fuelMapCount; ++idx)
   {
-    QThread::currentThread()->quit();
+    verified = verified && (!m_fuelMapDataIsCurrent[idx] || m_fuelMapVerified[idx]);
+    anyMapCurrent = anyMapCurrent || m_fuelMapDataIsCurrent[idx];
   }
+
+  // the maps can't be used without the MAF row scaler that goes with them
+  return verified && (!anyMapCurrent || m_mafScalerVerified);
+}
+
+/**
+ * Copies the current readings into a new snapshot, passes it to the sample
+ * sink (if there is one) and makes it available to the GUI thread. Must only
+ * be called from the worker thread.
+ */
+void CUXInterface::publishSample()
+{
+  EcuSample& sample = m_samples.writeBuffer();
+
+  sample.sequence = m_sampleSequence++;
+  sample.timestampUs = elapsedUs();
+  memcpy(sample.readTimeUs, m_readTimeUs, sizeof(sample.readTimeUs));
+
+  sample.roadSpeedMPH = m_roadSpeedMPH;
+  sample.engineSpeedRPM = m_engineSpeedRPM;
+  sample.targetIdleSpeed = m_targetIdleSpeed;
+  sample.idleMode = m_idleMode;
+  sample.coolantTempF = m_coolantTempF;
+  sample.fuelTempF = m_fuelTempF;
+  sample.throttlePos = m_throttlePos;
+  sample.mafReading = m_mafReading;
+  sample.idleBypassPos = m_idleBypassPos;
+  sample.mainVoltage = m_mainVoltage;
+  sample.gear = m_gear;
+  sample.fuelPumpRelayOn = m_fuelPumpRelayOn;
+  sample.milOn = m_milOn;
+  sample.feedbackMode = m_feedbackMode;
+  sample.currentFuelMapIndex = m_currentFuelMapIndex;
+  sample.fuelMapRowIndex = m_currentFuelMapRowIndex;
+  sample.fuelMapRowWeighting = m_fuelMapRowWeighting;
+  sample.fuelMapColumnIndex = m_currentFuelMapColumnIndex;
+  sample.fuelMapColWeighting = m_fuelMapColWeighting;
+  sample.lambdaTrimOdd = m_lambdaTrimOdd;
+  sample.lambdaTrimEven = m_lambdaTrimEven;
+  sample.coTrimVoltage = m_coTrimVoltage;
+  sample.injectorPulseWidthMs = m_injectorPulseWidthMs;
+
+  sample.tune = m_tune;
+  sample.checksumFixer = m_checksumFixer;
+  sample.ident = m_ident;
+
+  // the sink is given the snapshot before it's published, while it still
+  // belongs to this thread
+  {
+    QMutexLocker locker(&m_sampleSinkLock);
+
+    if (m_sampleSink != 0)
+    {
+      m_sampleSink->samplePublished(sample);
+    }
+  }
+
+  m_samples.publish();
+}
+
+/**
+ * Sets the object that receives every snapshot as it's published, or clears
+ * it if the sink is null. Once this returns, the previous sink won't be
+ * called again.
+ */
+void CUXInterface::setSampleSink(EcuSampleSink* sink)
+{
+  QMutexLocker locker(&m_sampleSinkLock);
+  m_sampleSink = sink;
+}
+
+/**
+ * Returns the time elapsed on the interface's monotonic clock.
+ * @return Microseconds since the clock epoch
+ */
+qint64 CUXInterface::elapsedUs() const
+{
+  return m_clock.nsecsElapsed() / 1000;
+}
+
+/**
+ * Returns the most recent snapshot of the ECU readings. The snapshot is
+ * consistent (all of its values come from the same polling pass) and stays
+ * unchanged until the next call. Must only be called from the GUI thread.
+ * @return Reference to the latest snapshot
+ */
+const EcuSample& CUXInterface::getLatestSample()
+{
+  return m_samples.read();
+}
+
+/**
+ * Stops the poll timer, closes the serial device, and clears the stored data.
+ */
+void CUXInterface::stopPolling()
+{
+  m_pollTimer->stop();
+  m_polling = false;
+
+  if (m_transport->isConnected())
+  {
+    m_transport->disconnect();
+  }
+
+  emit disconnected();
+
+  if (m_romReadInProgress || m_romCacheCheckInProgress)
+  {
+    // the chunks read so far are kept, so the read can be resumed if the
+    // same ECU is reconnected
+    m_romReadInProgress = false;
+    m_romCacheCheckInProgress = false;
+    emit romImageReadFailed();
+  }
+
+  clearFlagsAndData();
 }
 
 /**
@@ -485,141 +1059,357 @@ bool CUXInterface::isSampleAppropriateForMode(SampleType type) const
 }
 
 /**
- * Determines if a sample type is due to be read (i.e. enough time has passed since the
- * last reading to prevent another read from being redundant)
+ * Schedules each sample only while it's both enabled and appropriate for the
+ * current operating mode. Samples that don't apply to the mode are left out
+ * of the schedule altogether (rather than being skipped when they come due),
+ * so that they're read as soon as the mode changes instead of a full
+ * interval later.
  */
-bool CUXInterface::isDueForMeasurement(SampleType type)
+void CUXInterface::updateScheduledSamples()
 {
-  bool status = false;
-
-  if (m_enabledSamples[type] && isSampleAppropriateForMode(type))
+  for (int type = 0; type < (int)SampleType_NumSampleTypes; type++)
   {
-    qint64 now = QDateTime::currentMSecsSinceEpoch();
-
-    if (now - m_lastReadTime[type] >= m_readIntervals[type])
-    {
-      status = true;
-      m_lastReadTime[type] = now;
-    }
+    const SampleType sampleType = (SampleType)type;
+    m_scheduler.setEnabled(sampleType, m_enabledSamples.value(sampleType, false) &&
+                                       isSampleAppropriateForMode(sampleType));
   }
-
-  return status;
 }
 
 /**
- * Reads data from the 14CUX via calls to the library, and stores the data in
- * member variables.
- * @return True if at least one value was read successfully; false otherwise.
+ * Reads the samples that are currently due from the 14CUX via calls to the
+ * library, and stores the data in member variables.
+ * @return Success if at least one value was read successfully, Failure if
+ *   every attempted read failed, or NoStatement if nothing was due.
  */
 CUXInterface::ReadResult CUXInterface::readData()
 {
   ReadResult result = ReadResult_NoStatement;
 
-  if (isDueForMeasurement(SampleType_MAF))
-  {
-    result = mergeResult(result, c14cux_getMAFReading(&m_cuxinfo, m_airflowType, &m_mafReading));
-  }
+  // samples in neighbouring RAM locations are fetched together in block reads,
+  // and everything else goes through its individual library call
+  m_readPlan.build(m_scheduler.takeDueSamples());
 
-  if (isDueForMeasurement(SampleType_Throttle))
+  foreach(const ReadPlan::Block& block, m_readPlan.blocks())
   {
-    result = mergeResult(result, c14cux_getThrottlePosition(&m_cuxinfo, m_throttlePosType, &m_throttlePos));
+    result = mergeResult(result, readBlock(block));
   }
 
-  if (isDueForMeasurement(SampleType_LambdaTrimShort))
+  foreach(SampleType type, m_readPlan.individualSamples())
   {
-    result = mergeResult(result, c14cux_getLambdaTrimShort(&m_cuxinfo, C14CUX_Bank_Odd, &m_lambdaTrimOdd));
-    result = mergeResult(result, c14cux_getLambdaTrimShort(&m_cuxinfo, C14CUX_Bank_Even, &m_lambdaTrimEven));
-  }
+    const qint64 startUs = elapsedUs();
+    const ReadResult sampleResult = readSample(type);
+    const qint64 endUs = elapsedUs();
 
-  if (isDueForMeasurement(SampleType_EngineRPM))
-  {
-    result = mergeResult(result, c14cux_getEngineRPM(&m_cuxinfo, &m_engineSpeedRPM));
+    if (sampleResult != ReadResult_NoStatement)
+    {
+      m_linkMetrics.recordRead(type, endUs - startUs, sampleResult == ReadResult_Success);
+    }
 
-    // If we haven't yet reported the RPM limit, see if we can read it now.
-    // This is a special case because the limit is only read into its RAM
-    // location in the ECU once the main spark interrupt has run; we therefore
-    // wait until the engine speed > 0 before attempting this.
-    if (!m_rpmLimitRead &&
-        (result == ReadResult_Success) &&
-        (m_engineSpeedRPM > 0) &&
-        c14cux_getRPMLimit(&m_cuxinfo, &m_rpmLimit))
+    if (sampleResult == ReadResult_Success)
     {
-      m_rpmLimitRead = true;
-      emit rpmLimitReady(m_rpmLimit);
+      m_readTimeUs[type] = endUs;
+      reportSampleValue(type);
     }
+    result = mergeResult(result, sampleResult);
   }
 
-  if (isDueForMeasurement(SampleType_FuelMapRowCol))
-  {
-    result = mergeResult(result, c14cux_getFuelMapRowIndex(&m_cuxinfo, &m_currentFuelMapRowIndex, &m_fuelMapRowWeighting));
-    result = mergeResult(result, c14cux_getFuelMapColumnIndex(&m_cuxinfo, &m_currentFuelMapColumnIndex, &m_fuelMapColWeighting));
-  }
+  updateFuelMapResidency();
 
-  if (isDueForMeasurement(SampleType_InjectorPulseWidth))
-  {
-    result = mergeResult(result, c14cux_getInjectorPulseWidth(&m_cuxinfo, &m_injectorPulseWidthUs));
-    m_injectorPulseWidthMs = (float)m_injectorPulseWidthUs / 1000.0;
-  }
+  return result;
+}
 
-  if (isDueForMeasurement(SampleType_IdleBypassPosition))
-  {
-    result = mergeResult(result, c14cux_getIdleBypassMotorPosition(&m_cuxinfo, &m_idleBypassPos));
-  }
+/**
+ * Credits the fuel map residency with the time since the previous reading of
+ * the fuel map position, if a new reading was made in this pass. The engine
+ * sat at the previously-read position for that time, so that's the cell (and
+ * those are the trims) that the time is credited to.
+ */
+void CUXInterface::updateFuelMapResidency()
+{
+  const qint64 readTimeUs = m_readTimeUs[SampleType_FuelMapRowCol];
 
-  if (isDueForMeasurement(SampleType_LambdaTrimLong))
+  if (readTimeUs != m_lastResidencyTimeUs)
   {
-    result = mergeResult(result, c14cux_getLambdaTrimLong(&m_cuxinfo, C14CUX_Bank_Odd, &m_lambdaTrimOdd));
-    result = mergeResult(result, c14cux_getLambdaTrimLong(&m_cuxinfo, C14CUX_Bank_Even, &m_lambdaTrimEven));
-  }
+    const ResidencyPosition& last = m_lastResidencyPosition;
 
-  if (isDueForMeasurement(SampleType_MainVoltage))
-  {
-    result = mergeResult(result, c14cux_getMainVoltage(&m_cuxinfo, &m_mainVoltage));
-  }
+    if ((m_lastResidencyTimeUs > 0) && last.valid)
+    {
+      const qint64 intervalUs = qMin(readTimeUs - m_lastResidencyTimeUs, (qint64)s_maxResidencyIntervalUs);
 
-  if (isDueForMeasurement(SampleType_TargetIdleRPM))
-  {
-    result = mergeResult(result, c14cux_getTargetIdle(&m_cuxinfo, &m_targetIdleSpeed));
-    result = mergeResult(result, c14cux_getIdleMode(&m_cuxinfo, &m_idleMode));
+      m_fuelMapResidency.addReading(last.fuelMapIndex,
+                                    last.row, last.rowWeighting,
+                                    last.col, last.colWeighting,
+                                    intervalUs / 1000000.0,
+                                    last.trimValid, last.trimOdd, last.trimEven);
+    }
+
+    m_lastResidencyPosition.valid = m_fuelMapIndexRead;
+    m_lastResidencyPosition.fuelMapIndex = m_currentFuelMapIndex;
+    m_lastResidencyPosition.row = m_currentFuelMapRowIndex;
+    m_lastResidencyPosition.rowWeighting = m_fuelMapRowWeighting;
+    m_lastResidencyPosition.col = m_currentFuelMapColumnIndex;
+    m_lastResidencyPosition.colWeighting = m_fuelMapColWeighting;
+    m_lastResidencyPosition.trimValid = (m_feedbackMode == C14CUX_FeedbackMode_ClosedLoop) &&
+                                        (m_enabledSamples[SampleType_LambdaTrimShort] ||
+                                         m_enabledSamples[SampleType_LambdaTrimLong]);
+    m_lastResidencyPosition.trimOdd = m_lambdaTrimOdd;
+    m_lastResidencyPosition.trimEven = m_lambdaTrimEven;
+    m_lastResidencyTimeUs = readTimeUs;
   }
+}
+
+/**
+ * Reads a contiguous block of ECU RAM and decodes each of the samples that
+ * it contains.
+ * @param block Block of RAM to read, as planned by the ReadPlan
+ * @return Result of the block read
+ */
+CUXInterface::ReadResult CUXInterface::readBlock(const ReadPlan::Block& block)
+{
+  QVarLengthArray<uint8_t, 64> buffer(block.length);
+  const qint64 startUs = elapsedUs();
+  bool status = m_transport->readMem(block.offset, block.length, buffer.data());
+  const qint64 readTimeUs = elapsedUs();
 
-  if (isDueForMeasurement(SampleType_FuelPumpRelay))
+  // each member of the block is charged with the full round trip, since that
+  // is what it took to get its value
+  foreach(const ReadPlan::Location& member, block.members)
   {
-    result = mergeResult(result, c14cux_getFuelPumpRelayState(&m_cuxinfo, &m_fuelPumpRelayOn));
+    m_linkMetrics.recordRead(member.type, readTimeUs - startUs, status);
   }
 
-  if (isDueForMeasurement(SampleType_GearSelection))
+  if (status)
   {
-    result = mergeResult(result, c14cux_getGearSelection(&m_cuxinfo, &m_gear));
+    foreach(const ReadPlan::Location& member, block.members)
+    {
+      m_readTimeUs[member.type] = readTimeUs;
+      decodeSample(member.type, buffer.data() + (member.offset - block.offset));
+      reportSampleValue(member.type);
+    }
   }
 
-  if (isDueForMeasurement(SampleType_RoadSpeed))
+  return mergeResult(ReadResult_NoStatement, status);
+}
+
+/**
+ * Converts the raw RAM contents for a sample into the stored reading.
+ * @param type Type of sample being decoded
+ * @param data Pointer to the first byte of the sample's RAM location
+ */
+void CUXInterface::decodeSample(SampleType type, const uint8_t* data)
+{
+  switch (type)
   {
-    result = mergeResult(result, c14cux_getRoadSpeed(&m_cuxinfo, &m_roadSpeedMPH));
+  case SampleType_EngineRPM:
+    m_engineSpeedRPM = ReadPlan::decodeEngineRPM(data);
+    checkForRPMLimit();
+    break;
+
+  case SampleType_RoadSpeed:
+    m_roadSpeedMPH = ReadPlan::decodeRoadSpeedMPH(data);
+    break;
+
+  case SampleType_FuelMapRowCol:
+    ReadPlan::decodeFuelMapRowCol(data, &m_currentFuelMapRowIndex, &m_fuelMapRowWeighting,
+                                  &m_currentFuelMapColumnIndex, &m_fuelMapColWeighting);
+    break;
+
+  case SampleType_InjectorPulseWidth:
+    m_injectorPulseWidthUs = ReadPlan::decodeInjectorPulseWidthUs(data);
+    m_injectorPulseWidthMs = (float)m_injectorPulseWidthUs / 1000.0;
+    break;
+
+  default:
+    break;
   }
+}
+
+/**
+ * Passes the most recent reading of a sample to the scheduler, for use in
+ * tuning its read interval.
+ */
+void CUXInterface::reportSampleValue(SampleType type)
+{
+  double secondValue = 0.0;
+  const double value = getSampleValue(type, &secondValue);
+
+  m_scheduler.reportValue(type, value, secondValue);
+}
+
+/**
+ * Returns the most recent reading of a sample as a number, for use in tuning
+ * its read interval. Values are in the units stored by the interface
+ * (degrees F, MPH, RPM, volts, milliseconds, or fractions of full scale.)
+ * Readings made up of two values (one for each bank, or each axis of the
+ * fuel map) return the second one separately, so that opposite movements
+ * of the two don't cancel out.
+ * @param type Type of sample
+ * @param secondValue Set to the second value of the reading, or zero if
+ *  it has only one
+ * @return Current reading for the sample
+ */
+double CUXInterface::getSampleValue(SampleType type, double* secondValue) const
+{
+  double value = 0.0;
 
-  if (isDueForMeasurement(SampleType_EngineTemperature))
+  *secondValue = 0.0;
+
+  switch (type)
   {
-    result = mergeResult(result, c14cux_getCoolantTemp(&m_cuxinfo, &m_coolantTempF));
+  case SampleType_EngineTemperature:
+    value = m_coolantTempF;
+    break;
+  case SampleType_RoadSpeed:
+    value = m_roadSpeedMPH;
+    break;
+  case SampleType_EngineRPM:
+    value = m_engineSpeedRPM;
+    break;
+  case SampleType_FuelTemperature:
+    value = m_fuelTempF;
+    break;
+  case SampleType_MAF:
+    value = m_mafReading;
+    break;
+  case SampleType_Throttle:
+    value = m_throttlePos;
+    break;
+  case SampleType_IdleBypassPosition:
+    value = m_idleBypassPos;
+    break;
+  case SampleType_TargetIdleRPM:
+    value = m_targetIdleSpeed;
+    break;
+  case SampleType_GearSelection:
+    value = (int)m_gear;
+    break;
+  case SampleType_MainVoltage:
+    value = m_mainVoltage;
+    break;
+  case SampleType_LambdaTrimShort:
+  case SampleType_LambdaTrimLong:
+    value = m_lambdaTrimOdd;
+    *secondValue = m_lambdaTrimEven;
+    break;
+  case SampleType_COTrimVoltage:
+    value = m_coTrimVoltage;
+    break;
+  case SampleType_FuelPumpRelay:
+    value = m_fuelPumpRelayOn ? 1.0 : 0.0;
+    break;
+  case SampleType_FuelMapRowCol:
+    // position in the map in sixteenths of a cell, along each axis
+    value = m_currentFuelMapRowIndex * 16 + m_fuelMapRowWeighting;
+    *secondValue = m_currentFuelMapColumnIndex * 16 + m_fuelMapColWeighting;
+    break;
+  case SampleType_InjectorPulseWidth:
+    value = m_injectorPulseWidthMs;
+    break;
+  case SampleType_FuelMapData:
+    // counts changes to the stored maps, so that any change is seen as movement
+    value = m_fuelMapChangeCount;
+    break;
+  default:
+    break;
   }
 
-  if (isDueForMeasurement(SampleType_FuelTemperature))
+  return value;
+}
+
+/**
+ * If we haven't yet reported the RPM limit, see if we can read it now.
+ * This is a special case because the limit is only read into its RAM
+ * location in the ECU once the main spark interrupt has run; we therefore
+ * wait until the engine speed > 0 before attempting this.
+ */
+void CUXInterface::checkForRPMLimit()
+{
+  if (!m_rpmLimitRead &&
+      (m_engineSpeedRPM > 0) &&
+      m_transport->getRPMLimit(&m_rpmLimit))
   {
-    result = mergeResult(result, c14cux_getFuelTemp(&m_cuxinfo, &m_fuelTempF));
+    m_rpmLimitRead = true;
+    emit rpmLimitReady(m_rpmLimit);
   }
+}
+
+/**
+ * Reads a single type of sample from the 14CUX via its library call and stores
+ * it in the corresponding member variable(s). Samples that have a RAM location
+ * in the ReadPlan are read by readBlock() instead.
+ * @param type Type of sample to read
+ * @return Result of the read attempt(s) for this sample type
+ */
+CUXInterface::ReadResult CUXInterface::readSample(SampleType type)
+{
+  ReadResult result = ReadResult_NoStatement;
 
-  if (isDueForMeasurement(SampleType_FuelMapData))
+  switch (type)
   {
-    if (readFuelMap(m_currentFuelMapIndex))
+  case SampleType_MAF:
+    result = mergeResult(result, m_transport->getMAFReading(m_airflowType, &m_mafReading));
+    break;
+
+  case SampleType_Throttle:
+    result = mergeResult(result, m_transport->getThrottlePosition(m_throttlePosType, &m_throttlePos));
+    break;
+
+  case SampleType_LambdaTrimShort:
+    result = mergeResult(result, m_transport->getLambdaTrimShort(C14CUX_Bank_Odd, &m_lambdaTrimOdd));
+    result = mergeResult(result, m_transport->getLambdaTrimShort(C14CUX_Bank_Even, &m_lambdaTrimEven));
+    break;
+
+  case SampleType_IdleBypassPosition:
+    result = mergeResult(result, m_transport->getIdleBypassMotorPosition(&m_idleBypassPos));
+    break;
+
+  case SampleType_LambdaTrimLong:
+    result = mergeResult(result, m_transport->getLambdaTrimLong(C14CUX_Bank_Odd, &m_lambdaTrimOdd));
+    result = mergeResult(result, m_transport->getLambdaTrimLong(C14CUX_Bank_Even, &m_lambdaTrimEven));
+    break;
+
+  case SampleType_MainVoltage:
+    result = mergeResult(result, m_transport->getMainVoltage(&m_mainVoltage));
+    break;
+
+  case SampleType_TargetIdleRPM:
+    result = mergeResult(result, m_transport->getTargetIdle(&m_targetIdleSpeed));
+    result = mergeResult(result, m_transport->getIdleMode(&m_idleMode));
+    break;
+
+  case SampleType_FuelPumpRelay:
+    result = mergeResult(result, m_transport->getFuelPumpRelayState(&m_fuelPumpRelayOn));
+    break;
+
+  case SampleType_GearSelection:
+    result = mergeResult(result, m_transport->getGearSelection(&m_gear));
+    break;
+
+  case SampleType_EngineTemperature:
+    result = mergeResult(result, m_transport->getCoolantTemp(&m_coolantTempF));
+    break;
+
+  case SampleType_FuelTemperature:
+    result = mergeResult(result, m_transport->getFuelTemp(&m_fuelTempF));
+    break;
+
+  case SampleType_FuelMapData:
     {
-      emit fuelMapReady(m_currentFuelMapIndex);
+      // a periodic refresh only needs to be passed on if the map has changed
+      bool changed = false;
+      const bool status = readFuelMap(m_currentFuelMapIndex, &changed);
+
+      result = mergeResult(result, status);
+      if (status && changed)
+      {
+        emit fuelMapReady(m_currentFuelMapIndex);
+      }
     }
-  }
+    break;
 
-  // attempt to read the MIL status; if it can't be read, default it to off on the display
-  if (isDueForMeasurement(SampleType_MIL))
-  {
-    if (c14cux_isMILOn(&m_cuxinfo, &m_milOn))
+  case SampleType_MIL:
+    // attempt to read the MIL status; if it can't be read, default it to off on the display
+    if (m_transport->isMILOn(&m_milOn))
     {
       result = mergeResult(result, true);
     }
@@ -628,52 +1418,66 @@ CUXInterface::ReadResult CUXInterface::readData()
       result = mergeResult(result, false);
       m_milOn = false;
     }
+    break;
+
+  case SampleType_FuelMapIndex:
+    result = mergeResult(result, readFuelMapIndex());
+    break;
+
+  case SampleType_COTrimVoltage:
+    result = mergeResult(result, m_transport->getCOTrimVoltage(&m_coTrimVoltage));
+    break;
+
+  default:
+    break;
   }
 
-  if (isDueForMeasurement(SampleType_FuelMapIndex))
-  {
-    uint8_t newFuelMapIndex = 0;
-    bool fuelMapIndexReadResult = c14cux_getCurrentFuelMap(&m_cuxinfo, &newFuelMapIndex);
-    result = mergeResult(result, fuelMapIndexReadResult);
+  return result;
+}
 
-    // do some processing that is only relevant if we successfully read the current map ID
-    if (fuelMapIndexReadResult)
+/**
+ * Reads the index of the fuel map currently in use, and emits signals if
+ * either the map index or the resulting feedback mode has changed.
+ * @return True if the fuel map index was read successfully; false otherwise
+ */
+bool CUXInterface::readFuelMapIndex()
+{
+  uint8_t newFuelMapIndex = 0;
+  bool status = m_transport->getCurrentFuelMap(&newFuelMapIndex);
+
+  // do some processing that is only relevant if we successfully read the current map ID
+  if (status)
+  {
+    // if the fuel map index has changed, or if this is the first time we've read it
+    if ((newFuelMapIndex != m_currentFuelMapIndex) || !m_fuelMapIndexRead)
     {
-      // if the fuel map index has changed, or if this is the first time we've read it
-      if ((newFuelMapIndex != m_currentFuelMapIndex) || !m_fuelMapIndexRead)
-      {
-        m_currentFuelMapIndex = newFuelMapIndex;
-        emit fuelMapIndexHasChanged(m_currentFuelMapIndex);
-      }
+      m_currentFuelMapIndex = newFuelMapIndex;
+      emit fuelMapIndexHasChanged(m_currentFuelMapIndex);
+    }
 
-      // regardless of whether the map has changed, we know now
-      // that is has been read at least once
-      m_fuelMapIndexRead = true;
+    // regardless of whether the map has changed, we know now
+    // that is has been read at least once
+    m_fuelMapIndexRead = true;
 
-      // set the current fueling mode (open-loop or closed-loop)
-      c14cux_feedback_mode newFeedbackMode = C14CUX_FeedbackMode_ClosedLoop;
+    // set the current fueling mode (open-loop or closed-loop)
+    c14cux_feedback_mode newFeedbackMode = C14CUX_FeedbackMode_ClosedLoop;
 
-      if ((m_currentFuelMapIndex >= s_firstOpenLoopMap) &&
-          (m_currentFuelMapIndex <= s_lastOpenLoopMap))
-      {
-        newFeedbackMode = C14CUX_FeedbackMode_OpenLoop;
-      }
+    if ((m_currentFuelMapIndex >= s_firstOpenLoopMap) &&
+        (m_currentFuelMapIndex <= s_lastOpenLoopMap))
+    {
+      newFeedbackMode = C14CUX_FeedbackMode_OpenLoop;
+    }
 
-      // if the feedback mode has changed, emit a signal
-      if (newFeedbackMode != m_feedbackMode)
-      {
-        m_feedbackMode = newFeedbackMode;
-        emit feedbackModeHasChanged(m_feedbackMode);
-      }
+    // if the feedback mode has changed, emit a signal
+    if (newFeedbackMode != m_feedbackMode)
+    {
+      m_feedbackMode = newFeedbackMode;
+      updateScheduledSamples();
+      emit feedbackModeHasChanged(m_feedbackMode);
     }
   }
-  
-  if (isDueForMeasurement(SampleType_COTrimVoltage))
-  {
-    result = mergeResult(result, c14cux_getCOTrimVoltage(&m_cuxinfo, &m_coTrimVoltage));
-  }
 
-  return result;
+  return status;
 }
 
 /**
@@ -717,7 +1521,7 @@ CUXInterface::ReadResult CUXInterface::mergeResult(ReadResult total, bool single
 void CUXInterface::cancelRead()
 {
   m_readCanceled = true;
-  c14cux_cancelRead(&m_cuxinfo);
+  m_transport->cancelRead();
 }
 
 /**
@@ -774,10 +1578,21 @@ int CUXInterface::getFuelMapAdjustmentFactor(unsigned int fuelMapId) const
  * @return Speed in the desired units
  */
 unsigned int CUXInterface::convertSpeed(unsigned int speedMph) const
+{
+  return convertSpeed(speedMph, m_speedUnits);
+}
+
+/**
+ * Converts speed in miles per hour to the given units.
+ * @param speedMph Speed in miles per hour
+ * @param units Units to convert to
+ * @return Speed in the given units
+ */
+unsigned int CUXInterface::convertSpeed(unsigned int speedMph, SpeedUnits units)
 {
   float speed = (float)speedMph;
 
-  if (m_speedUnits == KPH)
+  if (units == KPH)
   {
     speed *= 1.609344;
   }
@@ -791,10 +1606,21 @@ unsigned int CUXInterface::convertSpeed(unsigned int speedMph) const
  * @return Temperature in the desired units
  */
 int CUXInterface::convertTemperature(int tempF) const
+{
+  return convertTemperature(tempF, m_tempUnits);
+}
+
+/**
+ * Converts temperature in Fahrenheit degrees to the given units.
+ * @param tempF Temperature in Fahrenheit degrees
+ * @param units Units to convert to
+ * @return Temperature in the given units
+ */
+int CUXInterface::convertTemperature(int tempF, TemperatureUnits units)
 {
   double temp = tempF;
 
-  switch (m_tempUnits)
+  switch (units)
   {
   case Celsius:
     temp = (temp - 32) * (0.5555556);
@@ -821,9 +1647,28 @@ void CUXInterface::setEnabledSamples(QMap<SampleType, bool> samples)
     m_enabledSamples[field] = samples[field];
   }
 
+  updateScheduledSamples();
   zeroDisabledSamples();
 }
 
+/**
+ * Sets the type of lambda trim (short or long term) that is read.
+ */
+void CUXInterface::setLambdaTrimType(c14cux_lambda_trim_type type)
+{
+  m_lambdaTrimType = type;
+  updateScheduledSamples();
+}
+
+/**
+ * Turns the periodic refresh of the current fuel map on or off.
+ */
+void CUXInterface::setPeriodicFuelMapRefresh(bool on)
+{
+  m_fuelMapRefresh = on;
+  updateScheduledSamples();
+}
+
 /**
  * For the samples that are disabled, set the stored last reading to a default
  * value (zero) so that they do not appear as valid-but-unchanging data points
@@ -918,21 +1763,44 @@ void CUXInterface::setReadIntervals(QHash<SampleType, unsigned int> intervals)
 {
   foreach(SampleType field, intervals.keys())
   {
-    m_readIntervals[field] = intervals[field];
+    m_scheduler.setInterval(field, intervals[field]);
   }
 }
 
+/**
+ * Updates the range within which each sample's read interval may be tuned
+ * when adaptive read intervals are enabled.
+ */
+void CUXInterface::setReadIntervalBounds(QHash<SampleType, QPair<unsigned int, unsigned int> > bounds)
+{
+  foreach(SampleType field, bounds.keys())
+  {
+    m_scheduler.setIntervalBounds(field, bounds[field].first, bounds[field].second);
+  }
+}
+
+/**
+ * Enables or disables tuning of the read intervals based on how quickly each
+ * reading is changing. When enabled, samples that are holding steady are read
+ * less often, leaving more of the serial link's bandwidth for those that are
+ * moving.
+ */
+void CUXInterface::setAdaptiveReadIntervals(bool adaptive)
+{
+  m_scheduler.setAdaptive(adaptive);
+}
+
 #ifdef ENABLE_FORCE_OPEN_LOOP
 /**
  * Resets the long term lambda trim to the midpoint value
  */
 void CUXInterface::onForceOpenLoopRequest(bool forceOpen)
 {
-  if (c14cux_isConnected(&m_cuxinfo))
+  if (m_transport->isConnected())
   {
     uint8_t byte87 = 0x00;
 
-    if (c14cux_readMem(&m_cuxinfo, 0x0087, 1, &byte87))
+    if (m_transport->readMem(0x0087, 1, &byte87))
     {
       if (forceOpen)
       {
@@ -943,7 +1811,7 @@ void CUXInterface::onForceOpenLoopRequest(bool forceOpen)
         byte87 &= 0xEF;
       }
 
-      c14cux_writeMem(&m_cuxinfo, 0x0087, byte87);
+      m_transport->writeMem(0x0087, byte87);
     }
   }
 }
@@ -952,95 +1820,95 @@ void CUXInterface::onForceOpenLoopRequest(bool forceOpen)
 #ifdef ENABLE_SIM_MODE
 void CUXInterface::onSimModeWriteRequest(bool enableSimMode, SimulationInputValues simVals, SimulationInputChanges changes)
 {
-  if (c14cux_connect(&m_cuxinfo, m_deviceName.toStdString().c_str()))
+  if (m_transport->connect(m_deviceName, m_baudRate))
   {
     bool success = true;
 
     if (changes.inertiaSwitch)
     {
-      success &= c14cux_writeMem(&m_cuxinfo, 0x2060, simVals.inertiaSwitch);
+      success &= m_transport->writeMem(0x2060, simVals.inertiaSwitch);
     }
 
     if (changes.heatedScreen)
     {
-      success &= c14cux_writeMem(&m_cuxinfo, 0x2061, simVals.heatedScreen);
+      success &= m_transport->writeMem(0x2061, simVals.heatedScreen);
     }
 
     if (changes.maf)
     {
-      success &= c14cux_writeMem(&m_cuxinfo, 0x2062, (uint8_t)((simVals.maf & (0xFF00)) >> 8));
-      success &= c14cux_writeMem(&m_cuxinfo, 0x2063, (uint8_t)(simVals.maf & (0x00FF)));
+      success &= m_transport->writeMem(0x2062, (uint8_t)((simVals.maf & (0xFF00)) >> 8));
+      success &= m_transport->writeMem(0x2063, (uint8_t)(simVals.maf & (0x00FF)));
     }
 
     if (changes.throttle)
     {
-      success &= c14cux_writeMem(&m_cuxinfo, 0x2064, (uint8_t)((simVals.throttle & (0xFF00)) >> 8));
-      success &= c14cux_writeMem(&m_cuxinfo, 0x2065, (uint8_t)(simVals.throttle & (0x00FF)));
+      success &= m_transport->writeMem(0x2064, (uint8_t)((simVals.throttle & (0xFF00)) >> 8));
+      success &= m_transport->writeMem(0x2065, (uint8_t)(simVals.throttle & (0x00FF)));
     }
 
     if (changes.coolantTemp)
     {
-      success &= c14cux_writeMem(&m_cuxinfo, 0x2066, simVals.coolantTemp);
+      success &= m_transport->writeMem(0x2066, simVals.coolantTemp);
     }
 
     if (changes.neutralSwitch)
     {
-      success &= c14cux_writeMem(&m_cuxinfo, 0x2067, simVals.neutralSwitch);
+      success &= m_transport->writeMem(0x2067, simVals.neutralSwitch);
     }
 
     if (changes.airConLoad)
     {
-      success &= c14cux_writeMem(&m_cuxinfo, 0x2068, simVals.airConLoad);
+      success &= m_transport->writeMem(0x2068, simVals.airConLoad);
     }
 
     if (changes.mainRelay)
     {
-      success &= c14cux_writeMem(&m_cuxinfo, 0x206A, simVals.mainRelay);
+      success &= m_transport->writeMem(0x206A, simVals.mainRelay);
     }
 
     if (changes.mafTrim)
     {
-      success &= c14cux_writeMem(&m_cuxinfo, 0x206B, simVals.mafTrim);
+      success &= m_transport->writeMem(0x206B, simVals.mafTrim);
     }
 
     if (changes.tuneResistor)
     {
-      success &= c14cux_writeMem(&m_cuxinfo, 0x206C, simVals.tuneResistor);
+      success &= m_transport->writeMem(0x206C, simVals.tuneResistor);
     }
 
     if (changes.fuelTemp)
     {
-      success &= c14cux_writeMem(&m_cuxinfo, 0x206D, simVals.fuelTemp);
+      success &= m_transport->writeMem(0x206D, simVals.fuelTemp);
     }
 
     if (changes.o2OddDutyCycle)
     {
-      success &= c14cux_writeMem(&m_cuxinfo, 0x206E, simVals.o2OddDutyCycle);
+      success &= m_transport->writeMem(0x206E, simVals.o2OddDutyCycle);
     }
 
     if (changes.o2SensorReference)
     {
-      success &= c14cux_writeMem(&m_cuxinfo, 0x206F, simVals.o2SensorReference);
+      success &= m_transport->writeMem(0x206F, simVals.o2SensorReference);
     }
 
     if (changes.diagnosticPlug)
     {
-      success &= c14cux_writeMem(&m_cuxinfo, 0x2070, simVals.diagnosticPlug);
+      success &= m_transport->writeMem(0x2070, simVals.diagnosticPlug);
     }
 
     if (changes.o2EvenDutyCycle)
     {
-      success &= c14cux_writeMem(&m_cuxinfo, 0x2071, simVals.o2EvenDutyCycle);
+      success &= m_transport->writeMem(0x2071, simVals.o2EvenDutyCycle);
     }
 
     if (enableSimMode && success)
     {
       // write the magic pattern to turn on simulation mode
-      success &= c14cux_writeMem(&m_cuxinfo, 0x2072, 0x55);
+      success &= m_transport->writeMem(0x2072, 0x55);
 
       // clear any fault codes that were set as a result of running the ECU
       // with sensors missing from the harness
-      success &= c14cux_clearFaultCodes(&m_cuxinfo);
+      success &= m_transport->clearFaultCodes();
     }
 
     if (success)
@@ -5,9 +5,23 @@
 #include <QString>
 #include <QHash>
 #include <QByteArray>
+#include <QVector>
 #include <QMap>
+#include <QPair>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QDateTime>
+#include <QMutex>
 #include "comm14cux.h"
 #include "commonunits.h"
+#include "samplescheduler.h"
+#include "readplan.h"
+#include "ecusample.h"
+#include "triplebuffer.h"
+#include "linkmetrics.h"
+#include "fuelmapresidency.h"
+#include "ecudatacache.h"
+#include "ecutransport.h"
 
 static const unsigned int fuelMapCount = 6;
 
@@ -22,7 +36,7 @@ class CUXInterface : public QObject
 
   Q_OBJECT
 public:
-  explicit CUXInterface(QString device, unsigned int baud, SpeedUnits sUnits,
+  explicit CUXInterface(EcuTransport* transport, QString device, unsigned int baud, SpeedUnits sUnits,
                         TemperatureUnits tUnits, bool fuelMapRefresh, QObject* parent = 0);
   ~CUXInterface();
 
@@ -36,10 +50,7 @@ public:
     m_baudRate = baud;
   }
 
-  void setLambdaTrimType(c14cux_lambda_trim_type type)
-  {
-    m_lambdaTrimType = type;
-  }
+  void setLambdaTrimType(c14cux_lambda_trim_type type);
 
   void setMAFReadingType(c14cux_airflow_type type)
   {
@@ -53,6 +64,8 @@ public:
 
   void setEnabledSamples(QMap<SampleType, bool> samples);
   void setReadIntervals(QHash<SampleType, unsigned int> intervals);
+  void setReadIntervalBounds(QHash<SampleType, QPair<unsigned int, unsigned int> > bounds);
+  void setAdaptiveReadIntervals(bool adaptive);
 
   QString getSerialDevice() const
   {
@@ -60,47 +73,29 @@ public:
   }
 
   bool isConnected();
-  void disconnectFromECU();
-
-  c14cux_feedback_mode getFeedbackMode() const
-  {
-    return m_feedbackMode;
-  }
-
-  unsigned int getRoadSpeed() const
-  {
-    return (m_speedUnits == MPH) ? m_roadSpeedMPH : convertSpeed(m_roadSpeedMPH);
-  }
-
-  int getEngineSpeedRPM() const
-  {
-    return m_engineSpeedRPM;
-  }
 
-  int getTargetIdleSpeed() const
-  {
-    return m_targetIdleSpeed;
-  }
+  const EcuSample& getLatestSample();
+  void setSampleSink(EcuSampleSink* sink);
 
-  int getCoolantTemp() const
+  QDateTime getClockEpoch() const
   {
-    return convertTemperature(m_coolantTempF);
+    return m_clockEpoch;
   }
 
-  int getFuelTemp() const
+  LinkMetrics* getLinkMetrics()
   {
-    return convertTemperature(m_fuelTempF);
+    return &m_linkMetrics;
   }
 
-  float getThrottlePos() const
+  FuelMapResidency* getFuelMapResidency()
   {
-    return m_throttlePos;
+    return &m_fuelMapResidency;
   }
 
-  c14cux_gear getGear() const
-  {
-    return m_gear;
-  }
+  unsigned int convertSpeed(unsigned int speedMph) const;
+  int convertTemperature(int tempF) const;
+  static unsigned int convertSpeed(unsigned int speedMph, SpeedUnits units);
+  static int convertTemperature(int tempF, TemperatureUnits units);
 
   c14cux_faultcodes getFaultCodes() const
   {
@@ -112,11 +107,6 @@ public:
     return m_batteryBackedMem;
   }
 
-  float getMainVoltage() const
-  {
-    return m_mainVoltage;
-  }
-
   c14cux_version getVersion() const
   {
     return c14cux_getLibraryVersion();
@@ -131,96 +121,11 @@ public:
     return m_rpmTable;
   }
 
-  int getCurrentFuelMapIndex() const
-  {
-    return m_currentFuelMapIndex;
-  }
-
-  int getFuelMapRowIndex() const
-  {
-    return m_currentFuelMapRowIndex;
-  }
-
-  int getFuelMapRowWeighting() const
-  {
-    return m_fuelMapRowWeighting;
-  }
-
-  int getFuelMapColumnIndex() const
-  {
-    return m_currentFuelMapColumnIndex;
-  }
-
-  int getFuelMapColWeighting() const
-  {
-    return m_fuelMapColWeighting;
-  }
-
-  float getMAFReading() const
-  {
-    return m_mafReading;
-  }
-
-  float getIdleBypassPos() const
-  {
-    return m_idleBypassPos;
-  }
-
-  bool getFuelPumpRelayState() const
-  {
-    return m_fuelPumpRelayOn;
-  }
-
   QByteArray* getROMImage() const
   {
     return m_romImage;
   }
 
-  int getLambdaTrimOdd() const
-  {
-    return m_lambdaTrimOdd;
-  }
-
-  int getLambdaTrimEven() const
-  {
-    return m_lambdaTrimEven;
-  }
-
-  float getCOTrimVoltage() const
-  {
-    return m_coTrimVoltage;
-  }
-
-  bool isMILOn() const
-  {
-    return m_milOn;
-  }
-
-  bool getIdleMode() const
-  {
-    return m_idleMode;
-  }
-
-  float getInjectorPulseWidthMs() const
-  {
-    return m_injectorPulseWidthMs;
-  }
-
-  uint16_t getTune() const
-  {
-    return m_tune;
-  }
-
-  uint8_t getChecksumFixer() const
-  {
-    return m_checksumFixer;
-  }
-
-  uint16_t getIdent() const
-  {
-    return m_ident;
-  }
-
   uint8_t getRowScaler(unsigned int fuelMapId) const
   {
     return m_rowScaler[fuelMapId];
@@ -241,10 +146,7 @@ public:
     m_tempUnits = units;
   }
 
-  void setPeriodicFuelMapRefresh(bool on)
-  {
-    m_fuelMapRefresh = on;
-  }
+  void setPeriodicFuelMapRefresh(bool on);
 
   void cancelRead();
 
@@ -261,6 +163,7 @@ public slots:
   void onFuelMapRequested(unsigned int fuelMapId);
   void onReadROMImageRequested();
   void onStartPollingRequest();
+  void onDisconnectRequest();
   void onShutdownThreadRequest();
   void onFuelPumpRunRequest();
   void onIdleAirControlMovementRequest(int direction, int steps);
@@ -271,6 +174,9 @@ public slots:
   void onSimModeWriteRequest(bool enableSimMode, SimulationInputValues simVals, SimulationInputChanges changes);
 #endif
 
+private slots:
+  void onPollTimerExpired();
+
 signals:
   void dataReady();
   void connected();
@@ -288,6 +194,7 @@ signals:
   void rpmLimitReady(int rpmLimiter);
   void rpmTableReady();
   void revisionNumberReady(int tuneRevisionNum, int checksumfixer, int ident);
+  void romImageProgress(int bytesRead, int totalBytes);
   void romImageReady();
   void romImageReadFailed();
   void failedToConnect(QString dev);
@@ -305,19 +212,58 @@ signals:
 private:
   static const int s_firstOpenLoopMap = 1;
   static const int s_lastOpenLoopMap = 3;
+  static const int s_idlePollIntervalMs = 100;
+
+  // longest interval between fuel map position readings that is credited to
+  // the residency map, so that pauses in polling aren't counted
+  static const qint64 s_maxResidencyIntervalUs = 1000000;
+
+  // The ROM image is read a chunk at a time between polling passes, so that
+  // the live readings keep updating while it's read. A chunk that fails is
+  // retried this many times before the read is abandoned.
+  static const uint16_t s_romBaseAddress = 0xC000;
+  static const int s_romChunkSize = 256;
+  static const int s_romChunkCount = EcuTransport::s_romSize / s_romChunkSize;
+  static const int s_maxROMChunkAttempts = 3;
 
   QString m_deviceName;
   unsigned int m_baudRate;
-  c14cux_info m_cuxinfo;
-  bool m_stopPolling;
-  bool m_shutdownThread;
+  EcuTransport* m_transport;
+  bool m_polling;
+  QTimer* m_pollTimer;
   c14cux_faultcodes m_faultCodes;
   QByteArray* m_batteryBackedMem;
   bool m_readCanceled;
   bool m_readTuneId;
   QHash<SampleType, bool> m_enabledSamples;
-  QHash<SampleType, qint64> m_lastReadTime;
-  QHash<SampleType, unsigned int> m_readIntervals;
+  SampleScheduler m_scheduler;
+  ReadPlan m_readPlan;
+  QElapsedTimer m_clock;
+  QDateTime m_clockEpoch;
+  qint64 m_readTimeUs[SampleType_NumSampleTypes];
+  quint64 m_sampleSequence;
+  TripleBuffer<EcuSample> m_samples;
+  EcuSampleSink* m_sampleSink;
+  QMutex m_sampleSinkLock;
+  LinkMetrics m_linkMetrics;
+  FuelMapResidency m_fuelMapResidency;
+  qint64 m_lastResidencyTimeUs;
+
+  // fuel map position (and lambda trims) at the previous residency reading,
+  // which is credited with the time until the next reading
+  struct ResidencyPosition
+  {
+    bool valid;
+    uint8_t fuelMapIndex;
+    uint8_t row;
+    uint8_t rowWeighting;
+    uint8_t col;
+    uint8_t colWeighting;
+    bool trimValid;
+    int16_t trimOdd;
+    int16_t trimEven;
+  };
+  ResidencyPosition m_lastResidencyPosition;
 
   c14cux_lambda_trim_type m_lambdaTrimType;
   c14cux_feedback_mode m_feedbackMode;
@@ -354,13 +300,25 @@ private:
   uint16_t m_ident;
   uint8_t m_rowScaler[fuelMapCount];
   uint16_t m_mafScaler;
+  bool m_mafScalerVerified;
 
   QByteArray* m_romImage;
+  QByteArray m_romReadBuffer;
+  QVector<bool> m_romChunkRead;
+  bool m_romReadInProgress;
+  bool m_romCacheCheckInProgress;
+  int m_romChunkFailures;
+  quint64 m_romReadTuneKey;
 
   QByteArray m_fuelMaps[fuelMapCount];
   bool m_fuelMapDataIsCurrent[fuelMapCount];
   uint16_t m_fuelMapAdjFactors[fuelMapCount];
+  bool m_fuelMapVerified[fuelMapCount];
+  quint32 m_fuelMapChangeCount;
   c14cux_rpmtable m_rpmTable;
+  bool m_rpmTableIsCurrent;
+  bool m_rpmTableVerified;
+  EcuDataCache m_dataCache;
 
   SpeedUnits m_speedUnits;
   TemperatureUnits m_tempUnits;
@@ -370,17 +328,35 @@ private:
   bool m_rpmLimitRead;
 
   void zeroDisabledSamples();
-  void runServiceLoop();
+  void stopPolling();
   void clearFlagsAndData();
   ReadResult readData();
-  bool readFuelMap(unsigned int fuelMapId);
+  ReadResult readSample(SampleType type);
+  ReadResult readBlock(const ReadPlan::Block& block);
+  void decodeSample(SampleType type, const uint8_t* data);
+  void checkForRPMLimit();
+  void reportSampleValue(SampleType type);
+  double getSampleValue(SampleType type, double* secondValue) const;
+  bool readFuelMapIndex();
+  bool readFuelMap(unsigned int fuelMapId, bool* changed = 0);
+  bool readRPMTable(bool* changed = 0);
+  void startROMRead();
+  void readROMChunk();
+  void checkROMCache();
+  void passOnCachedROMImage();
+  int romBytesRead() const;
+  quint64 tuneKey() const;
+  void loadCachedData();
+  bool verifyCachedData();
+  bool cachedDataIsVerified() const;
   bool connectToECU();
-  unsigned int convertSpeed(unsigned int speedMph) const;
-  int convertTemperature(int tempF) const;
+  void publishSample();
+  void updateFuelMapResidency();
+  qint64 elapsedUs() const;
   static ReadResult mergeResult(ReadResult total, ReadResult single);
   static ReadResult mergeResult(ReadResult total, bool single);
-  bool isDueForMeasurement(SampleType type);
   bool isSampleAppropriateForMode(SampleType type) const;
+  void updateScheduledSamples();
 };
 
 #endif // CUXINTERFACE_H
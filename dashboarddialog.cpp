@@ -0,0 +1,201 @@
+#include <QShowEvent>
+#include <QHideEvent>
+#ifndef QT_NO_OPENGL
+#include <QOpenGLContext>
+#endif
+#include "dashboarddialog.h"
+
+/**
+ * Constructor. Creates the view, choosing OpenGL if it's available.
+ * @param title Title for the dialog window
+ */
+DashboardDialog::DashboardDialog(QString title, QWidget* parent) :
+  QDialog(parent),
+  m_view(0),
+  m_accelerated(false)
+{
+#ifndef QT_NO_OPENGL
+  if (openGLAvailable())
+  {
+    m_view = new GLDashboardView(&m_scene, this);
+    m_accelerated = true;
+  }
+#endif
+
+  if (m_view == 0)
+  {
+    m_view = new RasterDashboardView(&m_scene, this);
+  }
+
+  this->setWindowTitle(title + (m_accelerated ? " (OpenGL)" : ""));
+
+  m_layout = new QVBoxLayout(this);
+  m_layout->setContentsMargins(0, 0, 0, 0);
+  m_layout->addWidget(m_view);
+  m_view->setMinimumSize(400, 300);
+
+  m_hideMainGaugesBox = new QCheckBox("Hide the gauges in the main window while the dashboard is open", this);
+  m_hideMainGaugesBox->setChecked(true);
+  m_layout->addWidget(m_hideMainGaugesBox);
+  connect(m_hideMainGaugesBox, SIGNAL(toggled(bool)), this, SLOT(onHideMainGaugesToggled(bool)));
+
+  resize(800, 340);
+
+  m_frameTimer = new QTimer(this);
+  m_frameTimer->setInterval(s_defaultFrameIntervalMs);
+  connect(m_frameTimer, SIGNAL(timeout()), this, SLOT(onFrameTimerExpired()));
+}
+
+/**
+ * Returns true if an OpenGL context can be created. (On Windows, Qt may
+ * provide this with its software OpenGL renderer when there's no GPU driver.)
+ */
+bool DashboardDialog::openGLAvailable()
+{
+#ifndef QT_NO_OPENGL
+  QOpenGLContext context;
+  return context.create();
+#else
+  return false;
+#endif
+}
+
+/**
+ * Sets the scale of one of the gauges.
+ */
+void DashboardDialog::setGauge(DashboardScene::Gauge gauge, QString label, QString suffix,
+                               double minimum, double maximum, double critical)
+{
+  m_scene.setGauge(gauge, label, suffix, minimum, maximum, critical);
+}
+
+/**
+ * Sets the value of one of the gauges, and starts animating its needle if
+ * the dashboard is visible.
+ */
+void DashboardDialog::setValue(DashboardScene::Gauge gauge, double value)
+{
+  if (m_scene.setValue(gauge, value) && isVisible())
+  {
+    startAnimation();
+  }
+}
+
+/**
+ * Sets the scale, level and text of one of the bars.
+ */
+void DashboardDialog::setBar(DashboardScene::Bar bar, QString label, int minimum, int maximum, int value, QString text)
+{
+  if (m_scene.setBar(bar, label, minimum, maximum, value, text))
+  {
+    redraw();
+  }
+}
+
+/**
+ * Sets the label, colors and state of one of the lamps.
+ */
+void DashboardDialog::setLamp(DashboardScene::Lamp lamp, QString label, QColor onColor, QColor offColor, bool on)
+{
+  if (m_scene.setLamp(lamp, label, onColor, offColor, on))
+  {
+    redraw();
+  }
+}
+
+/**
+ * Sets the label and text of one of the readouts.
+ */
+void DashboardDialog::setReadout(DashboardScene::Readout readout, QString label, QString text)
+{
+  if (m_scene.setReadout(readout, label, text))
+  {
+    redraw();
+  }
+}
+
+/**
+ * Redraws the dashboard once for a change that isn't animated, unless it's
+ * hidden or the frame timer is going to redraw it anyway.
+ */
+void DashboardDialog::redraw()
+{
+  if (isVisible() && !m_frameTimer->isActive())
+  {
+    m_view->update();
+  }
+}
+
+/**
+ * Starts redrawing at the frame rate, if it isn't already.
+ */
+void DashboardDialog::startAnimation()
+{
+  if (!m_frameTimer->isActive())
+  {
+    m_frameClock.start();
+    m_frameTimer->start();
+    m_view->update();
+  }
+}
+
+/**
+ * Sets the rate at which the dashboard is redrawn while the needles move.
+ * @param rateHz Frames per second, or zero for the default rate
+ */
+void DashboardDialog::setFrameRate(unsigned int rateHz)
+{
+  m_frameTimer->setInterval((rateHz > 0) ? qMax(1, (int)(1000 / rateHz)) : s_defaultFrameIntervalMs);
+}
+
+/**
+ * Moves the needles on by the time since the last frame and redraws. Stops
+ * redrawing once every needle has reached its value.
+ */
+void DashboardDialog::onFrameTimerExpired()
+{
+  if (!m_scene.advance(m_frameClock.restart()))
+  {
+    m_frameTimer->stop();
+  }
+
+  m_view->update();
+}
+
+/**
+ * Hides or restores the main window gauges when the box is toggled while the
+ * dashboard is open.
+ */
+void DashboardDialog::onHideMainGaugesToggled(bool checked)
+{
+  if (isVisible())
+  {
+    emit hideMainGauges(checked);
+  }
+}
+
+/**
+ * Brings the needles up to date with any values set while the dashboard was
+ * hidden, and hides the main window gauges if that's been asked for.
+ */
+void DashboardDialog::showEvent(QShowEvent* event)
+{
+  startAnimation();
+  QDialog::showEvent(event);
+
+  if (m_hideMainGaugesBox->isChecked())
+  {
+    emit hideMainGauges(true);
+  }
+}
+
+/**
+ * Stops drawing while the dashboard is hidden, and gives the main window its
+ * gauges back.
+ */
+void DashboardDialog::hideEvent(QHideEvent* event)
+{
+  m_frameTimer->stop();
+  QDialog::hideEvent(event);
+  emit hideMainGauges(false);
+}
@@ -0,0 +1,68 @@
+#ifndef DASHBOARDDIALOG_H
+#define DASHBOARDDIALOG_H
+
+#include <QDialog>
+#include <QVBoxLayout>
+#include <QCheckBox>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QString>
+#include "dashboardview.h"
+
+/**
+ * A resizable window showing the main instruments on one surface. It's drawn with
+ * OpenGL when a context can be created, and with the raster engine otherwise.
+ * While a needle is moving towards a new value the dashboard is redrawn at
+ * the display rate; once the needles settle, nothing is drawn until the next
+ * value arrives. While the dashboard is shown, it can ask for the gauges in
+ * the main window to be hidden so that they aren't also being redrawn.
+ */
+class DashboardDialog : public QDialog
+{
+  Q_OBJECT
+
+public:
+  DashboardDialog(QString title, QWidget* parent = 0);
+
+  void setGauge(DashboardScene::Gauge gauge, QString label, QString suffix,
+                double minimum, double maximum, double critical);
+  void setValue(DashboardScene::Gauge gauge, double value);
+  void setBar(DashboardScene::Bar bar, QString label, int minimum, int maximum, int value, QString text);
+  void setLamp(DashboardScene::Lamp lamp, QString label, QColor onColor, QColor offColor, bool on);
+  void setReadout(DashboardScene::Readout readout, QString label, QString text);
+  void setFrameRate(unsigned int rateHz);
+
+  bool isAccelerated() const
+  {
+    return m_accelerated;
+  }
+
+signals:
+  void hideMainGauges(bool hide);
+
+protected:
+  void showEvent(QShowEvent* event);
+  void hideEvent(QHideEvent* event);
+
+private slots:
+  void onFrameTimerExpired();
+  void onHideMainGaugesToggled(bool checked);
+
+private:
+  DashboardScene m_scene;
+  QWidget* m_view;
+  bool m_accelerated;
+  QVBoxLayout* m_layout;
+  QCheckBox* m_hideMainGaugesBox;
+  QTimer* m_frameTimer;
+  QElapsedTimer m_frameClock;
+
+  // frame period used while the display rate is unlimited
+  static const int s_defaultFrameIntervalMs = 16;
+
+  void startAnimation();
+  void redraw();
+  static bool openGLAvailable();
+};
+
+#endif // DASHBOARDDIALOG_H
@@ -0,0 +1,536 @@
+#include <QPaintEvent>
+#include <QFont>
+#include <QtMath>
+#include "dashboardview.h"
+
+DashboardScene::DashboardScene() :
+  m_facesValid(false)
+{
+  for (int gauge = 0; gauge < Gauge_NumGauges; gauge++)
+  {
+    GaugeState& state = m_gauges[gauge];
+
+    state.minimum = 0.0;
+    state.maximum = 1.0;
+    state.critical = 1.0;
+    state.target = 0.0;
+    state.shown = 0.0;
+  }
+
+  for (int bar = 0; bar < Bar_NumBars; bar++)
+  {
+    m_bars[bar].minimum = 0;
+    m_bars[bar].maximum = 0;
+    m_bars[bar].value = 0;
+  }
+
+  for (int lamp = 0; lamp < Lamp_NumLamps; lamp++)
+  {
+    m_lamps[lamp].on = false;
+  }
+}
+
+/**
+ * Sets the scale of a gauge. The dial faces are only redrawn if something
+ * has actually changed.
+ * @param critical Value from which the readout is shown in red, and the
+ *  scale is marked; no marking is shown if it's outside the scale
+ */
+void DashboardScene::setGauge(Gauge gauge, QString label, QString suffix, double minimum, double maximum, double critical)
+{
+  GaugeState& state = m_gauges[gauge];
+
+  if ((maximum > minimum) &&
+      ((state.label != label) || (state.suffix != suffix) || (state.minimum != minimum) ||
+       (state.maximum != maximum) || (state.critical != critical)))
+  {
+    state.label = label;
+    state.suffix = suffix;
+    state.minimum = minimum;
+    state.maximum = maximum;
+    state.critical = critical;
+    m_facesValid = false;
+  }
+}
+
+/**
+ * Sets the value that a gauge's needle moves towards. The readout shows the
+ * new value straight away.
+ * @return True if the value has changed
+ */
+bool DashboardScene::setValue(Gauge gauge, double value)
+{
+  if (m_gauges[gauge].target == value)
+  {
+    return false;
+  }
+
+  m_gauges[gauge].target = value;
+  return true;
+}
+
+/**
+ * Sets the scale, level and text of one of the bars. A bar with an empty
+ * range shows only its text.
+ * @return True if anything has changed
+ */
+bool DashboardScene::setBar(Bar bar, QString label, int minimum, int maximum, int value, QString text)
+{
+  BarState& state = m_bars[bar];
+
+  if ((state.label != label) || (state.minimum != minimum) || (state.maximum != maximum))
+  {
+    state.label = label;
+    state.minimum = minimum;
+    state.maximum = maximum;
+    m_facesValid = false;
+  }
+  else if ((state.value == value) && (state.text == text))
+  {
+    return false;
+  }
+
+  state.value = value;
+  state.text = text;
+  return true;
+}
+
+/**
+ * Sets the label, colors and state of one of the lamps.
+ * @return True if anything has changed
+ */
+bool DashboardScene::setLamp(Lamp lamp, QString label, QColor onColor, QColor offColor, bool on)
+{
+  LampState& state = m_lamps[lamp];
+
+  if (state.label != label)
+  {
+    state.label = label;
+    m_facesValid = false;
+  }
+  else if ((state.onColor == onColor) && (state.offColor == offColor) && (state.on == on))
+  {
+    return false;
+  }
+
+  state.onColor = onColor;
+  state.offColor = offColor;
+  state.on = on;
+  return true;
+}
+
+/**
+ * Sets the label and text of one of the readouts.
+ * @return True if anything has changed
+ */
+bool DashboardScene::setReadout(Readout readout, QString label, QString text)
+{
+  ReadoutState& state = m_readouts[readout];
+
+  if (state.label != label)
+  {
+    state.label = label;
+    m_facesValid = false;
+  }
+  else if (state.text == text)
+  {
+    return false;
+  }
+
+  state.text = text;
+  return true;
+}
+
+/**
+ * Moves the needles towards their values.
+ * @param elapsedMs Time since the needles were last moved
+ * @return True if any needle is still moving
+ */
+bool DashboardScene::advance(qint64 elapsedMs)
+{
+  const double step = 1.0 - qExp(-(double)elapsedMs / s_smoothingMs);
+  bool moving = false;
+
+  for (int gauge = 0; gauge < Gauge_NumGauges; gauge++)
+  {
+    GaugeState& state = m_gauges[gauge];
+    const double remaining = state.target - state.shown;
+
+    // snap to the value once the needle is within a fraction of a degree
+    if (qAbs(remaining) <= (state.maximum - state.minimum) / 1000.0)
+    {
+      state.shown = state.target;
+    }
+    else
+    {
+      state.shown += remaining * step;
+      moving = true;
+    }
+  }
+
+  return moving;
+}
+
+/**
+ * Paints all the instruments.
+ */
+void DashboardScene::paint(QPainter& painter, const QRect& rect)
+{
+  const int ratio = painter.device()->devicePixelRatio();
+  const QRect dials = dialArea(rect);
+
+  if (!m_facesValid || (m_faces.size() != rect.size() * ratio))
+  {
+    // the image is drawn at the top left of the rectangle, so the faces are
+    // laid out in a rectangle of the same size at the origin
+    const QRect imageRect(QPoint(0, 0), rect.size());
+    const QRect imageDials = dialArea(imageRect);
+
+    m_faces = QImage(rect.size() * ratio, QImage::Format_ARGB32_Premultiplied);
+    m_faces.setDevicePixelRatio(ratio);
+    m_faces.fill(Qt::transparent);
+
+    QPainter facePainter(&m_faces);
+    facePainter.setRenderHint(QPainter::Antialiasing);
+    facePainter.setRenderHint(QPainter::TextAntialiasing);
+
+    for (int gauge = 0; gauge < Gauge_NumGauges; gauge++)
+    {
+      paintFace(facePainter, m_gauges[gauge], gaugeRect(gauge, imageDials.size()).translated(imageDials.topLeft()));
+    }
+    for (int bar = 0; bar < Bar_NumBars; bar++)
+    {
+      paintBarFace(facePainter, m_bars[bar], stripCell(bar, imageRect));
+    }
+    for (int lamp = 0; lamp < Lamp_NumLamps; lamp++)
+    {
+      paintLampFace(facePainter, m_lamps[lamp], stripCell(Bar_NumBars + lamp, imageRect));
+    }
+    for (int readout = 0; readout < Readout_NumReadouts; readout++)
+    {
+      paintReadoutFace(facePainter, m_readouts[readout], stripCell(Bar_NumBars + Lamp_NumLamps + readout, imageRect));
+    }
+    m_facesValid = true;
+  }
+
+  painter.setRenderHint(QPainter::Antialiasing);
+  painter.setRenderHint(QPainter::TextAntialiasing);
+  painter.drawImage(rect.topLeft(), m_faces);
+
+  for (int gauge = 0; gauge < Gauge_NumGauges; gauge++)
+  {
+    paintNeedle(painter, m_gauges[gauge], gaugeRect(gauge, dials.size()).translated(dials.topLeft()));
+  }
+  for (int bar = 0; bar < Bar_NumBars; bar++)
+  {
+    paintBarLevel(painter, m_bars[bar], stripCell(bar, rect));
+  }
+  for (int lamp = 0; lamp < Lamp_NumLamps; lamp++)
+  {
+    paintLamp(painter, m_lamps[lamp], stripCell(Bar_NumBars + lamp, rect));
+  }
+  for (int readout = 0; readout < Readout_NumReadouts; readout++)
+  {
+    paintReadout(painter, m_readouts[readout], stripCell(Bar_NumBars + Lamp_NumLamps + readout, rect));
+  }
+}
+
+/**
+ * Returns the part of the dashboard occupied by the dials: everything above
+ * the strip of bars, lamps and readouts.
+ */
+QRect DashboardScene::dialArea(const QRect& rect)
+{
+  return QRect(rect.x(), rect.y(), rect.width(), rect.height() - (rect.height() / 3));
+}
+
+/**
+ * Returns a cell of the strip along the bottom of the dashboard. The strip
+ * has two rows: the bars, then the lamps followed by the readouts.
+ */
+QRectF DashboardScene::stripCell(int cell, const QRect& rect)
+{
+  const double stripHeight = rect.height() / 3;
+  const double cellWidth = (double)rect.width() / s_stripColumns;
+  const double cellHeight = stripHeight / 2;
+
+  return QRectF(rect.x() + ((cell % s_stripColumns) * cellWidth),
+                rect.y() + (rect.height() - stripHeight) + ((cell / s_stripColumns) * cellHeight),
+                cellWidth, cellHeight).adjusted(6, 2, -6, -2);
+}
+
+/**
+ * Returns the square occupied by a gauge: the gauges are laid out in a row
+ * if there's room, and in a 2x2 grid otherwise.
+ */
+QRectF DashboardScene::gaugeRect(int gauge, const QSize& size) const
+{
+  const int columns = (size.width() >= 2 * size.height()) ? Gauge_NumGauges : 2;
+  const int rows = Gauge_NumGauges / columns;
+  const double cellWidth = (double)size.width() / columns;
+  const double cellHeight = (double)size.height() / rows;
+  const double side = qMin(cellWidth, cellHeight);
+
+  return QRectF(((gauge % columns) * cellWidth) + ((cellWidth - side) / 2),
+                ((gauge / columns) * cellHeight) + ((cellHeight - side) / 2),
+                side, side);
+}
+
+/**
+ * Paints the parts of a gauge that don't change with its value. Gauges are
+ * drawn on a 220-unit square centered on the origin.
+ */
+void DashboardScene::paintFace(QPainter& painter, const GaugeState& state, const QRectF& rect)
+{
+  const double divisor = (state.maximum >= 1000.0) ? 1000.0 : 1.0;
+  QFont font;
+
+  painter.save();
+  painter.translate(rect.center());
+  painter.scale(rect.width() / 220.0, rect.width() / 220.0);
+
+  painter.setPen(QPen(QColor(90, 90, 90), 6));
+  painter.setBrush(QColor(20, 20, 20));
+  painter.drawEllipse(QPointF(0, 0), 104, 104);
+
+  // QPainter arcs run anticlockwise from three o'clock, in 16ths of a degree,
+  // while needle angles run clockwise from twelve o'clock
+  if ((state.critical > state.minimum) && (state.critical < state.maximum))
+  {
+    const double start = needleAngle(state, state.critical);
+    const double end = needleAngle(state, state.maximum);
+
+    painter.setPen(QPen(QColor(200, 0, 0), 8, Qt::SolidLine, Qt::FlatCap));
+    painter.setBrush(Qt::NoBrush);
+    painter.drawArc(QRectF(-88, -88, 176, 176), qRound((90.0 - start) * 16), qRound((start - end) * 16));
+  }
+
+  font.setPixelSize(15);
+  painter.setFont(font);
+
+  for (int tick = 0; tick <= 40; tick++)
+  {
+    const double value = state.minimum + ((state.maximum - state.minimum) * tick) / 40.0;
+    const double angle = needleAngle(state, value);
+    const bool major = ((tick % 5) == 0);
+
+    painter.save();
+    painter.rotate(angle);
+    painter.setPen(QPen(Qt::white, major ? 3 : 1));
+    painter.drawLine(QPointF(0, -96), QPointF(0, major ? -82 : -90));
+    painter.restore();
+
+    if (major)
+    {
+      const double radians = qDegreesToRadians(angle);
+      const QPointF pos(66 * qSin(radians), -66 * qCos(radians));
+
+      painter.setPen(Qt::white);
+      painter.drawText(QRectF(pos.x() - 20, pos.y() - 10, 40, 20), Qt::AlignCenter,
+                       QString::number(value / divisor));
+    }
+  }
+
+  font.setPixelSize(13);
+  painter.setFont(font);
+  painter.setPen(QColor(180, 180, 180));
+  painter.drawText(QRectF(-70, 22, 140, 20), Qt::AlignCenter,
+                   (divisor > 1.0) ? (state.label + " (x1000)") : state.label);
+
+  painter.restore();
+}
+
+/**
+ * Paints the needle and the readout of a gauge.
+ */
+void DashboardScene::paintNeedle(QPainter& painter, const GaugeState& state, const QRectF& rect)
+{
+  static const QPointF needle[4] =
+  {
+    QPointF(-3.5, 14), QPointF(-1.5, -92), QPointF(1.5, -92), QPointF(3.5, 14)
+  };
+  QFont font;
+
+  painter.save();
+  painter.translate(rect.center());
+  painter.scale(rect.width() / 220.0, rect.width() / 220.0);
+
+  font.setPixelSize(22);
+  font.setBold(true);
+  painter.setFont(font);
+  painter.setPen((state.target >= state.critical) ? QColor(255, 60, 60) : QColor(Qt::white));
+  painter.drawText(QRectF(-70, 44, 140, 30), Qt::AlignCenter, QString::number(qRound(state.target)) + state.suffix);
+
+  painter.rotate(needleAngle(state, state.shown));
+  painter.setPen(Qt::NoPen);
+  painter.setBrush(QColor(255, 120, 0));
+  painter.drawConvexPolygon(needle, 4);
+  painter.setBrush(QColor(70, 70, 70));
+  painter.drawEllipse(QPointF(0, 0), 10, 10);
+
+  painter.restore();
+}
+
+/**
+ * Returns the part of a bar's cell that holds the bar itself.
+ */
+QRectF DashboardScene::barRect(const QRectF& cell)
+{
+  return QRectF(cell.left(), cell.top() + (cell.height() * 0.5), cell.width(), cell.height() * 0.45);
+}
+
+/**
+ * Paints the label and the empty track of a bar.
+ */
+void DashboardScene::paintBarFace(QPainter& painter, const BarState& state, const QRectF& cell)
+{
+  QFont font;
+
+  font.setPixelSize(qMax(8, (int)(cell.height() * 0.3)));
+  painter.setFont(font);
+  painter.setPen(QColor(180, 180, 180));
+  painter.drawText(QRectF(cell.left(), cell.top(), cell.width(), cell.height() * 0.5),
+                   Qt::AlignLeft | Qt::AlignVCenter, state.label);
+
+  if (state.maximum > state.minimum)
+  {
+    painter.setPen(QColor(90, 90, 90));
+    painter.setBrush(QColor(20, 20, 20));
+    painter.drawRect(barRect(cell));
+  }
+}
+
+/**
+ * Paints the level and the text of a bar. The level is filled in from zero,
+ * so that a bar whose range straddles zero (such as a fuel trim) fills to
+ * either side of its center.
+ */
+void DashboardScene::paintBarLevel(QPainter& painter, const BarState& state, const QRectF& cell)
+{
+  const QRectF track = barRect(cell);
+  QFont font;
+
+  if (state.maximum > state.minimum)
+  {
+    const double range = state.maximum - state.minimum;
+    const double origin = track.left() + track.width() * (qBound(state.minimum, 0, state.maximum) - state.minimum) / range;
+    const double level = track.left() + track.width() * (qBound(state.minimum, state.value, state.maximum) - state.minimum) / range;
+
+    painter.setPen(Qt::NoPen);
+    painter.setBrush(QColor(255, 120, 0));
+    painter.drawRect(QRectF(qMin(origin, level), track.top() + 1, qAbs(level - origin), track.height() - 2));
+  }
+
+  font.setPixelSize(qMax(8, (int)(track.height() * 0.7)));
+  font.setBold(true);
+  painter.setFont(font);
+  painter.setPen(Qt::white);
+  if (state.maximum > state.minimum)
+  {
+    painter.drawText(track, Qt::AlignCenter, state.text);
+  }
+  else
+  {
+    painter.drawText(track, Qt::AlignLeft | Qt::AlignVCenter, state.text);
+  }
+}
+
+/**
+ * Paints the label of a lamp, to the right of where the lamp is drawn.
+ */
+void DashboardScene::paintLampFace(QPainter& painter, const LampState& state, const QRectF& cell)
+{
+  const double diameter = cell.height() * 0.6;
+  QFont font;
+
+  font.setPixelSize(qMax(8, (int)(cell.height() * 0.3)));
+  painter.setFont(font);
+  painter.setPen(QColor(180, 180, 180));
+  painter.drawText(cell.adjusted(diameter + 8, 0, 0, 0), Qt::AlignLeft | Qt::AlignVCenter, state.label);
+}
+
+/**
+ * Paints a lamp, lit or unlit.
+ */
+void DashboardScene::paintLamp(QPainter& painter, const LampState& state, const QRectF& cell)
+{
+  const double radius = cell.height() * 0.3;
+
+  painter.setPen(QPen(QColor(90, 90, 90), 2));
+  painter.setBrush(state.on ? state.onColor : state.offColor);
+  painter.drawEllipse(QPointF(cell.left() + radius + 1, cell.center().y()), radius, radius);
+}
+
+/**
+ * Paints the label of a readout.
+ */
+void DashboardScene::paintReadoutFace(QPainter& painter, const ReadoutState& state, const QRectF& cell)
+{
+  QFont font;
+
+  font.setPixelSize(qMax(8, (int)(cell.height() * 0.3)));
+  painter.setFont(font);
+  painter.setPen(QColor(180, 180, 180));
+  painter.drawText(QRectF(cell.left(), cell.top(), cell.width(), cell.height() * 0.5),
+                   Qt::AlignLeft | Qt::AlignVCenter, state.label);
+}
+
+/**
+ * Paints the text of a readout, below its label.
+ */
+void DashboardScene::paintReadout(QPainter& painter, const ReadoutState& state, const QRectF& cell)
+{
+  QFont font;
+
+  font.setPixelSize(qMax(8, (int)(cell.height() * 0.35)));
+  font.setBold(true);
+  painter.setFont(font);
+  painter.setPen(Qt::white);
+  painter.drawText(QRectF(cell.left(), cell.top() + (cell.height() * 0.5), cell.width(), cell.height() * 0.5),
+                   Qt::AlignLeft | Qt::AlignVCenter, state.text);
+}
+
+/**
+ * Returns the angle of the needle for a value, in degrees clockwise from
+ * twelve o'clock. The scale sweeps 240 degrees.
+ */
+double DashboardScene::needleAngle(const GaugeState& state, double value)
+{
+  value = qBound(state.minimum, value, state.maximum);
+  return -120.0 + (240.0 * (value - state.minimum)) / (state.maximum - state.minimum);
+}
+
+#ifndef QT_NO_OPENGL
+GLDashboardView::GLDashboardView(DashboardScene* scene, QWidget* parent) :
+  QOpenGLWidget(parent),
+  m_scene(scene)
+{
+  // the GL paint engine only antialiases with multisampling
+  QSurfaceFormat surfaceFormat = format();
+  surfaceFormat.setSamples(4);
+  setFormat(surfaceFormat);
+}
+
+void GLDashboardView::paintGL()
+{
+  QPainter painter(this);
+
+  painter.fillRect(rect(), palette().window());
+  m_scene->paint(painter, rect());
+}
+#endif
+
+RasterDashboardView::RasterDashboardView(DashboardScene* scene, QWidget* parent) :
+  QWidget(parent),
+  m_scene(scene)
+{
+  setAttribute(Qt::WA_OpaquePaintEvent);
+}
+
+void RasterDashboardView::paintEvent(QPaintEvent*)
+{
+  QPainter painter(this);
+
+  painter.fillRect(rect(), palette().window());
+  m_scene->paint(painter, rect());
+}
@@ -0,0 +1,172 @@
+#ifndef DASHBOARDVIEW_H
+#define DASHBOARDVIEW_H
+
+#include <QWidget>
+#include <QPainter>
+#include <QImage>
+#include <QString>
+#include <QColor>
+#ifndef QT_NO_OPENGL
+#include <QOpenGLWidget>
+#include <QSurfaceFormat>
+#endif
+
+/**
+ * The instruments shown on the dashboard, and how to draw them: the dials,
+ * and below them a strip of bars, lamps and text readouts. Everything is
+ * painted in one pass: the parts that don't change with the readings (dial
+ * faces, labels and empty bars) from a single cached image, then the needles,
+ * bar levels, lamps and values. Needles move smoothly towards each new value
+ * rather than jumping, so that the display doesn't look stepped between
+ * samples.
+ */
+class DashboardScene
+{
+public:
+  enum Gauge
+  {
+    Gauge_RoadSpeed,
+    Gauge_EngineSpeed,
+    Gauge_WaterTemp,
+    Gauge_FuelTemp,
+    Gauge_NumGauges
+  };
+
+  enum Bar
+  {
+    Bar_Throttle,
+    Bar_MAF,
+    Bar_IdleBypass,
+    Bar_InjectorDutyCycle,
+    Bar_LambdaTrimOdd,
+    Bar_LambdaTrimEven,
+    Bar_NumBars
+  };
+
+  enum Lamp
+  {
+    Lamp_MIL,
+    Lamp_IdleMode,
+    Lamp_FuelPumpRelay,
+    Lamp_NumLamps
+  };
+
+  enum Readout
+  {
+    Readout_TargetIdle,
+    Readout_Gear,
+    Readout_MainVoltage,
+    Readout_NumReadouts
+  };
+
+  DashboardScene();
+
+  void setGauge(Gauge gauge, QString label, QString suffix, double minimum, double maximum, double critical);
+  bool setValue(Gauge gauge, double value);
+  bool setBar(Bar bar, QString label, int minimum, int maximum, int value, QString text);
+  bool setLamp(Lamp lamp, QString label, QColor onColor, QColor offColor, bool on);
+  bool setReadout(Readout readout, QString label, QString text);
+  bool advance(qint64 elapsedMs);
+  void paint(QPainter& painter, const QRect& rect);
+
+private:
+  struct GaugeState
+  {
+    QString label;
+    QString suffix;
+    double minimum;
+    double maximum;
+    double critical;
+    double target;
+    double shown;
+  };
+
+  struct BarState
+  {
+    QString label;
+    int minimum;
+    int maximum;
+    int value;
+    QString text;
+  };
+
+  struct LampState
+  {
+    QString label;
+    QColor onColor;
+    QColor offColor;
+    bool on;
+  };
+
+  struct ReadoutState
+  {
+    QString label;
+    QString text;
+  };
+
+  // time constant of the needle movement
+  static const int s_smoothingMs = 60;
+
+  // number of columns in the strip of bars, lamps and readouts
+  static const int s_stripColumns = 6;
+
+  GaugeState m_gauges[Gauge_NumGauges];
+  BarState m_bars[Bar_NumBars];
+  LampState m_lamps[Lamp_NumLamps];
+  ReadoutState m_readouts[Readout_NumReadouts];
+  QImage m_faces;
+  bool m_facesValid;
+
+  static QRect dialArea(const QRect& rect);
+  static QRectF stripCell(int cell, const QRect& rect);
+  QRectF gaugeRect(int gauge, const QSize& size) const;
+  void paintFace(QPainter& painter, const GaugeState& state, const QRectF& rect);
+  void paintNeedle(QPainter& painter, const GaugeState& state, const QRectF& rect);
+  static QRectF barRect(const QRectF& cell);
+  void paintBarFace(QPainter& painter, const BarState& state, const QRectF& cell);
+  void paintBarLevel(QPainter& painter, const BarState& state, const QRectF& cell);
+  void paintLampFace(QPainter& painter, const LampState& state, const QRectF& cell);
+  void paintLamp(QPainter& painter, const LampState& state, const QRectF& cell);
+  void paintReadoutFace(QPainter& painter, const ReadoutState& state, const QRectF& cell);
+  void paintReadout(QPainter& painter, const ReadoutState& state, const QRectF& cell);
+  static double needleAngle(const GaugeState& state, double value);
+};
+
+#ifndef QT_NO_OPENGL
+/**
+ * Draws the dashboard scene with OpenGL.
+ */
+class GLDashboardView : public QOpenGLWidget
+{
+  Q_OBJECT
+
+public:
+  GLDashboardView(DashboardScene* scene, QWidget* parent = 0);
+
+protected:
+  void paintGL();
+
+private:
+  DashboardScene* m_scene;
+};
+#endif
+
+/**
+ * Draws the dashboard scene with the raster paint engine, for machines
+ * without OpenGL.
+ */
+class RasterDashboardView : public QWidget
+{
+  Q_OBJECT
+
+public:
+  RasterDashboardView(DashboardScene* scene, QWidget* parent = 0);
+
+protected:
+  void paintEvent(QPaintEvent* event);
+
+private:
+  DashboardScene* m_scene;
+};
+
+#endif // DASHBOARDVIEW_H
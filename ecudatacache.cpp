@@ -0,0 +1,312 @@
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <string.h>
+#include "ecudatacache.h"
+
+const char EcuDataCache::s_fileSuffix[] = ".cache";
+
+EcuDataCache::EcuDataCache() :
+  m_dirty(false)
+{
+  clear();
+}
+
+/**
+ * Returns the directory in which cache entries are kept.
+ */
+QString EcuDataCache::cacheDirectory()
+{
+  return QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+}
+
+/**
+ * Discards the data held in memory.
+ */
+void EcuDataCache::clear()
+{
+  for (int idx = 0; idx < s_numFuelMaps; idx++)
+  {
+    m_fuelMaps[idx].valid = false;
+    m_fuelMaps[idx].adjFactor = 0;
+    m_fuelMaps[idx].rowScaler = 0;
+    m_fuelMaps[idx].data.clear();
+  }
+
+  m_mafScalerValid = false;
+  m_mafScaler = 0;
+  m_rpmTableValid = false;
+  memset(&m_rpmTable, 0, sizeof(m_rpmTable));
+  m_romImage.clear();
+  m_dirty = false;
+}
+
+/**
+ * Selects the cache entry for an ECU and loads whatever has been stored for
+ * it. Any entry that was already open is saved and closed first.
+ * @return True if a stored entry was found; false otherwise (in which case
+ *  the entry starts out empty, and is written when it's first saved)
+ */
+bool EcuDataCache::open(uint16_t tune, uint8_t checksumFixer, uint16_t ident)
+{
+  const QString dirName = cacheDirectory();
+
+  if (dirName.isEmpty())
+  {
+    close();
+    return false;
+  }
+
+  return openFile(QDir(dirName).filePath(QString("R%1-%2-%3")
+                                         .arg(tune, 4, 10, QChar('0'))
+                                         .arg(checksumFixer, 2, 16, QChar('0'))
+                                         .arg(ident, 4, 16, QChar('0')).toUpper() + s_fileSuffix));
+}
+
+/**
+ * Opens a cache entry by the name of its file, as returned by
+ * entryFileNames(). Any entry that was already open is saved and closed first.
+ * @return True if the entry was loaded; false otherwise
+ */
+bool EcuDataCache::openFile(QString fileName)
+{
+  close();
+
+  m_fileName = fileName;
+  return load();
+}
+
+/**
+ * Returns the full paths of all the entries in the cache directory.
+ */
+QStringList EcuDataCache::entryFileNames()
+{
+  QStringList fileNames;
+  const QDir dir(cacheDirectory());
+
+  if (!cacheDirectory().isEmpty())
+  {
+    foreach(const QString& name, dir.entryList(QStringList() << (QString("*") + s_fileSuffix), QDir::Files))
+    {
+      fileNames.append(dir.filePath(name));
+    }
+  }
+
+  return fileNames;
+}
+
+/**
+ * Saves any changes to the open entry and closes it.
+ */
+void EcuDataCache::close()
+{
+  if (isOpen())
+  {
+    save();
+  }
+
+  m_fileName.clear();
+  clear();
+}
+
+/**
+ * Reads the open entry from disk. An entry that's unreadable or in an
+ * unexpected format is ignored, and will be overwritten when next saved.
+ * @return True if the entry was loaded; false otherwise
+ */
+bool EcuDataCache::load()
+{
+  QFile file(m_fileName);
+
+  if (!file.open(QFile::ReadOnly))
+  {
+    return false;
+  }
+
+  QDataStream in(&file);
+  in.setVersion(QDataStream::Qt_5_0);
+  in.setByteOrder(QDataStream::BigEndian);
+
+  quint32 magic = 0;
+  quint16 version = 0;
+
+  in >> magic >> version;
+
+  if ((magic != s_magic) || (version != s_version))
+  {
+    return false;
+  }
+
+  for (int idx = 0; idx < s_numFuelMaps; idx++)
+  {
+    FuelMap& map = m_fuelMaps[idx];
+    in >> map.valid >> map.adjFactor >> map.rowScaler >> map.data;
+    map.valid = map.valid && (map.data.size() == FUEL_MAP_ROWS * FUEL_MAP_COLUMNS);
+  }
+
+  in >> m_mafScalerValid >> m_mafScaler >> m_rpmTableValid;
+  for (int col = 0; col < FUEL_MAP_COLUMNS; col++)
+  {
+    in >> m_rpmTable.rpm[col];
+  }
+  in >> m_romImage;
+
+  if ((in.status() != QDataStream::Ok) ||
+      (!m_romImage.isEmpty() && (m_romImage.size() != s_romImageSize)))
+  {
+    clear();
+    return false;
+  }
+
+  return true;
+}
+
+/**
+ * Writes the open entry to disk if it has changed since it was loaded. The
+ * new contents replace the old file only once they've been written in full.
+ * @return True if the entry is up to date on disk; false otherwise
+ */
+bool EcuDataCache::save()
+{
+  if (!isOpen() || !m_dirty)
+  {
+    return isOpen();
+  }
+
+  QDir().mkpath(QFileInfo(m_fileName).absolutePath());
+
+  QSaveFile file(m_fileName);
+
+  if (!file.open(QFile::WriteOnly))
+  {
+    return false;
+  }
+
+  QDataStream out(&file);
+  out.setVersion(QDataStream::Qt_5_0);
+  out.setByteOrder(QDataStream::BigEndian);
+
+  out << s_magic << s_version;
+
+  for (int idx = 0; idx < s_numFuelMaps; idx++)
+  {
+    const FuelMap& map = m_fuelMaps[idx];
+    out << map.valid << map.adjFactor << map.rowScaler << map.data;
+  }
+
+  out << m_mafScalerValid << m_mafScaler << m_rpmTableValid;
+  for (int col = 0; col < FUEL_MAP_COLUMNS; col++)
+  {
+    out << m_rpmTable.rpm[col];
+  }
+  out << m_romImage;
+
+  if ((out.status() != QDataStream::Ok) || !file.commit())
+  {
+    return false;
+  }
+
+  m_dirty = false;
+  return true;
+}
+
+/**
+ * Retrieves a cached fuel map.
+ * @return True if the map was cached; false otherwise
+ */
+bool EcuDataCache::getFuelMap(unsigned int fuelMapId, QByteArray& data, uint16_t& adjFactor, uint8_t& rowScaler) const
+{
+  if ((fuelMapId >= (unsigned int)s_numFuelMaps) || !m_fuelMaps[fuelMapId].valid)
+  {
+    return false;
+  }
+
+  data = m_fuelMaps[fuelMapId].data;
+  adjFactor = m_fuelMaps[fuelMapId].adjFactor;
+  rowScaler = m_fuelMaps[fuelMapId].rowScaler;
+  return true;
+}
+
+/**
+ * Stores a fuel map that was read from the ECU.
+ */
+void EcuDataCache::setFuelMap(unsigned int fuelMapId, const QByteArray& data, uint16_t adjFactor, uint8_t rowScaler)
+{
+  if (!isOpen() || (fuelMapId >= (unsigned int)s_numFuelMaps))
+  {
+    return;
+  }
+
+  FuelMap& map = m_fuelMaps[fuelMapId];
+
+  if (!map.valid || (map.data != data) || (map.adjFactor != adjFactor) || (map.rowScaler != rowScaler))
+  {
+    if (map.valid)
+    {
+      m_romImage.clear();
+    }
+
+    map.valid = true;
+    map.data = data;
+    map.adjFactor = adjFactor;
+    map.rowScaler = rowScaler;
+    m_dirty = true;
+  }
+}
+
+bool EcuDataCache::getMAFRowScaler(uint16_t& scaler) const
+{
+  scaler = m_mafScaler;
+  return m_mafScalerValid;
+}
+
+void EcuDataCache::setMAFRowScaler(uint16_t scaler)
+{
+  if (isOpen() && (!m_mafScalerValid || (scaler != m_mafScaler)))
+  {
+    if (m_mafScalerValid)
+    {
+      m_romImage.clear();
+    }
+
+    m_mafScalerValid = true;
+    m_mafScaler = scaler;
+    m_dirty = true;
+  }
+}
+
+bool EcuDataCache::getRPMTable(c14cux_rpmtable& table) const
+{
+  table = m_rpmTable;
+  return m_rpmTableValid;
+}
+
+void EcuDataCache::setRPMTable(const c14cux_rpmtable& table)
+{
+  if (isOpen() && (!m_rpmTableValid || (memcmp(&table, &m_rpmTable, sizeof(table)) != 0)))
+  {
+    if (m_rpmTableValid)
+    {
+      m_romImage.clear();
+    }
+
+    m_rpmTableValid = true;
+    m_rpmTable = table;
+    m_dirty = true;
+  }
+}
+
+/**
+ * Stores a ROM image that was read from the ECU.
+ */
+void EcuDataCache::setROMImage(const QByteArray& image)
+{
+  if (isOpen() && (image.size() == s_romImageSize) && (image != m_romImage))
+  {
+    m_romImage = image;
+    m_dirty = true;
+  }
+}
@@ -0,0 +1,85 @@
+#ifndef ECUDATACACHE_H
+#define ECUDATACACHE_H
+
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include "comm14cux.h"
+
+/**
+ * Keeps a copy on disk of the data read out of the ECU's ROM (fuel maps, the
+ * RPM table, the MAF row scaler, and the full ROM image), so that it can be
+ * shown as soon as an ECU running a known tune is reconnected instead of
+ * waiting for it to be read over the slow serial link.
+ *
+ * Entries are keyed by the tune revision, checksum fixer and ident, with one
+ * file per entry in the user's cache directory. The data held here is only a
+ * starting point: the caller is expected to check it against the ECU, and
+ * storing a fuel map or table that differs from the cached copy discards the
+ * cached ROM image, since it can no longer match the ROM.
+ */
+class EcuDataCache
+{
+public:
+  static const int s_numFuelMaps = 6;
+
+  EcuDataCache();
+
+  bool open(uint16_t tune, uint8_t checksumFixer, uint16_t ident);
+  bool openFile(QString fileName);
+  void close();
+  bool save();
+
+  bool isOpen() const
+  {
+    return !m_fileName.isEmpty();
+  }
+
+  bool getFuelMap(unsigned int fuelMapId, QByteArray& data, uint16_t& adjFactor, uint8_t& rowScaler) const;
+  void setFuelMap(unsigned int fuelMapId, const QByteArray& data, uint16_t adjFactor, uint8_t rowScaler);
+
+  bool getMAFRowScaler(uint16_t& scaler) const;
+  void setMAFRowScaler(uint16_t scaler);
+
+  bool getRPMTable(c14cux_rpmtable& table) const;
+  void setRPMTable(const c14cux_rpmtable& table);
+
+  const QByteArray& getROMImage() const
+  {
+    return m_romImage;
+  }
+
+  void setROMImage(const QByteArray& image);
+
+  static QString cacheDirectory();
+  static QStringList entryFileNames();
+
+private:
+  struct FuelMap
+  {
+    bool valid;
+    uint16_t adjFactor;
+    uint8_t rowScaler;
+    QByteArray data;
+  };
+
+  static const quint32 s_magic = 0x52474443;
+  static const quint16 s_version = 1;
+  static const int s_romImageSize = 16384;
+  static const char s_fileSuffix[];
+
+  QString m_fileName;
+  bool m_dirty;
+
+  FuelMap m_fuelMaps[s_numFuelMaps];
+  bool m_mafScalerValid;
+  uint16_t m_mafScaler;
+  bool m_rpmTableValid;
+  c14cux_rpmtable m_rpmTable;
+  QByteArray m_romImage;
+
+  void clear();
+  bool load();
+};
+
+#endif // ECUDATACACHE_H
@@ -0,0 +1,66 @@
+#ifndef ECUSAMPLE_H
+#define ECUSAMPLE_H
+
+#include <QtGlobal>
+#include "comm14cux.h"
+#include "commonunits.h"
+
+/**
+ * A coherent set of live readings from the ECU, as published by the
+ * CUXInterface at the end of each polling pass. Values are stored in the
+ * units used by the ECU/library (MPH, degrees F, etc.); conversion to the
+ * display units is left to the consumer.
+ *
+ * All times are in microseconds on the interface's monotonic clock (see
+ * CUXInterface::getClockEpoch()). timestampUs is the time at which the
+ * snapshot was published, and readTimeUs holds the time at which each type
+ * of sample was last successfully read (zero if it hasn't been read yet).
+ */
+struct EcuSample
+{
+  quint64 sequence;
+  qint64 timestampUs;
+  qint64 readTimeUs[SampleType_NumSampleTypes];
+
+  uint8_t roadSpeedMPH;
+  uint16_t engineSpeedRPM;
+  uint16_t targetIdleSpeed;
+  bool idleMode;
+  int16_t coolantTempF;
+  int16_t fuelTempF;
+  float throttlePos;
+  float mafReading;
+  float idleBypassPos;
+  float mainVoltage;
+  c14cux_gear gear;
+  bool fuelPumpRelayOn;
+  bool milOn;
+  c14cux_feedback_mode feedbackMode;
+  uint8_t currentFuelMapIndex;
+  uint8_t fuelMapRowIndex;
+  uint8_t fuelMapRowWeighting;
+  uint8_t fuelMapColumnIndex;
+  uint8_t fuelMapColWeighting;
+  int16_t lambdaTrimOdd;
+  int16_t lambdaTrimEven;
+  float coTrimVoltage;
+  float injectorPulseWidthMs;
+
+  uint16_t tune;
+  uint8_t checksumFixer;
+  uint16_t ident;
+};
+
+/**
+ * Receives each snapshot as it's published, on the thread that polls the
+ * ECU. Every polling pass is delivered exactly once, even when the GUI
+ * thread falls behind and only sees the latest snapshot.
+ */
+class EcuSampleSink
+{
+public:
+  virtual ~EcuSampleSink() {}
+  virtual void samplePublished(const EcuSample& sample) = 0;
+};
+
+#endif // ECUSAMPLE_H
@@ -0,0 +1,184 @@
+#include <string.h>
+#include "ecutransport.h"
+
+/**
+ * Builds a request from the provided operation and arguments, and passes it
+ * to the implementation.
+ */
+bool EcuTransport::request(EcuOp op, uint8_t* result, unsigned int resultSize,
+                           uint16_t arg0, uint16_t arg1, uint16_t arg2)
+{
+  EcuRequest req;
+  req.op = op;
+  req.args[0] = arg0;
+  req.args[1] = arg1;
+  req.args[2] = arg2;
+
+  return call(req, result, resultSize);
+}
+
+/**
+ * Reads a block of memory from the ECU's address space.
+ */
+bool EcuTransport::readMem(uint16_t offset, uint16_t length, uint8_t* buffer)
+{
+  return request(EcuOp_ReadMem, buffer, length, offset, length);
+}
+
+/**
+ * Writes a single byte to the ECU's RAM.
+ */
+bool EcuTransport::writeMem(uint16_t offset, uint8_t value)
+{
+  return request(EcuOp_WriteMem, 0, 0, offset, value);
+}
+
+/**
+ * Reads the entire ROM into the provided buffer (which must hold s_romSize bytes.)
+ */
+bool EcuTransport::dumpROM(uint8_t* buffer)
+{
+  return request(EcuOp_DumpROM, buffer, s_romSize);
+}
+
+// The remaining wrappers each correspond to the libcomm14cux function of the
+// same name.
+
+bool EcuTransport::getFaultCodes(c14cux_faultcodes* faultCodes)
+{
+  return request(EcuOp_GetFaultCodes, (uint8_t*)faultCodes, sizeof(c14cux_faultcodes));
+}
+
+bool EcuTransport::clearFaultCodes()
+{
+  return request(EcuOp_ClearFaultCodes, 0, 0);
+}
+
+/**
+ * Reads a fuel map, along with its adjustment factor and row scaler.
+ * @param buffer Buffer to hold the map data (FUEL_MAP_ROWS * FUEL_MAP_COLUMNS bytes)
+ */
+bool EcuTransport::getFuelMap(int8_t fuelMapId, uint16_t* adjFactor, uint8_t* rowScaler, uint8_t* buffer)
+{
+  EcuFuelMapResult result;
+  bool status = request(EcuOp_GetFuelMap, (uint8_t*)&result, sizeof(result), (uint16_t)fuelMapId);
+
+  if (status)
+  {
+    *adjFactor = result.adjustmentFactor;
+    *rowScaler = result.rowScaler;
+    memcpy(buffer, result.data, sizeof(result.data));
+  }
+
+  return status;
+}
+
+bool EcuTransport::getRpmTable(c14cux_rpmtable* table)
+{
+  return request(EcuOp_GetRpmTable, (uint8_t*)table, sizeof(c14cux_rpmtable));
+}
+
+bool EcuTransport::getTuneRevision(uint16_t* tune, uint8_t* checksumFixer, uint16_t* ident)
+{
+  EcuTuneRevisionResult result;
+  bool status = request(EcuOp_GetTuneRevision, (uint8_t*)&result, sizeof(result));
+
+  if (status)
+  {
+    *tune = result.tune;
+    *checksumFixer = result.checksumFixer;
+    *ident = result.ident;
+  }
+
+  return status;
+}
+
+bool EcuTransport::getRPMLimit(uint16_t* rpmLimit)
+{
+  return request(EcuOp_GetRPMLimit, (uint8_t*)rpmLimit, sizeof(uint16_t));
+}
+
+bool EcuTransport::runFuelPump()
+{
+  return request(EcuOp_RunFuelPump, 0, 0);
+}
+
+bool EcuTransport::driveIdleAirControlMotor(uint8_t direction, uint8_t steps)
+{
+  return request(EcuOp_DriveIdleAirControlMotor, 0, 0, direction, steps);
+}
+
+bool EcuTransport::getMAFReading(c14cux_airflow_type type, float* reading)
+{
+  return request(EcuOp_GetMAFReading, (uint8_t*)reading, sizeof(float), (uint16_t)type);
+}
+
+bool EcuTransport::getThrottlePosition(c14cux_throttle_pos_type type, float* position)
+{
+  return request(EcuOp_GetThrottlePosition, (uint8_t*)position, sizeof(float), (uint16_t)type);
+}
+
+bool EcuTransport::getLambdaTrimShort(c14cux_bank bank, int16_t* trim)
+{
+  return request(EcuOp_GetLambdaTrimShort, (uint8_t*)trim, sizeof(int16_t), (uint16_t)bank);
+}
+
+bool EcuTransport::getLambdaTrimLong(c14cux_bank bank, int16_t* trim)
+{
+  return request(EcuOp_GetLambdaTrimLong, (uint8_t*)trim, sizeof(int16_t), (uint16_t)bank);
+}
+
+bool EcuTransport::getIdleBypassMotorPosition(float* position)
+{
+  return request(EcuOp_GetIdleBypassMotorPosition, (uint8_t*)position, sizeof(float));
+}
+
+bool EcuTransport::getMainVoltage(float* voltage)
+{
+  return request(EcuOp_GetMainVoltage, (uint8_t*)voltage, sizeof(float));
+}
+
+bool EcuTransport::getTargetIdle(uint16_t* targetIdleRPM)
+{
+  return request(EcuOp_GetTargetIdle, (uint8_t*)targetIdleRPM, sizeof(uint16_t));
+}
+
+bool EcuTransport::getIdleMode(bool* idleMode)
+{
+  return request(EcuOp_GetIdleMode, (uint8_t*)idleMode, sizeof(bool));
+}
+
+bool EcuTransport::getFuelPumpRelayState(bool* state)
+{
+  return request(EcuOp_GetFuelPumpRelayState, (uint8_t*)state, sizeof(bool));
+}
+
+bool EcuTransport::getGearSelection(c14cux_gear* gear)
+{
+  return request(EcuOp_GetGearSelection, (uint8_t*)gear, sizeof(c14cux_gear));
+}
+
+bool EcuTransport::getCoolantTemp(int16_t* tempF)
+{
+  return request(EcuOp_GetCoolantTemp, (uint8_t*)tempF, sizeof(int16_t));
+}
+
+bool EcuTransport::getFuelTemp(int16_t* tempF)
+{
+  return request(EcuOp_GetFuelTemp, (uint8_t*)tempF, sizeof(int16_t));
+}
+
+bool EcuTransport::isMILOn(bool* milOn)
+{
+  return request(EcuOp_IsMILOn, (uint8_t*)milOn, sizeof(bool));
+}
+
+bool EcuTransport::getCurrentFuelMap(uint8_t* fuelMapId)
+{
+  return request(EcuOp_GetCurrentFuelMap, fuelMapId, sizeof(uint8_t));
+}
+
+bool EcuTransport::getCOTrimVoltage(float* voltage)
+{
+  return request(EcuOp_GetCOTrimVoltage, (uint8_t*)voltage, sizeof(float));
+}
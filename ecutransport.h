@@ -0,0 +1,135 @@
+#ifndef ECUTRANSPORT_H
+#define ECUTRANSPORT_H
+
+#include <QString>
+#include <stdint.h>
+#include "comm14cux.h"
+
+/**
+ * Operations that can be performed on the ECU through a transport.
+ */
+enum EcuOp
+{
+  EcuOp_ReadMem,
+  EcuOp_WriteMem,
+  EcuOp_DumpROM,
+  EcuOp_GetFaultCodes,
+  EcuOp_ClearFaultCodes,
+  EcuOp_GetFuelMap,
+  EcuOp_GetRpmTable,
+  EcuOp_GetTuneRevision,
+  EcuOp_GetRPMLimit,
+  EcuOp_RunFuelPump,
+  EcuOp_DriveIdleAirControlMotor,
+  EcuOp_GetMAFReading,
+  EcuOp_GetThrottlePosition,
+  EcuOp_GetLambdaTrimShort,
+  EcuOp_GetLambdaTrimLong,
+  EcuOp_GetIdleBypassMotorPosition,
+  EcuOp_GetMainVoltage,
+  EcuOp_GetTargetIdle,
+  EcuOp_GetIdleMode,
+  EcuOp_GetFuelPumpRelayState,
+  EcuOp_GetGearSelection,
+  EcuOp_GetCoolantTemp,
+  EcuOp_GetFuelTemp,
+  EcuOp_IsMILOn,
+  EcuOp_GetCurrentFuelMap,
+  EcuOp_GetCOTrimVoltage,
+  EcuOp_NumOps
+};
+
+/**
+ * A single request to the ECU: the operation and up to three integer
+ * arguments (addresses, lengths, map IDs, reading types, etc.)
+ */
+struct EcuRequest
+{
+  EcuOp op;
+  uint16_t args[3];
+};
+
+/**
+ * Result of a fuel map read, as returned through the transport.
+ */
+struct EcuFuelMapResult
+{
+  uint16_t adjustmentFactor;
+  uint8_t rowScaler;
+  uint8_t data[FUEL_MAP_ROWS * FUEL_MAP_COLUMNS];
+};
+
+/**
+ * Result of a tune revision read, as returned through the transport.
+ */
+struct EcuTuneRevisionResult
+{
+  uint16_t tune;
+  uint8_t checksumFixer;
+  uint16_t ident;
+};
+
+/**
+ * The link between the CUXInterface and an ECU. Every data operation goes
+ * through the single call() method, with its arguments described by an
+ * EcuRequest and its result returned as a block of bytes; the typed methods
+ * below wrap call() for each operation. This keeps implementations (and any
+ * wrappers that observe the traffic) down to a handful of methods.
+ */
+class EcuTransport
+{
+public:
+  virtual ~EcuTransport() {}
+
+  virtual void init() = 0;
+  virtual bool connect(QString device, unsigned int baud) = 0;
+  virtual void disconnect() = 0;
+  virtual bool isConnected() = 0;
+  virtual void cancelRead() = 0;
+  virtual void resetState() = 0;
+
+  /**
+   * Performs a single operation on the ECU.
+   * @param request Operation and its arguments
+   * @param result Buffer into which the result is written
+   * @param resultSize Size of the result buffer, which must match the size
+   *  of the result for the operation
+   * @return True if the operation succeeded; false otherwise
+   */
+  virtual bool call(const EcuRequest& request, uint8_t* result, unsigned int resultSize) = 0;
+
+  bool readMem(uint16_t offset, uint16_t length, uint8_t* buffer);
+  bool writeMem(uint16_t offset, uint8_t value);
+  bool dumpROM(uint8_t* buffer);
+  bool getFaultCodes(c14cux_faultcodes* faultCodes);
+  bool clearFaultCodes();
+  bool getFuelMap(int8_t fuelMapId, uint16_t* adjFactor, uint8_t* rowScaler, uint8_t* buffer);
+  bool getRpmTable(c14cux_rpmtable* table);
+  bool getTuneRevision(uint16_t* tune, uint8_t* checksumFixer, uint16_t* ident);
+  bool getRPMLimit(uint16_t* rpmLimit);
+  bool runFuelPump();
+  bool driveIdleAirControlMotor(uint8_t direction, uint8_t steps);
+  bool getMAFReading(c14cux_airflow_type type, float* reading);
+  bool getThrottlePosition(c14cux_throttle_pos_type type, float* position);
+  bool getLambdaTrimShort(c14cux_bank bank, int16_t* trim);
+  bool getLambdaTrimLong(c14cux_bank bank, int16_t* trim);
+  bool getIdleBypassMotorPosition(float* position);
+  bool getMainVoltage(float* voltage);
+  bool getTargetIdle(uint16_t* targetIdleRPM);
+  bool getIdleMode(bool* idleMode);
+  bool getFuelPumpRelayState(bool* state);
+  bool getGearSelection(c14cux_gear* gear);
+  bool getCoolantTemp(int16_t* tempF);
+  bool getFuelTemp(int16_t* tempF);
+  bool isMILOn(bool* milOn);
+  bool getCurrentFuelMap(uint8_t* fuelMapId);
+  bool getCOTrimVoltage(float* voltage);
+
+  static const unsigned int s_romSize = 16384;
+
+private:
+  bool request(EcuOp op, uint8_t* result, unsigned int resultSize,
+               uint16_t arg0 = 0, uint16_t arg1 = 0, uint16_t arg2 = 0);
+};
+
+#endif // ECUTRANSPORT_H
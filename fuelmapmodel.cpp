@@ -0,0 +1,345 @@
+#include <QPainter>
+#include <QBrush>
+#include "fuelmapmodel.h"
+
+QColor FuelMapModel::s_colors[256];
+QString FuelMapModel::s_text[256];
+QString FuelMapModel::s_blankText;
+
+FuelMapModel::FuelMapModel(QObject* parent) :
+  QAbstractTableModel(parent)
+{
+  buildLookupTables();
+
+  for (int slot = 0; slot < s_numHighlightCells; slot++)
+  {
+    m_highlightCells[slot] = -1;
+    m_highlightShades[slot] = 1.0;
+  }
+}
+
+/**
+ * Fills in the cell colors and text for every possible fueling value. Higher
+ * values get more saturated colors.
+ */
+void FuelMapModel::buildLookupTables()
+{
+  static bool built = false;
+
+  if (!built)
+  {
+    for (int value = 0; value < 256; value++)
+    {
+      s_colors[value] = QColor::fromRgb(255, (value / 2 * -1) + 255, 255.0 - value);
+      s_text[value] = QString("%1").arg(value, 2, 16, QChar('0')).toUpper();
+    }
+    built = true;
+  }
+}
+
+int FuelMapModel::rowCount(const QModelIndex& parent) const
+{
+  return parent.isValid() ? 0 : FUEL_MAP_ROWS;
+}
+
+int FuelMapModel::columnCount(const QModelIndex& parent) const
+{
+  return parent.isValid() ? 0 : FUEL_MAP_COLUMNS;
+}
+
+QVariant FuelMapModel::data(const QModelIndex& index, int role) const
+{
+  if (!index.isValid())
+  {
+    return QVariant();
+  }
+
+  switch (role)
+  {
+  case Qt::DisplayRole:
+    return cellText(index.row(), index.column());
+
+  case Qt::BackgroundRole:
+  {
+    const QColor color = cellColor(index.row(), index.column());
+    return color.isValid() ? QVariant(QBrush(color)) : QVariant();
+  }
+
+  case Qt::ForegroundRole:
+    return QBrush(cellTextColor(index.row(), index.column()));
+
+  case Qt::TextAlignmentRole:
+    return (int)Qt::AlignCenter;
+
+  default:
+    return QVariant();
+  }
+}
+
+QVariant FuelMapModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+  if ((orientation == Qt::Horizontal) && (role == Qt::DisplayRole) &&
+      (section >= 0) && (section < FUEL_MAP_COLUMNS))
+  {
+    return m_columnHeaders[section];
+  }
+
+  return QVariant();
+}
+
+Qt::ItemFlags FuelMapModel::flags(const QModelIndex&) const
+{
+  return Qt::NoItemFlags;
+}
+
+/**
+ * Replaces the displayed map, signaling a change only for the rows in which
+ * the values differ from those already displayed.
+ * @param data Fuel map data (FUEL_MAP_ROWS * FUEL_MAP_COLUMNS bytes)
+ */
+void FuelMapModel::setFuelMap(const QByteArray& data)
+{
+  if (data.size() != s_numCells)
+  {
+    return;
+  }
+
+  const bool haveMap = (m_data.size() == s_numCells);
+  int firstChanged = -1;
+  int lastChanged = -1;
+
+  for (int cell = 0; cell < s_numCells; cell++)
+  {
+    if (!haveMap || (m_data.at(cell) != data.at(cell)))
+    {
+      if (firstChanged < 0)
+      {
+        firstChanged = cell;
+      }
+      lastChanged = cell;
+    }
+  }
+
+  m_data = data;
+
+  if (firstChanged >= 0)
+  {
+    emit dataChanged(index(firstChanged / FUEL_MAP_COLUMNS, 0),
+                     index(lastChanged / FUEL_MAP_COLUMNS, FUEL_MAP_COLUMNS - 1));
+  }
+}
+
+/**
+ * Labels the columns with the engine speed thresholds used by the ECU.
+ */
+void FuelMapModel::setRPMTable(const c14cux_rpmtable& table)
+{
+  for (int col = 0; col < FUEL_MAP_COLUMNS; col++)
+  {
+    m_columnHeaders[col] = QString::number(table.rpm[col]);
+  }
+
+  emit headerDataChanged(Qt::Horizontal, 0, FUEL_MAP_COLUMNS - 1);
+}
+
+/**
+ * Highlights the cells for a fueling index. A soft highlight shades the block
+ * of four cells around the index in proportion to the row/column weightings;
+ * otherwise the weightings are rounded and a single cell is highlighted.
+ */
+void FuelMapModel::setHighlight(int row, int col, int rowWeight, int colWeight, bool soft)
+{
+  int cells[s_numHighlightCells];
+  float shades[s_numHighlightCells];
+
+  if (soft)
+  {
+    // Compute the distribution of shading that should be applied left/right
+    // and top/bottom to the block of four cells.
+    float leftPercent = 1.0 - (colWeight / 15.0);
+    float rightPercent = 1.0 - leftPercent;
+    float topPercent = 1.0 - (rowWeight / 15.0);
+    float bottomPercent = 1.0 - topPercent;
+
+    // We subtract from 1.0 here because these values will be used as multipliers
+    // against the un-highlighted cell's R/G/B components to produce a shade of
+    // the appropriate darkness.
+    shades[0] = 1.0 - (leftPercent * topPercent);
+    shades[1] = 1.0 - (rightPercent * topPercent);
+    shades[2] = 1.0 - (leftPercent * bottomPercent);
+    shades[3] = 1.0 - (rightPercent * bottomPercent);
+
+    for (int slot = 0; slot < s_numHighlightCells; slot++)
+    {
+      const int cellRow = row + (slot / 2);
+      const int cellCol = col + (slot % 2);
+
+      cells[slot] = ((cellRow < FUEL_MAP_ROWS) && (cellCol < FUEL_MAP_COLUMNS)) ?
+                    (cellRow * FUEL_MAP_COLUMNS + cellCol) : -1;
+    }
+  }
+  else
+  {
+    // simply use the row/column weight to round up to the next row/col index
+    // if appropriate
+    if (rowWeight >= 8)
+    {
+      row = qMin(row + 1, (int)FUEL_MAP_ROWS - 1);
+    }
+
+    if (colWeight >= 8)
+    {
+      col = qMin(col + 1, (int)FUEL_MAP_COLUMNS - 1);
+    }
+
+    // a single cell, shaded all the way to black
+    cells[0] = row * FUEL_MAP_COLUMNS + col;
+    shades[0] = 0.0;
+
+    for (int slot = 1; slot < s_numHighlightCells; slot++)
+    {
+      cells[slot] = -1;
+      shades[slot] = 1.0;
+    }
+  }
+
+  bool changed = false;
+
+  for (int slot = 0; slot < s_numHighlightCells; slot++)
+  {
+    if ((cells[slot] != m_highlightCells[slot]) || (shades[slot] != m_highlightShades[slot]))
+    {
+      changed = true;
+    }
+  }
+
+  if (changed)
+  {
+    for (int slot = 0; slot < s_numHighlightCells; slot++)
+    {
+      const int oldCell = m_highlightCells[slot];
+
+      m_highlightCells[slot] = cells[slot];
+      m_highlightShades[slot] = shades[slot];
+      emitCellChanged(oldCell);
+      emitCellChanged(cells[slot]);
+    }
+  }
+}
+
+/**
+ * Returns the highlighted cells to their un-highlighted colors.
+ */
+void FuelMapModel::clearHighlight()
+{
+  for (int slot = 0; slot < s_numHighlightCells; slot++)
+  {
+    const int oldCell = m_highlightCells[slot];
+
+    m_highlightCells[slot] = -1;
+    m_highlightShades[slot] = 1.0;
+    emitCellChanged(oldCell);
+  }
+}
+
+/**
+ * Returns the background color of a cell, or an invalid color if the cell is
+ * blank (which happens when playing back a log without having read the map.)
+ */
+QColor FuelMapModel::cellColor(int row, int col) const
+{
+  const int cell = row * FUEL_MAP_COLUMNS + col;
+  const int slot = highlightSlot(cell);
+  QColor color;
+
+  if (m_data.size() == s_numCells)
+  {
+    color = s_colors[(unsigned char)m_data.at(cell)];
+  }
+
+  if (slot >= 0)
+  {
+    if (!color.isValid())
+    {
+      color = Qt::white;
+    }
+
+    const float shade = m_highlightShades[slot];
+    color.setRgb(color.red() * shade, color.green() * shade, color.blue() * shade);
+  }
+
+  return color;
+}
+
+/**
+ * Returns the text color of a cell, which is chosen to contrast with the
+ * background of a highlighted cell.
+ */
+QColor FuelMapModel::cellTextColor(int row, int col) const
+{
+  if (highlightSlot(row * FUEL_MAP_COLUMNS + col) >= 0)
+  {
+    return (cellColor(row, col).value() > 128) ? Qt::black : Qt::white;
+  }
+
+  return Qt::black;
+}
+
+const QString& FuelMapModel::cellText(int row, int col) const
+{
+  if (m_data.size() == s_numCells)
+  {
+    return s_text[(unsigned char)m_data.at(row * FUEL_MAP_COLUMNS + col)];
+  }
+
+  return s_blankText;
+}
+
+/**
+ * Returns the highlight slot holding a cell, or -1 if it isn't highlighted.
+ */
+int FuelMapModel::highlightSlot(int cell) const
+{
+  for (int slot = 0; slot < s_numHighlightCells; slot++)
+  {
+    if (m_highlightCells[slot] == cell)
+    {
+      return slot;
+    }
+  }
+
+  return -1;
+}
+
+void FuelMapModel::emitCellChanged(int cell)
+{
+  if (cell >= 0)
+  {
+    const QModelIndex idx = index(cell / FUEL_MAP_COLUMNS, cell % FUEL_MAP_COLUMNS);
+    emit dataChanged(idx, idx);
+  }
+}
+
+FuelMapDelegate::FuelMapDelegate(FuelMapModel* model, QObject* parent) :
+  QStyledItemDelegate(parent),
+  m_model(model)
+{
+}
+
+void FuelMapDelegate::paint(QPainter* painter, const QStyleOptionViewItem& option, const QModelIndex& index) const
+{
+  const QColor background = m_model->cellColor(index.row(), index.column());
+
+  painter->save();
+
+  if (background.isValid())
+  {
+    painter->fillRect(option.rect, background);
+  }
+
+  painter->setPen(m_model->cellTextColor(index.row(), index.column()));
+  painter->setFont(option.font);
+  painter->drawText(option.rect, Qt::AlignCenter, m_model->cellText(index.row(), index.column()));
+
+  painter->restore();
+}
@@ -0,0 +1,78 @@
+#ifndef FUELMAPMODEL_H
+#define FUELMAPMODEL_H
+
+#include <QAbstractTableModel>
+#include <QStyledItemDelegate>
+#include <QByteArray>
+#include <QColor>
+#include <QString>
+#include "comm14cux.h"
+
+/**
+ * Table model for the fuel map display, backed directly by the raw map data.
+ * Cell text and colors come from lookup tables indexed by the fueling value,
+ * and the highlight of the active cells is kept as cell indices and shading
+ * factors, so that moving the highlight only touches the cells involved.
+ */
+class FuelMapModel : public QAbstractTableModel
+{
+  Q_OBJECT
+
+public:
+  static const int s_numHighlightCells = 4;
+
+  FuelMapModel(QObject* parent = 0);
+
+  int rowCount(const QModelIndex& parent = QModelIndex()) const;
+  int columnCount(const QModelIndex& parent = QModelIndex()) const;
+  QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const;
+  QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const;
+  Qt::ItemFlags flags(const QModelIndex& index) const;
+
+  void setFuelMap(const QByteArray& data);
+  void setRPMTable(const c14cux_rpmtable& table);
+  void setHighlight(int row, int col, int rowWeight, int colWeight, bool soft);
+  void clearHighlight();
+
+  QColor cellColor(int row, int col) const;
+  QColor cellTextColor(int row, int col) const;
+  const QString& cellText(int row, int col) const;
+
+private:
+  static const int s_numCells = FUEL_MAP_ROWS * FUEL_MAP_COLUMNS;
+
+  QByteArray m_data;
+  QString m_columnHeaders[FUEL_MAP_COLUMNS];
+
+  // cell index (row * FUEL_MAP_COLUMNS + col) of each highlighted cell, or
+  // -1, and the factor by which its color is darkened
+  int m_highlightCells[s_numHighlightCells];
+  float m_highlightShades[s_numHighlightCells];
+
+  static QColor s_colors[256];
+  static QString s_text[256];
+  static QString s_blankText;
+
+  static void buildLookupTables();
+  int highlightSlot(int cell) const;
+  void emitCellChanged(int cell);
+};
+
+/**
+ * Paints fuel map cells straight from the model's lookup tables, without
+ * going through the style or QVariant conversion.
+ */
+class FuelMapDelegate : public QStyledItemDelegate
+{
+  Q_OBJECT
+
+public:
+  FuelMapDelegate(FuelMapModel* model, QObject* parent = 0);
+
+  void paint(QPainter* painter, const QStyleOptionViewItem& option, const QModelIndex& index) const;
+
+private:
+  FuelMapModel* m_model;
+};
+
+#endif // FUELMAPMODEL_H
@@ -0,0 +1,159 @@
+#include <QMutexLocker>
+#include <QTextStream>
+#include <QDateTime>
+#include <string.h>
+#include "fuelmapresidency.h"
+
+/**
+ * Returns the mean odd-bank lambda trim at the cell, or zero if the ECU
+ * hasn't been in closed loop there.
+ */
+double FuelMapResidency::Cell::meanTrimOdd() const
+{
+  return (trimSeconds > 0.0) ? (trimOddSum / trimSeconds) : 0.0;
+}
+
+/**
+ * Returns the mean even-bank lambda trim at the cell, or zero if the ECU
+ * hasn't been in closed loop there.
+ */
+double FuelMapResidency::Cell::meanTrimEven() const
+{
+  return (trimSeconds > 0.0) ? (trimEvenSum / trimSeconds) : 0.0;
+}
+
+/**
+ * Constructor. Starts with all maps cleared.
+ */
+FuelMapResidency::FuelMapResidency()
+{
+  reset();
+}
+
+/**
+ * Clears the accumulated time and trims for all maps.
+ */
+void FuelMapResidency::reset()
+{
+  QMutexLocker locker(&m_lock);
+  memset(m_maps, 0, sizeof(m_maps));
+
+  for (unsigned int map = 0; map < s_numFuelMaps; map++)
+  {
+    m_maps[map].fuelMapId = map;
+  }
+}
+
+/**
+ * Adds a reading of the fuel map position.
+ * @param fuelMapId Index of the fuel map in use
+ * @param row Fuel map row index
+ * @param rowWeighting Weighting (0-15) towards the next row
+ * @param col Fuel map column index
+ * @param colWeighting Weighting (0-15) towards the next column
+ * @param seconds Length of time represented by the reading
+ * @param trimValid True if the ECU is in closed loop and the trims are current
+ * @param trimOdd Odd-bank lambda trim
+ * @param trimEven Even-bank lambda trim
+ */
+void FuelMapResidency::addReading(unsigned int fuelMapId, uint8_t row, uint8_t rowWeighting,
+                                  uint8_t col, uint8_t colWeighting, double seconds,
+                                  bool trimValid, int trimOdd, int trimEven)
+{
+  if ((fuelMapId >= s_numFuelMaps) || (row >= FUEL_MAP_ROWS) || (col >= FUEL_MAP_COLUMNS))
+  {
+    return;
+  }
+
+  const double rowFraction = rowWeighting / 16.0;
+  const double colFraction = colWeighting / 16.0;
+  const int nextRow = qMin(row + 1, (int)FUEL_MAP_ROWS - 1);
+  const int nextCol = qMin(col + 1, (int)FUEL_MAP_COLUMNS - 1);
+
+  const int rows[4] = { row, row, nextRow, nextRow };
+  const int cols[4] = { col, nextCol, col, nextCol };
+  const double shares[4] =
+  {
+    (1.0 - rowFraction) * (1.0 - colFraction),
+    (1.0 - rowFraction) * colFraction,
+    rowFraction * (1.0 - colFraction),
+    rowFraction * colFraction
+  };
+
+  QMutexLocker locker(&m_lock);
+  Snapshot& map = m_maps[fuelMapId];
+
+  map.totalSeconds += seconds;
+
+  for (int idx = 0; idx < 4; idx++)
+  {
+    Cell& cell = map.cells[rows[idx]][cols[idx]];
+    const double share = shares[idx] * seconds;
+
+    cell.seconds += share;
+
+    if (trimValid)
+    {
+      cell.trimSeconds += share;
+      cell.trimOddSum += trimOdd * share;
+      cell.trimEvenSum += trimEven * share;
+    }
+  }
+}
+
+/**
+ * Returns a copy of the accumulated data for one map.
+ */
+FuelMapResidency::Snapshot FuelMapResidency::snapshot(unsigned int fuelMapId)
+{
+  QMutexLocker locker(&m_lock);
+  return m_maps[qMin(fuelMapId, s_numFuelMaps - 1)];
+}
+
+/**
+ * Formats the data for one map as CSV: a matrix of the time spent at each
+ * cell, followed by matrices of the mean odd and even lambda trims.
+ */
+QString FuelMapResidency::formatReport(const Snapshot& snap)
+{
+  QString report;
+  QTextStream out(&report);
+  const char* titles[3] = { "#seconds", "#meanTrimOdd", "#meanTrimEven" };
+
+  out << "#generated," << QDateTime::currentDateTime().toString("yyyy-MM-dd_hh:mm:ss.zzz") << endl;
+  out << "#fuelMap," << snap.fuelMapId << ",totalSeconds," << snap.totalSeconds << endl;
+
+  for (int matrix = 0; matrix < 3; matrix++)
+  {
+    out << titles[matrix] << endl;
+
+    for (int row = 0; row < FUEL_MAP_ROWS; row++)
+    {
+      for (int col = 0; col < FUEL_MAP_COLUMNS; col++)
+      {
+        const Cell& cell = snap.cells[row][col];
+
+        if (col > 0)
+        {
+          out << ",";
+        }
+
+        if (matrix == 0)
+        {
+          out << cell.seconds;
+        }
+        else if (matrix == 1)
+        {
+          out << cell.meanTrimOdd();
+        }
+        else
+        {
+          out << cell.meanTrimEven();
+        }
+      }
+      out << endl;
+    }
+  }
+
+  return report;
+}
@@ -0,0 +1,59 @@
+#ifndef FUELMAPRESIDENCY_H
+#define FUELMAPRESIDENCY_H
+
+#include <QMutex>
+#include <QString>
+#include "comm14cux.h"
+
+/**
+ * Accumulates, for each fuel map, how long the engine has spent at each cell
+ * and the lambda trim that was applied there. Each reading of the fuel map
+ * row/column is spread over the (up to) four surrounding cells in proportion
+ * to the row and column weightings, so that the result reflects where the
+ * ECU was actually interpolating. Updated from the worker thread; readers
+ * take a consistent copy of one map with snapshot().
+ */
+class FuelMapResidency
+{
+public:
+  static const unsigned int s_numFuelMaps = 6;
+
+  struct Cell
+  {
+    // time spent at the cell
+    double seconds;
+
+    // time spent at the cell with the ECU in closed loop, and the sum of the
+    // lambda trims over that time (each trim multiplied by its duration)
+    double trimSeconds;
+    double trimOddSum;
+    double trimEvenSum;
+
+    double meanTrimOdd() const;
+    double meanTrimEven() const;
+  };
+
+  struct Snapshot
+  {
+    unsigned int fuelMapId;
+    double totalSeconds;
+    Cell cells[FUEL_MAP_ROWS][FUEL_MAP_COLUMNS];
+  };
+
+  FuelMapResidency();
+
+  void reset();
+  void addReading(unsigned int fuelMapId, uint8_t row, uint8_t rowWeighting,
+                  uint8_t col, uint8_t colWeighting, double seconds,
+                  bool trimValid, int trimOdd, int trimEven);
+
+  Snapshot snapshot(unsigned int fuelMapId);
+
+  static QString formatReport(const Snapshot& snap);
+
+private:
+  QMutex m_lock;
+  Snapshot m_maps[s_numFuelMaps];
+};
+
+#endif // FUELMAPRESIDENCY_H
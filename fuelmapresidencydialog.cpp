@@ -0,0 +1,210 @@
+#include <QFile>
+#include <QFileDialog>
+#include <QMessageBox>
+#include <QHeaderView>
+#include <QTextStream>
+#include "fuelmapresidencydialog.h"
+
+/**
+ * Constructor. Creates the widgets and the refresh timer.
+ * @param title Title for the dialog window
+ * @param residency Accumulated residency data to display
+ */
+FuelMapResidencyDialog::FuelMapResidencyDialog(QString title, FuelMapResidency* residency, QWidget* parent) :
+  QDialog(parent),
+  m_residency(residency)
+{
+  this->setWindowTitle(title);
+  setupWidgets();
+
+  m_refreshTimer = new QTimer(this);
+  connect(m_refreshTimer, SIGNAL(timeout()), this, SLOT(refresh()));
+}
+
+/**
+ * Creates and places the widgets.
+ */
+void FuelMapResidencyDialog::setupWidgets()
+{
+  m_grid = new QGridLayout(this);
+
+  m_mapCombo = new QComboBox(this);
+  for (unsigned int map = 0; map < FuelMapResidency::s_numFuelMaps; map++)
+  {
+    m_mapCombo->addItem(QString("Fuel map %1").arg(map));
+  }
+
+  m_modeCombo = new QComboBox(this);
+  m_modeCombo->addItem("Time at cell (%)", DisplayMode_Time);
+  m_modeCombo->addItem("Mean lambda trim (odd)", DisplayMode_TrimOdd);
+  m_modeCombo->addItem("Mean lambda trim (even)", DisplayMode_TrimEven);
+
+  m_totalLabel = new QLabel(this);
+
+  m_table = new QTableWidget(FUEL_MAP_ROWS, FUEL_MAP_COLUMNS, this);
+  m_table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+  m_table->setSelectionMode(QAbstractItemView::NoSelection);
+  m_table->horizontalHeader()->setSectionResizeMode(QHeaderView::Stretch);
+  m_table->verticalHeader()->setSectionResizeMode(QHeaderView::Stretch);
+
+  for (int row = 0; row < FUEL_MAP_ROWS; row++)
+  {
+    for (int col = 0; col < FUEL_MAP_COLUMNS; col++)
+    {
+      QTableWidgetItem* item = new QTableWidgetItem();
+      item->setTextAlignment(Qt::AlignCenter);
+      m_table->setItem(row, col, item);
+    }
+  }
+  m_table->setMinimumSize(640, 280);
+
+  m_resetButton = new QPushButton("Reset", this);
+  m_saveButton = new QPushButton("Save to file...", this);
+  m_closeButton = new QPushButton("Close", this);
+
+  m_grid->addWidget(m_mapCombo, 0, 0);
+  m_grid->addWidget(m_modeCombo, 0, 1);
+  m_grid->addWidget(m_totalLabel, 0, 2);
+  m_grid->addWidget(m_table, 1, 0, 1, 3);
+  m_grid->addWidget(m_resetButton, 2, 0);
+  m_grid->addWidget(m_saveButton, 2, 1);
+  m_grid->addWidget(m_closeButton, 2, 2);
+
+  connect(m_mapCombo, SIGNAL(currentIndexChanged(int)), this, SLOT(refresh()));
+  connect(m_modeCombo, SIGNAL(currentIndexChanged(int)), this, SLOT(refresh()));
+  connect(m_resetButton, SIGNAL(clicked()), this, SLOT(onResetClicked()));
+  connect(m_saveButton, SIGNAL(clicked()), this, SLOT(onSaveClicked()));
+  connect(m_closeButton, SIGNAL(clicked()), this, SLOT(accept()));
+}
+
+/**
+ * Selects the fuel map to display; used to follow the map that the ECU is
+ * currently using.
+ */
+void FuelMapResidencyDialog::setFuelMapId(unsigned int fuelMapId)
+{
+  if (fuelMapId < FuelMapResidency::s_numFuelMaps)
+  {
+    m_mapCombo->setCurrentIndex(fuelMapId);
+  }
+}
+
+/**
+ * Starts refreshing the display when the dialog is shown.
+ */
+void FuelMapResidencyDialog::showEvent(QShowEvent* event)
+{
+  refresh();
+  m_refreshTimer->start(s_refreshIntervalMs);
+  QDialog::showEvent(event);
+}
+
+/**
+ * Stops refreshing the display when the dialog is hidden.
+ */
+void FuelMapResidencyDialog::hideEvent(QHideEvent* event)
+{
+  m_refreshTimer->stop();
+  QDialog::hideEvent(event);
+}
+
+/**
+ * Updates the heatmap from a fresh snapshot. Time is shaded from white to red
+ * relative to the most-visited cell; trims are shaded red (rich) or blue
+ * (lean) relative to the largest trim, and cells with no closed-loop time
+ * are left blank.
+ */
+void FuelMapResidencyDialog::refresh()
+{
+  const FuelMapResidency::Snapshot snap = m_residency->snapshot(m_mapCombo->currentIndex());
+  const DisplayMode mode = (DisplayMode)m_modeCombo->itemData(m_modeCombo->currentIndex()).toInt();
+  double maxValue = 0.0;
+  double values[FUEL_MAP_ROWS][FUEL_MAP_COLUMNS];
+
+  for (int row = 0; row < FUEL_MAP_ROWS; row++)
+  {
+    for (int col = 0; col < FUEL_MAP_COLUMNS; col++)
+    {
+      const FuelMapResidency::Cell& cell = snap.cells[row][col];
+
+      if (mode == DisplayMode_Time)
+      {
+        values[row][col] = cell.seconds;
+      }
+      else
+      {
+        values[row][col] = (mode == DisplayMode_TrimOdd) ? cell.meanTrimOdd() : cell.meanTrimEven();
+      }
+      maxValue = qMax(maxValue, qAbs(values[row][col]));
+    }
+  }
+
+  for (int row = 0; row < FUEL_MAP_ROWS; row++)
+  {
+    for (int col = 0; col < FUEL_MAP_COLUMNS; col++)
+    {
+      const FuelMapResidency::Cell& cell = snap.cells[row][col];
+      QTableWidgetItem* item = m_table->item(row, col);
+      const double value = values[row][col];
+      const int shade = (maxValue > 0.0) ? (int)(255 - (qAbs(value) / maxValue * 200)) : 255;
+
+      if (mode == DisplayMode_Time)
+      {
+        const double percent = (snap.totalSeconds > 0.0) ? (value * 100.0 / snap.totalSeconds) : 0.0;
+        item->setText((cell.seconds > 0.0) ? QString::number(percent, 'f', 1) : "");
+        item->setBackgroundColor(QColor(255, shade, shade));
+      }
+      else if (cell.trimSeconds > 0.0)
+      {
+        item->setText(QString::number(value, 'f', 0));
+        item->setBackgroundColor((value >= 0.0) ? QColor(255, shade, shade) : QColor(shade, shade, 255));
+      }
+      else
+      {
+        item->setText("");
+        item->setBackgroundColor(Qt::white);
+      }
+
+      item->setToolTip(QString("%1 s at cell\nMean lambda trim: %2 (odd), %3 (even)")
+                       .arg(cell.seconds, 0, 'f', 1)
+                       .arg(cell.meanTrimOdd(), 0, 'f', 1)
+                       .arg(cell.meanTrimEven(), 0, 'f', 1));
+    }
+  }
+
+  m_totalLabel->setText(QString("Total: %1 s").arg(snap.totalSeconds, 0, 'f', 0));
+}
+
+/**
+ * Clears the accumulated data for all maps.
+ */
+void FuelMapResidencyDialog::onResetClicked()
+{
+  m_residency->reset();
+  refresh();
+}
+
+/**
+ * Prompts for a file name and writes the data for the displayed map to it.
+ */
+void FuelMapResidencyDialog::onSaveClicked()
+{
+  QString fileName = QFileDialog::getSaveFileName(this, "Select output file for fuel map residency:");
+
+  if (!fileName.isEmpty())
+  {
+    QFile outFile(fileName);
+
+    if (outFile.open(QIODevice::WriteOnly | QIODevice::Text))
+    {
+      QTextStream out(&outFile);
+      out << FuelMapResidency::formatReport(m_residency->snapshot(m_mapCombo->currentIndex()));
+      outFile.close();
+    }
+    else
+    {
+      QMessageBox::warning(this, "Error", "Error writing fuel map residency file:\n" + outFile.errorString(),
+                           QMessageBox::Ok);
+    }
+  }
+}
@@ -0,0 +1,62 @@
+#ifndef FUELMAPRESIDENCYDIALOG_H
+#define FUELMAPRESIDENCYDIALOG_H
+
+#include <QDialog>
+#include <QGridLayout>
+#include <QPushButton>
+#include <QLabel>
+#include <QComboBox>
+#include <QTableWidget>
+#include <QTimer>
+#include <QString>
+#include "fuelmapresidency.h"
+
+/**
+ * A dialog that shows the fuel map residency as a heatmap laid out like the
+ * fuel map: either the share of time spent at each cell, or the mean lambda
+ * trim there. Refreshed periodically while the dialog is visible.
+ */
+class FuelMapResidencyDialog : public QDialog
+{
+  Q_OBJECT
+
+public:
+  FuelMapResidencyDialog(QString title, FuelMapResidency* residency, QWidget* parent = 0);
+
+  void setFuelMapId(unsigned int fuelMapId);
+
+protected:
+  void showEvent(QShowEvent* event);
+  void hideEvent(QHideEvent* event);
+
+private slots:
+  void refresh();
+  void onResetClicked();
+  void onSaveClicked();
+
+private:
+  enum DisplayMode
+  {
+    DisplayMode_Time,
+    DisplayMode_TrimOdd,
+    DisplayMode_TrimEven
+  };
+
+  FuelMapResidency* m_residency;
+  QTimer* m_refreshTimer;
+
+  QGridLayout* m_grid;
+  QComboBox* m_mapCombo;
+  QComboBox* m_modeCombo;
+  QLabel* m_totalLabel;
+  QTableWidget* m_table;
+  QPushButton* m_resetButton;
+  QPushButton* m_saveButton;
+  QPushButton* m_closeButton;
+
+  static const int s_refreshIntervalMs = 1000;
+
+  void setupWidgets();
+};
+
+#endif // FUELMAPRESIDENCYDIALOG_H
@@ -0,0 +1,217 @@
+#include <QMutexLocker>
+#include <QTextStream>
+#include <QDateTime>
+#include <string.h>
+#include "linkmetrics.h"
+
+/**
+ * Constructor. Starts with all counters cleared.
+ */
+LinkMetrics::LinkMetrics()
+{
+  reset();
+}
+
+/**
+ * Clears all the counters and restarts the measurement period.
+ */
+void LinkMetrics::reset()
+{
+  QMutexLocker locker(&m_lock);
+  memset(&m_current, 0, sizeof(m_current));
+  m_clock.start();
+}
+
+/**
+ * Adds a single measurement to a histogram. Must be called with the lock held.
+ */
+void LinkMetrics::addToHistogram(Histogram& hist, qint64 valueUs)
+{
+  int bucket = 0;
+
+  while ((bucket < (s_numLatencyBuckets - 1)) && (valueUs >= ((qint64)2 << bucket)))
+  {
+    bucket++;
+  }
+
+  hist.count++;
+  hist.totalUs += valueUs;
+  hist.maxUs = qMax(hist.maxUs, valueUs);
+  hist.buckets[bucket]++;
+}
+
+/**
+ * Records the outcome of reading a single sample from the ECU.
+ * @param type Type of sample that was read
+ * @param latencyUs Time taken by the read, in microseconds
+ * @param success True if the read succeeded
+ */
+void LinkMetrics::recordRead(SampleType type, qint64 latencyUs, bool success)
+{
+  QMutexLocker locker(&m_lock);
+  SampleStats& stats = m_current.samples[type];
+
+  if (success)
+  {
+    stats.successes++;
+  }
+  else
+  {
+    stats.failures++;
+  }
+
+  addToHistogram(stats.latency, latencyUs);
+}
+
+/**
+ * Records the completion of a polling pass.
+ */
+void LinkMetrics::recordPass()
+{
+  QMutexLocker locker(&m_lock);
+  m_current.passes++;
+}
+
+/**
+ * Records the time taken by the GUI to process a newly-published sample.
+ * @param durationUs Processing time, in microseconds
+ */
+void LinkMetrics::recordGuiProcessing(qint64 durationUs)
+{
+  QMutexLocker locker(&m_lock);
+  addToHistogram(m_current.guiProcessing, durationUs);
+}
+
+/**
+ * Returns a copy of the current statistics.
+ */
+LinkMetrics::Snapshot LinkMetrics::snapshot()
+{
+  QMutexLocker locker(&m_lock);
+  Snapshot snap = m_current;
+  snap.elapsedMs = m_clock.elapsed();
+  return snap;
+}
+
+/**
+ * Returns the mean of the recorded values, in milliseconds.
+ */
+double LinkMetrics::Histogram::meanMs() const
+{
+  return (count > 0) ? ((double)totalUs / count / 1000.0) : 0.0;
+}
+
+/**
+ * Estimates a percentile of the recorded values from the histogram. The
+ * result is the upper edge of the bucket in which the percentile falls, so
+ * it is an overestimate by up to a factor of two.
+ * @param fraction Percentile to find, as a fraction (e.g. 0.95)
+ * @return Estimated percentile, in milliseconds
+ */
+double LinkMetrics::Histogram::percentileMs(double fraction) const
+{
+  const quint64 target = (quint64)(fraction * count + 0.5);
+  quint64 seen = 0;
+  qint64 edgeUs = 0;
+
+  for (int bucket = 0; (bucket < s_numLatencyBuckets) && (count > 0); bucket++)
+  {
+    seen += buckets[bucket];
+    if (seen >= target)
+    {
+      edgeUs = qMin((qint64)2 << bucket, maxUs);
+      break;
+    }
+  }
+
+  return edgeUs / 1000.0;
+}
+
+/**
+ * Returns the rate at which an event occurred over the measurement period.
+ */
+double LinkMetrics::Snapshot::ratePerSecond(quint64 count) const
+{
+  return (elapsedMs > 0) ? (count * 1000.0 / elapsedMs) : 0.0;
+}
+
+/**
+ * Returns a readable name for a sample type.
+ */
+QString LinkMetrics::sampleTypeName(SampleType type)
+{
+  QString name;
+
+  switch (type)
+  {
+  case SampleType_EngineTemperature:  name = "Engine temperature"; break;
+  case SampleType_RoadSpeed:          name = "Road speed"; break;
+  case SampleType_EngineRPM:          name = "Engine RPM"; break;
+  case SampleType_FuelTemperature:    name = "Fuel temperature"; break;
+  case SampleType_MAF:                name = "Mass airflow"; break;
+  case SampleType_Throttle:           name = "Throttle position"; break;
+  case SampleType_IdleBypassPosition: name = "Idle bypass position"; break;
+  case SampleType_TargetIdleRPM:      name = "Idle mode / target RPM"; break;
+  case SampleType_GearSelection:      name = "Gear selection"; break;
+  case SampleType_MainVoltage:        name = "Main voltage"; break;
+  case SampleType_LambdaTrimShort:    name = "Lambda trim (short)"; break;
+  case SampleType_LambdaTrimLong:     name = "Lambda trim (long)"; break;
+  case SampleType_COTrimVoltage:      name = "MAF CO trim"; break;
+  case SampleType_FuelPumpRelay:      name = "Fuel pump relay"; break;
+  case SampleType_FuelMapRowCol:      name = "Fuel map row/column"; break;
+  case SampleType_FuelMapData:        name = "Fuel map data"; break;
+  case SampleType_FuelMapIndex:       name = "Fuel map index"; break;
+  case SampleType_InjectorPulseWidth: name = "Injector pulse width"; break;
+  case SampleType_MIL:                name = "MIL"; break;
+  default:                            name = "Unknown"; break;
+  }
+
+  return name;
+}
+
+/**
+ * Formats a snapshot as CSV text, suitable for saving to a file.
+ * @param snap Snapshot of the statistics
+ * @return Report text
+ */
+QString LinkMetrics::formatReport(const Snapshot& snap)
+{
+  QString report;
+  QTextStream out(&report);
+
+  out << "#generated," << QDateTime::currentDateTime().toString("yyyy-MM-dd_hh:mm:ss.zzz") << endl;
+  out << "#periodMs," << snap.elapsedMs << endl;
+  out << "#passes," << snap.passes << ",passesPerSec," << snap.ratePerSecond(snap.passes) << endl;
+  out << "#guiProcessingMeanMs," << snap.guiProcessing.meanMs()
+      << ",guiProcessingP95Ms," << snap.guiProcessing.percentileMs(0.95)
+      << ",guiProcessingMaxMs," << (snap.guiProcessing.maxUs / 1000.0) << endl;
+
+  out << "#sample,successes,failures,readsPerSec,meanMs,p50Ms,p95Ms,maxMs";
+  for (int bucket = 0; bucket < s_numLatencyBuckets; bucket++)
+  {
+    out << ",ltUs" << ((qint64)2 << bucket);
+  }
+  out << endl;
+
+  for (int type = 0; type < (int)SampleType_NumSampleTypes; type++)
+  {
+    const SampleStats& stats = snap.samples[type];
+
+    out << sampleTypeName((SampleType)type) << ","
+        << stats.successes << ","
+        << stats.failures << ","
+        << snap.ratePerSecond(stats.successes) << ","
+        << stats.latency.meanMs() << ","
+        << stats.latency.percentileMs(0.5) << ","
+        << stats.latency.percentileMs(0.95) << ","
+        << (stats.latency.maxUs / 1000.0);
+
+    for (int bucket = 0; bucket < s_numLatencyBuckets; bucket++)
+    {
+      out << "," << stats.latency.buckets[bucket];
+    }
+    out << endl;
+  }
+
+  return report;
+}
@@ -0,0 +1,71 @@
+#ifndef LINKMETRICS_H
+#define LINKMETRICS_H
+
+#include <QMutex>
+#include <QElapsedTimer>
+#include <QString>
+#include "commonunits.h"
+
+/**
+ * Collects statistics about the performance of the serial link to the ECU:
+ * per-sample read latency histograms, success/failure counts, polling pass
+ * rate, and the time taken by the GUI to process each new sample. Updated
+ * from the worker thread (and, for GUI timing, the GUI thread); readers take
+ * a consistent copy with snapshot().
+ */
+class LinkMetrics
+{
+public:
+  // Latencies are bucketed by powers of two: bucket n holds latencies in
+  // the range [2^n, 2^(n+1)) microseconds, with bucket 0 also holding zero.
+  static const int s_numLatencyBuckets = 24;
+
+  struct Histogram
+  {
+    quint64 count;
+    qint64 totalUs;
+    qint64 maxUs;
+    quint64 buckets[s_numLatencyBuckets];
+
+    double meanMs() const;
+    double percentileMs(double fraction) const;
+  };
+
+  struct SampleStats
+  {
+    quint64 successes;
+    quint64 failures;
+    Histogram latency;
+  };
+
+  struct Snapshot
+  {
+    qint64 elapsedMs;
+    quint64 passes;
+    SampleStats samples[SampleType_NumSampleTypes];
+    Histogram guiProcessing;
+
+    double ratePerSecond(quint64 count) const;
+  };
+
+  LinkMetrics();
+
+  void reset();
+  void recordRead(SampleType type, qint64 latencyUs, bool success);
+  void recordPass();
+  void recordGuiProcessing(qint64 durationUs);
+
+  Snapshot snapshot();
+
+  static QString sampleTypeName(SampleType type);
+  static QString formatReport(const Snapshot& snap);
+
+private:
+  static void addToHistogram(Histogram& hist, qint64 valueUs);
+
+  QMutex m_lock;
+  QElapsedTimer m_clock;
+  Snapshot m_current;
+};
+
+#endif // LINKMETRICS_H
@@ -0,0 +1,154 @@
+#include <QFile>
+#include <QFileDialog>
+#include <QMessageBox>
+#include <QHeaderView>
+#include <QTextStream>
+#include "linkmetricsdialog.h"
+
+/**
+ * Constructor. Creates the widgets and the refresh timer.
+ * @param title Title for the dialog window
+ * @param metrics Statistics to display
+ */
+LinkMetricsDialog::LinkMetricsDialog(QString title, LinkMetrics* metrics, QWidget* parent) :
+  QDialog(parent),
+  m_metrics(metrics)
+{
+  this->setWindowTitle(title);
+  setupWidgets();
+
+  m_refreshTimer = new QTimer(this);
+  connect(m_refreshTimer, SIGNAL(timeout()), this, SLOT(refresh()));
+}
+
+/**
+ * Creates and places the widgets.
+ */
+void LinkMetricsDialog::setupWidgets()
+{
+  QStringList headers;
+  headers << "Sample" << "Reads" << "Failures" << "Reads/sec"
+          << "Mean (ms)" << "p50 (ms)" << "p95 (ms)" << "Max (ms)";
+
+  m_grid = new QGridLayout(this);
+
+  m_passRateLabel = new QLabel(this);
+  m_guiTimeLabel = new QLabel(this);
+
+  m_table = new QTableWidget(SampleType_NumSampleTypes, headers.count(), this);
+  m_table->setHorizontalHeaderLabels(headers);
+  m_table->verticalHeader()->setVisible(false);
+  m_table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+  m_table->setSelectionMode(QAbstractItemView::NoSelection);
+
+  for (int row = 0; row < (int)SampleType_NumSampleTypes; row++)
+  {
+    m_table->setItem(row, 0, new QTableWidgetItem(LinkMetrics::sampleTypeName((SampleType)row)));
+    for (int col = 1; col < headers.count(); col++)
+    {
+      QTableWidgetItem* item = new QTableWidgetItem();
+      item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+      m_table->setItem(row, col, item);
+    }
+  }
+  m_table->resizeColumnsToContents();
+  m_table->setMinimumWidth(m_table->horizontalHeader()->length() + 30);
+  m_table->setMinimumHeight(m_table->verticalHeader()->length() + m_table->horizontalHeader()->height() + 4);
+
+  m_resetButton = new QPushButton("Reset", this);
+  m_saveButton = new QPushButton("Save to file...", this);
+  m_closeButton = new QPushButton("Close", this);
+
+  m_grid->addWidget(m_passRateLabel, 0, 0, 1, 3);
+  m_grid->addWidget(m_guiTimeLabel, 1, 0, 1, 3);
+  m_grid->addWidget(m_table, 2, 0, 1, 3);
+  m_grid->addWidget(m_resetButton, 3, 0);
+  m_grid->addWidget(m_saveButton, 3, 1);
+  m_grid->addWidget(m_closeButton, 3, 2);
+
+  connect(m_resetButton, SIGNAL(clicked()), this, SLOT(onResetClicked()));
+  connect(m_saveButton, SIGNAL(clicked()), this, SLOT(onSaveClicked()));
+  connect(m_closeButton, SIGNAL(clicked()), this, SLOT(accept()));
+}
+
+/**
+ * Starts refreshing the statistics when the dialog is shown.
+ */
+void LinkMetricsDialog::showEvent(QShowEvent* event)
+{
+  refresh();
+  m_refreshTimer->start(s_refreshIntervalMs);
+  QDialog::showEvent(event);
+}
+
+/**
+ * Stops refreshing the statistics when the dialog is hidden.
+ */
+void LinkMetricsDialog::hideEvent(QHideEvent* event)
+{
+  m_refreshTimer->stop();
+  QDialog::hideEvent(event);
+}
+
+/**
+ * Updates the displayed statistics from a fresh snapshot.
+ */
+void LinkMetricsDialog::refresh()
+{
+  const LinkMetrics::Snapshot snap = m_metrics->snapshot();
+
+  m_passRateLabel->setText(QString("Polling passes: %1 (%2 per second)")
+                           .arg(snap.passes)
+                           .arg(snap.ratePerSecond(snap.passes), 0, 'f', 1));
+  m_guiTimeLabel->setText(QString("GUI processing time: mean %1 ms, p95 %2 ms, max %3 ms")
+                          .arg(snap.guiProcessing.meanMs(), 0, 'f', 2)
+                          .arg(snap.guiProcessing.percentileMs(0.95), 0, 'f', 2)
+                          .arg(snap.guiProcessing.maxUs / 1000.0, 0, 'f', 2));
+
+  for (int row = 0; row < (int)SampleType_NumSampleTypes; row++)
+  {
+    const LinkMetrics::SampleStats& stats = snap.samples[row];
+
+    m_table->item(row, 1)->setText(QString::number(stats.successes + stats.failures));
+    m_table->item(row, 2)->setText(QString::number(stats.failures));
+    m_table->item(row, 3)->setText(QString::number(snap.ratePerSecond(stats.successes), 'f', 1));
+    m_table->item(row, 4)->setText(QString::number(stats.latency.meanMs(), 'f', 1));
+    m_table->item(row, 5)->setText(QString::number(stats.latency.percentileMs(0.5), 'f', 1));
+    m_table->item(row, 6)->setText(QString::number(stats.latency.percentileMs(0.95), 'f', 1));
+    m_table->item(row, 7)->setText(QString::number(stats.latency.maxUs / 1000.0, 'f', 1));
+  }
+}
+
+/**
+ * Clears the statistics and starts a new measurement period.
+ */
+void LinkMetricsDialog::onResetClicked()
+{
+  m_metrics->reset();
+  refresh();
+}
+
+/**
+ * Prompts for a file name and writes the current statistics to it.
+ */
+void LinkMetricsDialog::onSaveClicked()
+{
+  QString fileName = QFileDialog::getSaveFileName(this, "Select output file for link statistics:");
+
+  if (!fileName.isEmpty())
+  {
+    QFile outFile(fileName);
+
+    if (outFile.open(QIODevice::WriteOnly | QIODevice::Text))
+    {
+      QTextStream out(&outFile);
+      out << LinkMetrics::formatReport(m_metrics->snapshot());
+      outFile.close();
+    }
+    else
+    {
+      QMessageBox::warning(this, "Error", "Error writing link statistics file:\n" + outFile.errorString(),
+                           QMessageBox::Ok);
+    }
+  }
+}
@@ -0,0 +1,50 @@
+#ifndef LINKMETRICSDIALOG_H
+#define LINKMETRICSDIALOG_H
+
+#include <QDialog>
+#include <QGridLayout>
+#include <QPushButton>
+#include <QLabel>
+#include <QTableWidget>
+#include <QTimer>
+#include <QString>
+#include "linkmetrics.h"
+
+/**
+ * A dialog that shows the serial link statistics collected by LinkMetrics,
+ * refreshed periodically while the dialog is visible.
+ */
+class LinkMetricsDialog : public QDialog
+{
+  Q_OBJECT
+
+public:
+  LinkMetricsDialog(QString title, LinkMetrics* metrics, QWidget* parent = 0);
+
+protected:
+  void showEvent(QShowEvent* event);
+  void hideEvent(QHideEvent* event);
+
+private slots:
+  void refresh();
+  void onResetClicked();
+  void onSaveClicked();
+
+private:
+  LinkMetrics* m_metrics;
+  QTimer* m_refreshTimer;
+
+  QGridLayout* m_grid;
+  QLabel* m_passRateLabel;
+  QLabel* m_guiTimeLabel;
+  QTableWidget* m_table;
+  QPushButton* m_resetButton;
+  QPushButton* m_saveButton;
+  QPushButton* m_closeButton;
+
+  static const int s_refreshIntervalMs = 1000;
+
+  void setupWidgets();
+};
+
+#endif // LINKMETRICSDIALOG_H
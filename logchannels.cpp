@@ -0,0 +1,169 @@
+#include "logchannels.h"
+
+namespace
+{
+struct ChannelDef
+{
+  const char* name;
+  const char* units;
+  LogChannelType type;
+  double scale;
+  double deadband;
+  int timeChannel;
+};
+
+// Units of "speed" and "temp" are replaced with the units selected for display.
+// The fuel map row and column are stored in sixteenths, matching the index and
+// weighting nibbles that the ECU reports. Deadbands for the analog readings
+// are a little above the noise seen at a steady engine speed.
+const ChannelDef s_channelDefs[LogChannel_NumChannels] =
+{
+  { "roadSpeed",                  "speed",    LogChannelType_Float32, 1.0,    0.0,   LogChannel_RoadSpeedTimeUs },
+  { "engineSpeed",                "rpm",      LogChannelType_Int32,   1.0,    0.0,   LogChannel_EngineSpeedTimeUs },
+  { "waterTemp",                  "temp",     LogChannelType_Int16,   1.0,    0.0,   LogChannel_WaterTempTimeUs },
+  { "fuelTemp",                   "temp",     LogChannelType_Int16,   1.0,    0.0,   LogChannel_FuelTempTimeUs },
+  { "throttlePos",                "fraction", LogChannelType_Float32, 1.0,    0.002, LogChannel_ThrottlePosTimeUs },
+  { "mafPercentage",              "fraction", LogChannelType_Float32, 1.0,    0.002, LogChannel_MAFPercentageTimeUs },
+  { "idleBypassPos",              "fraction", LogChannelType_Float32, 1.0,    0.005, LogChannel_IdleBypassPosTimeUs },
+  { "mainVoltage",                "V",        LogChannelType_Float32, 1.0,    0.05,  LogChannel_MainVoltageTimeUs },
+  { "currentFuelMapIndex",        "",         LogChannelType_Int16,   1.0,    0.0,   LogChannel_CurrentFuelMapIndexTimeUs },
+  { "currentFuelMapRow",          "",         LogChannelType_Int16,   0.0625, 0.0,   LogChannel_CurrentFuelMapRowColTimeUs },
+  { "currentFuelMapCol",          "",         LogChannelType_Int16,   0.0625, 0.0,   LogChannel_CurrentFuelMapRowColTimeUs },
+  { "targetIdle",                 "rpm",      LogChannelType_Int32,   1.0,    0.0,   LogChannel_TargetIdleTimeUs },
+  { "lambdaTrimOdd",              "counts",   LogChannelType_Int16,   1.0,    0.0,   LogChannel_LambdaTrimTimeUs },
+  { "lambdaTrimEven",             "counts",   LogChannelType_Int16,   1.0,    0.0,   LogChannel_LambdaTrimTimeUs },
+  { "pulseWidthMs",               "ms",       LogChannelType_Float32, 1.0,    0.01,  LogChannel_PulseWidthTimeUs },
+  { "sampleTimeUs",               "us",       LogChannelType_Int64,   1.0,    -1.0,  -1 },
+  { "roadSpeedTimeUs",            "us",       LogChannelType_Int64,   1.0,    0.0,   -1 },
+  { "engineSpeedTimeUs",          "us",       LogChannelType_Int64,   1.0,    0.0,   -1 },
+  { "waterTempTimeUs",            "us",       LogChannelType_Int64,   1.0,    0.0,   -1 },
+  { "fuelTempTimeUs",             "us",       LogChannelType_Int64,   1.0,    0.0,   -1 },
+  { "throttlePosTimeUs",          "us",       LogChannelType_Int64,   1.0,    0.0,   -1 },
+  { "mafPercentageTimeUs",        "us",       LogChannelType_Int64,   1.0,    0.0,   -1 },
+  { "idleBypassPosTimeUs",        "us",       LogChannelType_Int64,   1.0,    0.0,   -1 },
+  { "mainVoltageTimeUs",          "us",       LogChannelType_Int64,   1.0,    0.0,   -1 },
+  { "currentFuelMapIndexTimeUs",  "us",       LogChannelType_Int64,   1.0,    0.0,   -1 },
+  { "currentFuelMapRowColTimeUs", "us",       LogChannelType_Int64,   1.0,    0.0,   -1 },
+  { "targetIdleTimeUs",           "us",       LogChannelType_Int64,   1.0,    0.0,   -1 },
+  { "lambdaTrimTimeUs",           "us",       LogChannelType_Int64,   1.0,    0.0,   -1 },
+  { "pulseWidthTimeUs",           "us",       LogChannelType_Int64,   1.0,    0.0,   -1 }
+};
+}
+
+/**
+ * Returns the table of log channels, with units filled in for the given
+ * speed and temperature units.
+ */
+QVector<LogChannel> LogChannels::channels(SpeedUnits speedUnits, TemperatureUnits tempUnits)
+{
+  QVector<LogChannel> list;
+
+  for (int idx = 0; idx < (int)LogChannel_NumChannels; idx++)
+  {
+    LogChannel c;
+    c.name = s_channelDefs[idx].name;
+    c.units = s_channelDefs[idx].units;
+    c.type = s_channelDefs[idx].type;
+    c.scale = s_channelDefs[idx].scale;
+    c.deadband = s_channelDefs[idx].deadband;
+    c.timeChannel = s_channelDefs[idx].timeChannel;
+
+    if (c.units == "speed")
+    {
+      c.units = (speedUnits == MPH) ? "mph" : "km/h";
+    }
+    else if (c.units == "temp")
+    {
+      c.units = (tempUnits == Fahrenheit) ? "F" : "C";
+    }
+
+    list.append(c);
+  }
+
+  return list;
+}
+
+/**
+ * Returns the number of bytes that a value of the given type occupies in the
+ * binary log.
+ */
+int LogChannels::typeSize(LogChannelType type)
+{
+  int size = 4;
+
+  switch (type)
+  {
+  case LogChannelType_Int16:
+    size = 2;
+    break;
+  case LogChannelType_Int64:
+    size = 8;
+    break;
+  case LogChannelType_Int32:
+  case LogChannelType_Float32:
+    size = 4;
+    break;
+  }
+
+  return size;
+}
+
+/**
+ * Returns the CSV header line (without a line ending) for the provided
+ * channels.
+ */
+QString LogChannels::csvHeader(const QVector<LogChannel>& channels)
+{
+  QString header("#datetime");
+
+  foreach(const LogChannel& c, channels)
+  {
+    header += "," + c.name;
+  }
+
+  return header;
+}
+
+/**
+ * Writes the CSV header line for the provided channels.
+ */
+void LogChannels::writeCsvHeader(QTextStream& stream, const QVector<LogChannel>& channels)
+{
+  stream << csvHeader(channels) << "\n";
+}
+
+/**
+ * Writes a single row of the log in CSV form. Channels whose values are whole
+ * numbers are written as integers; the rest are written with the stream's
+ * default precision. The stream is not flushed.
+ * @param stream Stream to write to
+ * @param epoch Wall-clock time that corresponds to zero on the sample clock
+ * @param timeChannel Index of the channel holding the sample time (in
+ *  microseconds on the sample clock), from which the date/time is derived
+ * @param channels Descriptions of the channels
+ * @param values Value of each channel
+ */
+void LogChannels::writeCsvRow(QTextStream& stream, const QDateTime& epoch, int timeChannel,
+                              const QVector<LogChannel>& channels, const double* values)
+{
+  const QDateTime sampleTime = epoch.addMSecs((qint64)values[timeChannel] / 1000);
+
+  stream << sampleTime.toString("yyyy-MM-dd_hh:mm:ss.zzz");
+
+  for (int idx = 0; idx < channels.size(); idx++)
+  {
+    const LogChannel& c = channels.at(idx);
+
+    stream << ",";
+    if ((c.type == LogChannelType_Float32) || (c.scale != 1.0))
+    {
+      stream << values[idx];
+    }
+    else
+    {
+      stream << (qint64)values[idx];
+    }
+  }
+
+  stream << "\n";
+}
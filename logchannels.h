@@ -0,0 +1,104 @@
+#ifndef LOGCHANNELS_H
+#define LOGCHANNELS_H
+
+#include <QString>
+#include <QVector>
+#include <QDateTime>
+#include <QTextStream>
+#include "commonunits.h"
+
+/**
+ * Columns of the data log, in the order in which they appear in the CSV
+ * layout (after the leading date/time column).
+ */
+enum LogChannelId
+{
+  LogChannel_RoadSpeed,
+  LogChannel_EngineSpeed,
+  LogChannel_WaterTemp,
+  LogChannel_FuelTemp,
+  LogChannel_ThrottlePos,
+  LogChannel_MAFPercentage,
+  LogChannel_IdleBypassPos,
+  LogChannel_MainVoltage,
+  LogChannel_CurrentFuelMapIndex,
+  LogChannel_CurrentFuelMapRow,
+  LogChannel_CurrentFuelMapCol,
+  LogChannel_TargetIdle,
+  LogChannel_LambdaTrimOdd,
+  LogChannel_LambdaTrimEven,
+  LogChannel_PulseWidthMs,
+  LogChannel_SampleTimeUs,
+  LogChannel_RoadSpeedTimeUs,
+  LogChannel_EngineSpeedTimeUs,
+  LogChannel_WaterTempTimeUs,
+  LogChannel_FuelTempTimeUs,
+  LogChannel_ThrottlePosTimeUs,
+  LogChannel_MAFPercentageTimeUs,
+  LogChannel_IdleBypassPosTimeUs,
+  LogChannel_MainVoltageTimeUs,
+  LogChannel_CurrentFuelMapIndexTimeUs,
+  LogChannel_CurrentFuelMapRowColTimeUs,
+  LogChannel_TargetIdleTimeUs,
+  LogChannel_LambdaTrimTimeUs,
+  LogChannel_PulseWidthTimeUs,
+  LogChannel_NumChannels
+};
+
+/**
+ * Storage type of a channel in the binary log.
+ */
+enum LogChannelType
+{
+  LogChannelType_Int16,
+  LogChannelType_Int32,
+  LogChannelType_Int64,
+  LogChannelType_Float32
+};
+
+/**
+ * Description of a log channel. Integer channels are stored as raw counts;
+ * the value of the channel is the raw count multiplied by the scale.
+ *
+ * The deadband and time channel are used only when writing change-only logs:
+ * a value is written when it has moved by more than its deadband since it
+ * was last written (always, if the deadband is negative), and the channel
+ * holding the time at which it was read is written along with it.
+ */
+struct LogChannel
+{
+  QString name;
+  QString units;
+  LogChannelType type;
+  double scale;
+  double deadband;
+  int timeChannel;
+};
+
+/**
+ * One row of the data log, with each channel's value in its display units.
+ */
+struct LogRecord
+{
+  double values[LogChannel_NumChannels];
+};
+
+/**
+ * The table of log channels, and the formatting of log rows as CSV (which is
+ * shared by the text logger and the binary log converter so that the two
+ * produce identical output.)
+ */
+class LogChannels
+{
+public:
+  static QVector<LogChannel> channels(SpeedUnits speedUnits, TemperatureUnits tempUnits);
+
+  static int typeSize(LogChannelType type);
+
+  static QString csvHeader(const QVector<LogChannel>& channels);
+  static void writeCsvHeader(QTextStream& stream, const QVector<LogChannel>& channels);
+  static void writeCsvRow(QTextStream& stream, const QDateTime& epoch, int timeChannel,
+                          const QVector<LogChannel>& channels, const double* values);
+};
+
+#endif // LOGCHANNELS_H
@@ -0,0 +1,55 @@
+#include <QFile>
+#include <QByteArray>
+#include <zlib.h>
+#include "logcompressor.h"
+
+const char* const LogCompressor::s_compressedSuffix = ".gz";
+
+/**
+ * Compresses a file into a gzip file alongside it (with ".gz" appended to the
+ * name), and removes the original once the compressed copy is complete.
+ * @param fileName Path of the file to compress
+ * @param compressedFileName Set to the path of the compressed file
+ * @return True on success; false otherwise (in which case the original file
+ *  is left in place)
+ */
+bool LogCompressor::compressFile(QString fileName, QString& compressedFileName)
+{
+  QFile in(fileName);
+  bool status = true;
+
+  compressedFileName = fileName + s_compressedSuffix;
+
+  if (!in.open(QFile::ReadOnly))
+  {
+    return false;
+  }
+
+  gzFile out = gzopen(QFile::encodeName(compressedFileName).constData(), "wb6");
+  if (out == 0)
+  {
+    return false;
+  }
+
+  QByteArray block;
+  while (status && !in.atEnd())
+  {
+    block = in.read(s_blockSize);
+    status = (block.size() > 0) &&
+             (gzwrite(out, block.constData(), (unsigned int)block.size()) == block.size());
+  }
+
+  status = (gzclose(out) == Z_OK) && status;
+  in.close();
+
+  if (status)
+  {
+    QFile::remove(fileName);
+  }
+  else
+  {
+    QFile::remove(compressedFileName);
+  }
+
+  return status;
+}
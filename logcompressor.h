@@ -0,0 +1,22 @@
+#ifndef LOGCOMPRESSOR_H
+#define LOGCOMPRESSOR_H
+
+#include <QString>
+
+/**
+ * Compresses finished log files into the gzip format, so that they can be
+ * opened by standard tools.
+ */
+class LogCompressor
+{
+public:
+  static bool compressFile(QString fileName, QString& compressedFileName);
+
+  static const char* const s_compressedSuffix;
+
+private:
+  // Size of the blocks in which the file is read and compressed
+  static const int s_blockSize = 65536;
+};
+
+#endif // LOGCOMPRESSOR_H
@@ -1,5 +1,6 @@
 #include <QDir>
 #include <QDateTime>
+#include <string.h>
 #include "logger.h"
 
 /**
@@ -13,13 +14,46 @@ Logger::Logger(CUXInterface* cuxIFace, OptionsDialog* options) :
   m_cux(cuxIFace),
   m_options(options),
   m_logExtension(".txt"),
+  m_binaryLogExtension(".rgl"),
   m_logDir("logs"),
-  m_staticDataLogged(false)
+  m_staticDataLogged(false),
+  m_logFormat(LogFormat_CSV),
+  m_writer(this),
+  m_speedUnits(MPH),
+  m_tempUnits(Fahrenheit),
+  m_speedoAdjust(false),
+  m_speedoMultiplier(1.0),
+  m_speedoOffset(0),
+  m_segmented(false),
+  m_compressSegments(false),
+  m_rotateBytes(0),
+  m_rotateUs(0),
+  m_segmentIndex(0),
+  m_segmentFirstUs(0),
+  m_segmentLastUs(0),
+  m_segmentRecords(0),
+  m_unwrittenRecords(0)
 {
+  memset(&m_lastSample, 0, sizeof(m_lastSample));
+  m_segmentPool.setMaxThreadCount(1);
 }
 
 /**
- * Attempts to open a log file with the name specified.
+ * Destructor. Makes sure that the writer thread and any segment compression
+ * have finished.
+ */
+Logger::~Logger()
+{
+  closeLog();
+  waitForSegments();
+}
+
+/**
+ * Attempts to open a log file with the name specified. The format of the log
+ * (CSV text or binary) is taken from the current options, as are the limits
+ * at which a new segment is started and whether finished segments are
+ * compressed. When either is in use, the log is written as numbered segment
+ * files (<name>_001.txt, <name>_002.txt, ...) listed in <name>_manifest.txt.
  * @return True on success, false otherwise
  */
 bool Logger::openLog(QString fileName)
@@ -29,34 +63,54 @@ bool Logger::openLog(QString fileName)
   unsigned int fmCol = 0;
   bool alreadyExists = false;
 
-  m_lastAttemptedLog = m_logDir + QDir::separator() + fileName + m_logExtension;
+  m_logFormat = m_options->getLogFormat();
+  m_epoch = m_cux->getClockEpoch();
+  m_speedUnits = m_options->getSpeedUnits();
+  m_tempUnits = m_options->getTemperatureUnits();
+  m_channels = LogChannels::channels(m_speedUnits, m_tempUnits);
+  m_speedoAdjust = m_options->getSpeedoAdjust();
+  m_speedoMultiplier = m_options->getSpeedoMultiplier();
+  m_speedoOffset = m_options->getSpeedoOffset();
+
+  m_rotateBytes = (qint64)m_options->getLogRotateSizeMB() * 1024 * 1024;
+  m_rotateUs = (qint64)m_options->getLogRotateMinutes() * 60 * 1000000;
+  m_compressSegments = m_options->getCompressLogs();
+  m_segmented = (m_rotateBytes > 0) || (m_rotateUs > 0) || m_compressSegments;
+  m_unwrittenRecords = 0;
+
+  m_logBaseName = m_logDir + QDir::separator() + fileName;
+  m_manifestPath = m_logBaseName + "_manifest" + m_logExtension;
+
+  // A new session never appends to (or overwrites) an existing segment. An
+  // unsegmented CSV log is appended to only if it has the same columns;
+  // otherwise the session goes in a new file with a numbered suffix, so that
+  // rows in different layouts are never mixed under one header.
+  m_segmentIndex = 1;
+  while (m_segmented ?
+         (QFileInfo(segmentPath(m_segmentIndex)).exists() ||
+          QFileInfo(segmentPath(m_segmentIndex) + LogCompressor::s_compressedSuffix).exists()) :
+         ((m_logFormat == LogFormat_CSV) && !csvHeaderMatches(segmentPath(m_segmentIndex))))
+  {
+    m_segmentIndex++;
+  }
+
+  m_segmentPath = segmentPath(m_segmentIndex);
+  m_lastAttemptedLog = m_segmentPath;
   m_lastAttemptedStaticLog = m_logDir + QDir::separator() + fileName + "_static" + m_logExtension;
 
   // if the 'logs' directory exists, or if we're able to create it...
-  if (!m_logFile.isOpen() && (QDir(m_logDir).exists() || QDir().mkdir(m_logDir)))
+  if (!segmentIsOpen() && (QDir(m_logDir).exists() || QDir().mkdir(m_logDir)))
   {
-    // set the name of the log file and open it for writing
-    alreadyExists = QFileInfo(m_lastAttemptedLog).exists();
-    m_logFile.setFileName(m_lastAttemptedLog);
-
-    if (m_logFile.open(QFile::WriteOnly | QFile::Append))
-    {
-      m_logFileStream.setDevice(&m_logFile);
+    success = openSegment();
 
-      if (!alreadyExists)
-      {
-        m_logFileStream << "#datetime,roadSpeed,engineSpeed,waterTemp,fuelTemp," <<
-                           "throttlePos,mafPercentage,idleBypassPos,mainVoltage," <<
-                           "currentFuelMapIndex,currentFuelMapRow,currentFuelMapCol," <<
-                           "targetIdle,lambdaTrimOdd,lambdaTrimEven,pulseWidthMs" << endl;
-      }
-
-      success = true;
-    }
-
-    // if that worked, attempt to open a file for the static/one-shot data
+    // if that worked, start the writer and attempt to open a file for the
+    // static/one-shot data
     if (success)
     {
+      m_writer.resetCounters();
+      m_writer.start(QThread::LowPriority);
+      m_cux->setSampleSink(this);
+
       alreadyExists = QFileInfo(m_lastAttemptedStaticLog).exists();
       m_staticLogFile.setFileName(m_lastAttemptedStaticLog);
 
@@ -89,53 +143,227 @@ bool Logger::openLog(QString fileName)
 }
 
 /**
- * Close the log file(s).
+ * Returns the path of a log segment, or of the whole log if it isn't
+ * segmented. (An unsegmented log only has an index above 1 when it couldn't
+ * be appended to the existing file of the same name.)
  */
-void Logger::closeLog()
+QString Logger::segmentPath(int index) const
 {
+  const QString extension = (m_logFormat != LogFormat_CSV) ? m_binaryLogExtension : m_logExtension;
+
+  if (m_segmented)
+  {
+    return QString("%1_%2%3").arg(m_logBaseName).arg(index, 3, 10, QChar('0')).arg(extension);
+  }
+
+  return (index > 1) ? QString("%1_%2%3").arg(m_logBaseName).arg(index).arg(extension) :
+                       (m_logBaseName + extension);
+}
+
+/**
+ * Indicates whether new rows can be appended to a CSV log: either the file
+ * doesn't exist yet, or its header lists the same columns as this session.
+ */
+bool Logger::csvHeaderMatches(const QString& path) const
+{
+  QFile file(path);
+
+  if (!file.exists())
+  {
+    return true;
+  }
+
+  if (!file.open(QFile::ReadOnly))
+  {
+    return false;
+  }
+
+  const QString header = QString::fromLatin1(file.readLine()).trimmed();
+
+  // an empty file has no header yet, and one is written when it's opened
+  return header.isEmpty() || (header == LogChannels::csvHeader(m_channels));
+}
+
+/**
+ * Opens the current log segment, writing a header if the file is empty.
+ * @return True on success, false otherwise
+ */
+bool Logger::openSegment()
+{
+  m_segmentRecords = 0;
+  m_segmentFirstUs = 0;
+  m_segmentLastUs = 0;
+
+  if (m_logFormat != LogFormat_CSV)
+  {
+    return m_binaryLog.open(m_segmentPath, m_epoch, LogChannel_SampleTimeUs, m_channels,
+                           (m_logFormat == LogFormat_BinaryDelta));
+  }
+
+  m_logFile.setFileName(m_segmentPath);
+
+  if (!m_logFile.open(QFile::WriteOnly | QFile::Append))
+  {
+    return false;
+  }
+
+  m_logFileStream.setDevice(&m_logFile);
+
+  if (m_logFile.size() == 0)
+  {
+    LogChannels::writeCsvHeader(m_logFileStream, m_channels);
+  }
+
+  return true;
+}
+
+bool Logger::segmentIsOpen() const
+{
+  return m_logFile.isOpen() || m_binaryLog.isOpen();
+}
+
+/**
+ * Returns the number of bytes written to the current segment.
+ */
+qint64 Logger::segmentSize()
+{
+  if (m_logFormat != LogFormat_CSV)
+  {
+    return m_binaryLog.size();
+  }
+
+  m_logFileStream.flush();
+  return m_logFile.size();
+}
+
+/**
+ * Closes the current segment. If the log is segmented, the segment is then
+ * compressed (if requested) and recorded in the manifest in the background.
+ */
+void Logger::closeSegment()
+{
+  if (!segmentIsOpen())
+  {
+    return;
+  }
+
+  m_logFileStream.flush();
+  m_logFileStream.setDevice(0);
   m_logFile.close();
-  m_staticLogFile.close();
+  m_binaryLog.close();
+
+  if (m_segmented)
+  {
+    SegmentInfo info;
+
+    info.index = m_segmentIndex;
+    info.path = m_segmentPath;
+    info.manifestPath = m_manifestPath;
+    info.epoch = m_epoch;
+    info.firstUs = m_segmentFirstUs;
+    info.lastUs = m_segmentLastUs;
+    info.records = m_segmentRecords;
+
+    m_segmentPool.start(new SegmentJob(info, m_compressSegments));
+  }
 }
 
 /**
- * Commands the logger to query the 14CUX interface for the currently
- * buffered data, and write it to the file.
+ * Waits for the segments that have been closed to be compressed and recorded
+ * in the manifest.
  */
-void Logger::logData()
+void Logger::waitForSegments()
 {
-  // One of two flags that must be set to allow logging of static data.
-  // This one keeps track of the receipt of firmware build identifiers (tune ID, etc.)
-  // and the other keeps track of the receipt of actual fuel map data.
-  m_miscStaticDataIsReady = true;
+  m_segmentPool.waitForDone();
+}
+
+Logger::SegmentJob::SegmentJob(const SegmentInfo& info, bool compress) :
+  m_info(info),
+  m_compress(compress)
+{
+}
+
+void Logger::SegmentJob::run()
+{
+  QString compressedPath;
+
+  if (!m_compress || !LogCompressor::compressFile(m_info.path, compressedPath))
+  {
+    compressedPath.clear();
+  }
+
+  writeManifestEntry(m_info, compressedPath);
+}
+
+/**
+ * Appends a line describing a finished segment to the manifest.
+ * @param info Segment to describe
+ * @param compressedPath Path of the compressed segment, or an empty string if
+ *  the segment wasn't compressed
+ */
+void Logger::writeManifestEntry(const SegmentInfo& info, const QString& compressedPath)
+{
+  QFile manifest(info.manifestPath);
+  const bool alreadyExists = manifest.exists();
 
-  if (m_logFile.isOpen() && (m_logFileStream.status() == QTextStream::Ok))
+  if (manifest.open(QFile::WriteOnly | QFile::Append))
   {
-    double roadSpeed = m_cux->getRoadSpeed();
+    QTextStream out(&manifest);
+    const QString path = compressedPath.isEmpty() ? info.path : compressedPath;
 
-    if (m_options->getSpeedoAdjust())
+    if (!alreadyExists)
     {
-      roadSpeed *= m_options->getSpeedoMultiplier();
-      roadSpeed += m_options->getSpeedoOffset();
+      out << "#segment,file,firstSampleTime,lastSampleTime,records,bytes,compressed" << endl;
     }
 
-    m_logFileStream << QDateTime::currentDateTime().toString("yyyy-MM-dd_hh:mm:ss.zzz") << ","
-                    << roadSpeed << ","
-                    << m_cux->getEngineSpeedRPM() << ","
-                    << m_cux->getCoolantTemp() << ","
-                    << m_cux->getFuelTemp() << ","
-                    << m_cux->getThrottlePos() << ","
-                    << m_cux->getMAFReading() << ","
-                    << m_cux->getIdleBypassPos() << ","
-                    << m_cux->getMainVoltage() << ","
-                    << m_cux->getCurrentFuelMapIndex() << ","
-                    << getRowWithWeighting() << ","
-                    << getColWithWeighting() << ","
-                    << m_cux->getTargetIdleSpeed() << ","
-                    << m_cux->getLambdaTrimOdd() << ","
-                    << m_cux->getLambdaTrimEven() << ","
-                    << m_cux->getInjectorPulseWidthMs()
-                    << endl;
+    out << info.index << ","
+        << QFileInfo(path).fileName() << ","
+        << info.epoch.addMSecs(info.firstUs / 1000).toString("yyyy-MM-dd_hh:mm:ss.zzz") << ","
+        << info.epoch.addMSecs(info.lastUs / 1000).toString("yyyy-MM-dd_hh:mm:ss.zzz") << ","
+        << info.records << ","
+        << QFileInfo(path).size() << ","
+        << (compressedPath.isEmpty() ? 0 : 1) << endl;
   }
+}
+
+/**
+ * Close the log file(s), once everything queued for writing has been written.
+ */
+void Logger::closeLog()
+{
+  m_cux->setSampleSink(0);
+  m_writer.stop();
+  closeSegment();
+  m_staticLogFile.close();
+}
+
+/**
+ * Queues a row containing the provided snapshot of ECU readings to be written
+ * to the log. Called on the polling thread for every pass while the log is
+ * open, so no pass is missed or logged twice however far the GUI thread has
+ * fallen behind.
+ * @param sample Snapshot of readings from a single polling pass
+ */
+void Logger::samplePublished(const EcuSample& sample)
+{
+  LogRecord record;
+  buildRecord(sample, record);
+  m_writer.enqueue(record);
+}
+
+/**
+ * Takes note of the latest snapshot of ECU readings seen by the GUI thread,
+ * and writes the static data log once everything it needs has been read.
+ * @param sample Latest snapshot of readings
+ */
+void Logger::onDataReady(const EcuSample& sample)
+{
+  m_lastSample = sample;
+
+  // One of two flags that must be set to allow logging of static data.
+  // This one keeps track of the receipt of firmware build identifiers (tune ID, etc.)
+  // and the other keeps track of the receipt of actual fuel map data.
+  m_miscStaticDataIsReady = true;
 
   if (!m_staticDataLogged &&
       m_fuelMapDataIsReady &&
@@ -146,6 +374,115 @@ void Logger::logData()
   }
 }
 
+/**
+ * Writes a batch of records to the open log. Called on the writer thread,
+ * which has sole use of the log file while the log is open.
+ */
+void Logger::writeRecords(const LogRecord* records, int count)
+{
+  // start a new segment when the current one has reached its size or time
+  // limit (checked once per batch, which is frequent enough for limits of a
+  // megabyte or a minute)
+  if (m_segmented && (m_segmentRecords > 0))
+  {
+    const qint64 firstUs = (qint64)records[0].values[LogChannel_SampleTimeUs];
+
+    if (((m_rotateBytes > 0) && (segmentSize() >= m_rotateBytes)) ||
+        ((m_rotateUs > 0) && (firstUs - m_segmentFirstUs >= m_rotateUs)))
+    {
+      closeSegment();
+      m_segmentIndex++;
+      m_segmentPath = segmentPath(m_segmentIndex);
+      openSegment();
+    }
+  }
+
+  if (!segmentIsOpen())
+  {
+    m_unwrittenRecords += count;
+    return;
+  }
+
+  if (m_segmentRecords == 0)
+  {
+    m_segmentFirstUs = (qint64)records[0].values[LogChannel_SampleTimeUs];
+  }
+  m_segmentLastUs = (qint64)records[count - 1].values[LogChannel_SampleTimeUs];
+  m_segmentRecords += count;
+
+  if (m_logFormat != LogFormat_CSV)
+  {
+    for (int idx = 0; idx < count; idx++)
+    {
+      m_binaryLog.write(records[idx]);
+    }
+  }
+  else
+  {
+    // The date/time is derived from the monotonic timestamp of the sample
+    // rather than read when the row is written, so that it isn't skewed by
+    // delays in delivering the sample or in writing it out.
+    for (int idx = 0; idx < count; idx++)
+    {
+      LogChannels::writeCsvRow(m_logFileStream, m_epoch, LogChannel_SampleTimeUs,
+                               m_channels, records[idx].values);
+    }
+
+    m_logFileStream.flush();
+  }
+}
+
+/**
+ * Fills in a log record from a snapshot of ECU readings, converting each
+ * reading to the units that were selected when the log was opened (and that
+ * its header declares). The per-reading timestamps are on the same monotonic
+ * clock as the sample time.
+ */
+void Logger::buildRecord(const EcuSample& sample, LogRecord& record)
+{
+  double roadSpeed = CUXInterface::convertSpeed(sample.roadSpeedMPH, m_speedUnits);
+
+  if (m_speedoAdjust)
+  {
+    roadSpeed *= m_speedoMultiplier;
+    roadSpeed += m_speedoOffset;
+  }
+
+  double* v = record.values;
+
+  v[LogChannel_RoadSpeed]           = roadSpeed;
+  v[LogChannel_EngineSpeed]         = sample.engineSpeedRPM;
+  v[LogChannel_WaterTemp]           = CUXInterface::convertTemperature(sample.coolantTempF, m_tempUnits);
+  v[LogChannel_FuelTemp]            = CUXInterface::convertTemperature(sample.fuelTempF, m_tempUnits);
+  v[LogChannel_ThrottlePos]         = sample.throttlePos;
+  v[LogChannel_MAFPercentage]       = sample.mafReading;
+  v[LogChannel_IdleBypassPos]       = sample.idleBypassPos;
+  v[LogChannel_MainVoltage]         = sample.mainVoltage;
+  v[LogChannel_CurrentFuelMapIndex] = sample.currentFuelMapIndex;
+  v[LogChannel_CurrentFuelMapRow]   = getRowWithWeighting(sample);
+  v[LogChannel_CurrentFuelMapCol]   = getColWithWeighting(sample);
+  v[LogChannel_TargetIdle]          = sample.targetIdleSpeed;
+  v[LogChannel_LambdaTrimOdd]       = sample.lambdaTrimOdd;
+  v[LogChannel_LambdaTrimEven]      = sample.lambdaTrimEven;
+  v[LogChannel_PulseWidthMs]        = sample.injectorPulseWidthMs;
+
+  v[LogChannel_SampleTimeUs]               = sample.timestampUs;
+  v[LogChannel_RoadSpeedTimeUs]            = sample.readTimeUs[SampleType_RoadSpeed];
+  v[LogChannel_EngineSpeedTimeUs]          = sample.readTimeUs[SampleType_EngineRPM];
+  v[LogChannel_WaterTempTimeUs]            = sample.readTimeUs[SampleType_EngineTemperature];
+  v[LogChannel_FuelTempTimeUs]             = sample.readTimeUs[SampleType_FuelTemperature];
+  v[LogChannel_ThrottlePosTimeUs]          = sample.readTimeUs[SampleType_Throttle];
+  v[LogChannel_MAFPercentageTimeUs]        = sample.readTimeUs[SampleType_MAF];
+  v[LogChannel_IdleBypassPosTimeUs]        = sample.readTimeUs[SampleType_IdleBypassPosition];
+  v[LogChannel_MainVoltageTimeUs]          = sample.readTimeUs[SampleType_MainVoltage];
+  v[LogChannel_CurrentFuelMapIndexTimeUs]  = sample.readTimeUs[SampleType_FuelMapIndex];
+  v[LogChannel_CurrentFuelMapRowColTimeUs] = sample.readTimeUs[SampleType_FuelMapRowCol];
+  v[LogChannel_TargetIdleTimeUs]           = sample.readTimeUs[SampleType_TargetIdleRPM];
+  v[LogChannel_LambdaTrimTimeUs]           = qMax(sample.readTimeUs[SampleType_LambdaTrimShort],
+                                                  sample.readTimeUs[SampleType_LambdaTrimLong]);
+  v[LogChannel_PulseWidthTimeUs]           = sample.readTimeUs[SampleType_InjectorPulseWidth];
+}
+
 /**
  * Writes a single entry in a 'static data' log for elements that will likely
  * not change (tune ID, ident byte, fuel map content, etc.)
@@ -163,14 +500,14 @@ void Logger::logStaticData(unsigned int fuelMapId)
     // only get the MAF CO trim if an open-loop map is selected
     if ((fuelMapId > 0) && (fuelMapId < 4))
     {
-      mafCoTrim = m_cux->getCOTrimVoltage();
+      mafCoTrim = m_lastSample.coTrimVoltage;
     }
 
     m_staticLogFileStream << QDateTime::currentDateTime().toString("yyyy-MM-dd_hh:mm:ss.zzz") << ","
       << uppercasedigits
-      << m_cux->getTune() << ","
-      << hex << m_cux->getIdent() << ","
-      << hex << m_cux->getChecksumFixer() << ","
+      << m_lastSample.tune << ","
+      << hex << m_lastSample.ident << ","
+      << hex << m_lastSample.checksumFixer << ","
       << dec << fuelMapId << ","
       << hex << m_cux->getFuelMapAdjustmentFactor(fuelMapId) << ","
       << hex << m_cux->getRowScaler(fuelMapId) << ","
@@ -219,20 +556,20 @@ void Logger::onFuelMapDataReady(unsigned int fuelMapId)
  * Gets a fractional value that describes the current fuel map row index considering
  * the weighting.
  */
-float Logger::getRowWithWeighting()
+float Logger::getRowWithWeighting(const EcuSample& sample)
 {
-  return ((float)m_cux->getFuelMapRowIndex() +
-          ((float)m_cux->getFuelMapRowWeighting() / 16.0));
+  return ((float)sample.fuelMapRowIndex +
+          ((float)sample.fuelMapRowWeighting / 16.0));
 }
 
 /**
  * Gets a fractional value that describes the current fuel map column index considering
  * the weighting.
  */
-float Logger::getColWithWeighting()
+float Logger::getColWithWeighting(const EcuSample& sample)
 {
-  return ((float)m_cux->getFuelMapColumnIndex() +
-          ((float)m_cux->getFuelMapColWeighting() / 16.0));
+  return ((float)sample.fuelMapColumnIndex +
+          ((float)sample.fuelMapColWeighting / 16.0));
 }
 
 /**
@@ -5,27 +5,76 @@
 #include <QFile>
 #include <QTextStream>
 #include <QMutex>
+#include <QRunnable>
+#include <QThreadPool>
 #include "cuxinterface.h"
 #include "optionsdialog.h"
+#include "ecusample.h"
+#include "logchannels.h"
+#include "binarylog.h"
+#include "logwriterthread.h"
+#include "logcompressor.h"
 
-class Logger
+class Logger : public EcuSampleSink
 {
 public:
   Logger(CUXInterface* cuxIFace, OptionsDialog* options);
+  ~Logger();
   bool openLog(QString fileName);
   void closeLog();
-  void logData();
+  void onDataReady(const EcuSample& sample);
+  void samplePublished(const EcuSample& sample);
   QString getLogPath();
   void onFuelMapDataReady(unsigned int fuelMapId);
   void onDisconnect();
 
+  void writeRecords(const LogRecord* records, int count);
+
+  void waitForSegments();
+
+  // Call only while the log is closed
+  int getDroppedRecords() const
+  {
+    return m_writer.droppedRecords() + m_unwrittenRecords;
+  }
+
 private:
+  /**
+   * A finished log segment, as described by its line in the manifest.
+   */
+  struct SegmentInfo
+  {
+    int index;
+    QString path;
+    QString manifestPath;
+    QDateTime epoch;
+    qint64 firstUs;
+    qint64 lastUs;
+    int records;
+  };
+
+  /**
+   * Compresses a finished segment (if requested) and then records it in the
+   * manifest, on the segment thread pool.
+   */
+  class SegmentJob : public QRunnable
+  {
+  public:
+    SegmentJob(const SegmentInfo& info, bool compress);
+    void run();
+
+  private:
+    SegmentInfo m_info;
+    bool m_compress;
+  };
+
   bool m_fuelMapDataIsReady;
   bool m_miscStaticDataIsReady;
   unsigned int m_fuelMapId;
   CUXInterface* m_cux;
   OptionsDialog* m_options;
   QString m_logExtension;
+  QString m_binaryLogExtension;
   QString m_logDir;
   QFile m_logFile;
   QFile m_staticLogFile;
@@ -34,10 +83,54 @@ private:
   QString m_lastAttemptedLog;
   QString m_lastAttemptedStaticLog;
   bool m_staticDataLogged;
+  EcuSample m_lastSample;
+  LogFormat m_logFormat;
+  QVector<LogChannel> m_channels;
+  BinaryLogWriter m_binaryLog;
+  QDateTime m_epoch;
+  LogWriterThread m_writer;
+
+  // units and speedometer adjustment in effect when the log was opened (the
+  // records are built on the polling thread, so neither the options nor the
+  // interface's display units are read there)
+  SpeedUnits m_speedUnits;
+  TemperatureUnits m_tempUnits;
+  bool m_speedoAdjust;
+  double m_speedoMultiplier;
+  int m_speedoOffset;
+
+  // Segmented logs are split into numbered files (each of which may be
+  // compressed when it's finished) and described by a manifest. The members
+  // below are used only by the writer thread while the log is open.
+  bool m_segmented;
+  bool m_compressSegments;
+  qint64 m_rotateBytes;
+  qint64 m_rotateUs;
+  QString m_logBaseName;
+  QString m_manifestPath;
+  int m_segmentIndex;
+  QString m_segmentPath;
+  qint64 m_segmentFirstUs;
+  qint64 m_segmentLastUs;
+  int m_segmentRecords;
+  int m_unwrittenRecords;
+
+  // Finished segments are compressed and added to the manifest here rather
+  // than on the writer thread (which would stop draining the ring) or the
+  // GUI thread. There's a single thread, so the manifest stays in order.
+  QThreadPool m_segmentPool;
 
   void logStaticData(unsigned int fuelMapId);
-  float getRowWithWeighting();
-  float getColWithWeighting();
+  bool openSegment();
+  void closeSegment();
+  bool segmentIsOpen() const;
+  qint64 segmentSize();
+  QString segmentPath(int index) const;
+  bool csvHeaderMatches(const QString& path) const;
+  static void writeManifestEntry(const SegmentInfo& info, const QString& compressedPath);
+  void buildRecord(const EcuSample& sample, LogRecord& record);
+  static float getRowWithWeighting(const EcuSample& sample);
+  static float getColWithWeighting(const EcuSample& sample);
 
   QMutex m_staticLogLock;
 };
@@ -0,0 +1,146 @@
+#include <QDateTime>
+#include <QFileInfo>
+#include <limits.h>
+#include "logplaybackdialog.h"
+
+/**
+ * Constructor. Creates the widgets and connects them to the player.
+ * @param title Title for the dialog window
+ * @param player Player to control
+ */
+LogPlaybackDialog::LogPlaybackDialog(QString title, LogPlayer* player, QWidget* parent) :
+  QDialog(parent),
+  m_player(player),
+  m_updatingSlider(false)
+{
+  this->setWindowTitle(title);
+  setupWidgets();
+
+  connect(m_player, SIGNAL(positionChanged(qint64)), this, SLOT(onPositionChanged(qint64)));
+  connect(m_player, SIGNAL(finished()), this, SLOT(onFinished()));
+}
+
+/**
+ * Creates and places the widgets.
+ */
+void LogPlaybackDialog::setupWidgets()
+{
+  m_grid = new QGridLayout(this);
+
+  m_fileLabel = new QLabel(this);
+  m_positionLabel = new QLabel(this);
+
+  m_positionSlider = new QSlider(Qt::Horizontal, this);
+  m_positionSlider->setMinimumWidth(400);
+
+  m_playButton = new QPushButton("Play", this);
+
+  m_speedCombo = new QComboBox(this);
+  m_speedCombo->addItem("1x", 1);
+  m_speedCombo->addItem("4x", 4);
+  m_speedCombo->addItem("16x", 16);
+  m_speedCombo->addItem("Max", LogPlayer::s_maxSpeed);
+
+  m_closeButton = new QPushButton("Close", this);
+
+  m_grid->addWidget(m_fileLabel, 0, 0, 1, 3);
+  m_grid->addWidget(m_positionSlider, 1, 0, 1, 3);
+  m_grid->addWidget(m_positionLabel, 2, 0, 1, 3);
+  m_grid->addWidget(m_playButton, 3, 0);
+  m_grid->addWidget(m_speedCombo, 3, 1);
+  m_grid->addWidget(m_closeButton, 3, 2);
+
+  connect(m_playButton, SIGNAL(clicked()), this, SLOT(onPlayClicked()));
+  connect(m_speedCombo, SIGNAL(currentIndexChanged(int)), this, SLOT(onSpeedChanged(int)));
+  connect(m_positionSlider, SIGNAL(valueChanged(int)), this, SLOT(onSliderValueChanged(int)));
+  connect(m_closeButton, SIGNAL(clicked()), this, SLOT(accept()));
+}
+
+/**
+ * Resets the controls for a log that has just been opened by the player.
+ */
+void LogPlaybackDialog::logOpened(QString fileName)
+{
+  const qint64 durationMs = (m_player->endTimeUs() - m_player->startTimeUs()) / 1000;
+
+  m_fileLabel->setText(QFileInfo(fileName).fileName());
+  m_playButton->setText("Play");
+
+  m_updatingSlider = true;
+  m_positionSlider->setRange(0, (int)qMin(durationMs, (qint64)INT_MAX));
+  m_positionSlider->setPageStep(10000);
+  m_positionSlider->setValue(0);
+  m_updatingSlider = false;
+
+  m_player->setSpeed(m_speedCombo->itemData(m_speedCombo->currentIndex()).toInt());
+  onPositionChanged(m_player->positionUs());
+}
+
+/**
+ * Pauses playback when the dialog is closed.
+ */
+void LogPlaybackDialog::hideEvent(QHideEvent* event)
+{
+  m_player->pause();
+  m_playButton->setText("Play");
+  QDialog::hideEvent(event);
+}
+
+void LogPlaybackDialog::onPlayClicked()
+{
+  if (m_player->isPlaying())
+  {
+    m_player->pause();
+    m_playButton->setText("Play");
+  }
+  else
+  {
+    m_player->play();
+    if (m_player->isPlaying())
+    {
+      m_playButton->setText("Pause");
+    }
+  }
+}
+
+void LogPlaybackDialog::onSpeedChanged(int index)
+{
+  m_player->setSpeed(m_speedCombo->itemData(index).toInt());
+}
+
+/**
+ * Seeks to the position of the slider when it's moved by the user.
+ */
+void LogPlaybackDialog::onSliderValueChanged(int value)
+{
+  if (!m_updatingSlider)
+  {
+    m_player->seek(m_player->startTimeUs() + ((qint64)value * 1000));
+  }
+}
+
+/**
+ * Moves the slider and updates the time display to follow playback.
+ */
+void LogPlaybackDialog::onPositionChanged(qint64 timeUs)
+{
+  const qint64 elapsedSecs = (timeUs - m_player->startTimeUs()) / 1000000;
+  const qint64 totalSecs = (m_player->endTimeUs() - m_player->startTimeUs()) / 1000000;
+
+  if (!m_positionSlider->isSliderDown())
+  {
+    m_updatingSlider = true;
+    m_positionSlider->setValue((int)((timeUs - m_player->startTimeUs()) / 1000));
+    m_updatingSlider = false;
+  }
+
+  m_positionLabel->setText(QString("%1   (%2:%3 of %4:%5)")
+                           .arg(QDateTime::fromMSecsSinceEpoch(timeUs / 1000).toString("yyyy-MM-dd hh:mm:ss"))
+                           .arg(elapsedSecs / 60).arg(elapsedSecs % 60, 2, 10, QChar('0'))
+                           .arg(totalSecs / 60).arg(totalSecs % 60, 2, 10, QChar('0')));
+}
+
+void LogPlaybackDialog::onFinished()
+{
+  m_playButton->setText("Play");
+}
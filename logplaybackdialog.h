@@ -0,0 +1,51 @@
+#ifndef LOGPLAYBACKDIALOG_H
+#define LOGPLAYBACKDIALOG_H
+
+#include <QDialog>
+#include <QGridLayout>
+#include <QPushButton>
+#include <QLabel>
+#include <QSlider>
+#include <QComboBox>
+#include <QString>
+#include "logplayer.h"
+
+/**
+ * A non-modal dialog with the transport controls for log playback: play and
+ * pause, the playback speed, and a slider for scrubbing through the log.
+ */
+class LogPlaybackDialog : public QDialog
+{
+  Q_OBJECT
+
+public:
+  LogPlaybackDialog(QString title, LogPlayer* player, QWidget* parent = 0);
+
+  void logOpened(QString fileName);
+
+protected:
+  void hideEvent(QHideEvent* event);
+
+private slots:
+  void onPlayClicked();
+  void onSpeedChanged(int index);
+  void onSliderValueChanged(int value);
+  void onPositionChanged(qint64 timeUs);
+  void onFinished();
+
+private:
+  LogPlayer* m_player;
+  bool m_updatingSlider;
+
+  QGridLayout* m_grid;
+  QLabel* m_fileLabel;
+  QLabel* m_positionLabel;
+  QSlider* m_positionSlider;
+  QPushButton* m_playButton;
+  QComboBox* m_speedCombo;
+  QPushButton* m_closeButton;
+
+  void setupWidgets();
+};
+
+#endif // LOGPLAYBACKDIALOG_H
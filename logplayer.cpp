@@ -0,0 +1,306 @@
+#include <string.h>
+#include <math.h>
+#include "logplayer.h"
+
+LogPlayer::LogPlayer(QObject* parent) :
+  QObject(parent),
+  m_speed(1),
+  m_anchorUs(0),
+  m_positionUs(0),
+  m_nextTimeUs(0),
+  m_hasNext(false),
+  m_headerCount(-1),
+  m_speedIsKph(false),
+  m_tempIsCelsius(false),
+  m_csvSpeedUnits(MPH),
+  m_csvTempUnits(Fahrenheit)
+{
+  memset(&m_sample, 0, sizeof(m_sample));
+
+  for (int idx = 0; idx < (int)LogChannel_NumChannels; idx++)
+  {
+    m_columns[idx] = -1;
+  }
+
+  m_timer = new QTimer(this);
+  connect(m_timer, SIGNAL(timeout()), this, SLOT(onTimer()));
+}
+
+/**
+ * Opens a log for playback and shows its first record.
+ * @return True if the log was opened; false otherwise
+ */
+bool LogPlayer::open(QString fileName)
+{
+  close();
+
+  if (!m_reader.open(fileName))
+  {
+    return false;
+  }
+
+  seek(m_reader.startTimeUs());
+  return true;
+}
+
+void LogPlayer::close()
+{
+  m_timer->stop();
+  m_reader.close();
+  m_hasNext = false;
+  m_headerCount = -1;
+  m_positionUs = 0;
+}
+
+/**
+ * Sets the units assumed for the speed and temperature columns of CSV logs.
+ */
+void LogPlayer::setCsvUnits(SpeedUnits speedUnits, TemperatureUnits tempUnits)
+{
+  m_csvSpeedUnits = speedUnits;
+  m_csvTempUnits = tempUnits;
+
+  if (isOpen() && !m_reader.isBinary())
+  {
+    mapChannels();
+  }
+}
+
+/**
+ * Finds the column of the log that holds each channel, and the units of the
+ * speed and temperature columns.
+ */
+void LogPlayer::mapChannels()
+{
+  const QVector<LogChannel>& logChannels = m_reader.channels();
+  const QVector<LogChannel> known = LogChannels::channels(MPH, Fahrenheit);
+
+  for (int id = 0; id < (int)LogChannel_NumChannels; id++)
+  {
+    m_columns[id] = -1;
+
+    for (int col = 0; (m_columns[id] < 0) && (col < logChannels.size()); col++)
+    {
+      if (logChannels.at(col).name == known.at(id).name)
+      {
+        m_columns[id] = col;
+      }
+    }
+  }
+
+  if (m_reader.isBinary())
+  {
+    const int speedCol = m_columns[LogChannel_RoadSpeed];
+    const int tempCol = m_columns[LogChannel_WaterTemp];
+
+    m_speedIsKph = (speedCol >= 0) && (logChannels.at(speedCol).units == "km/h");
+    m_tempIsCelsius = (tempCol >= 0) && (logChannels.at(tempCol).units == "C");
+  }
+  else
+  {
+    m_speedIsKph = (m_csvSpeedUnits == KPH);
+    m_tempIsCelsius = (m_csvTempUnits == Celsius);
+  }
+
+  m_headerCount = m_reader.headerCount();
+}
+
+/**
+ * Returns the value of a channel in the current record, or the default if
+ * the log doesn't have that channel.
+ */
+double LogPlayer::value(LogChannelId channel, double defaultValue) const
+{
+  const int col = m_columns[channel];
+  return ((col >= 0) && (col < m_values.size())) ? m_values.at(col) : defaultValue;
+}
+
+/**
+ * Reads the next record from the log into the lookahead buffer.
+ * @return True if a record was read; false at the end of the log
+ */
+bool LogPlayer::readNext()
+{
+  m_hasNext = m_reader.readRecord(m_nextValues, m_nextTimeUs);
+
+  // the channel layout of the record just read is what will be used to
+  // decode it, so remap if it has changed
+  if (m_hasNext && (m_reader.headerCount() != m_headerCount))
+  {
+    mapChannels();
+  }
+
+  return m_hasNext;
+}
+
+/**
+ * Moves the record in the lookahead buffer into the current sample and reads
+ * the one after it.
+ * @return True if there was a record to move; false at the end of the log
+ */
+bool LogPlayer::advance()
+{
+  if (!m_hasNext)
+  {
+    return false;
+  }
+
+  m_values.swap(m_nextValues);
+  m_positionUs = m_nextTimeUs;
+  updateSample(m_positionUs);
+  readNext();
+
+  return true;
+}
+
+/**
+ * Fills in the current sample from the current record. Readings that aren't
+ * logged (such as the gear selection and MIL state) are left at neutral
+ * values, and the ECU is assumed to be in closed loop so that the lambda trim
+ * indicators are driven.
+ */
+void LogPlayer::updateSample(qint64 timeUs)
+{
+  const double speed = value(LogChannel_RoadSpeed);
+  const double waterTemp = value(LogChannel_WaterTemp);
+  const double fuelTemp = value(LogChannel_FuelTemp);
+  const double row = value(LogChannel_CurrentFuelMapRow);
+  const double col = value(LogChannel_CurrentFuelMapCol);
+
+  m_sample.sequence++;
+  m_sample.timestampUs = timeUs;
+  for (int type = 0; type < (int)SampleType_NumSampleTypes; type++)
+  {
+    m_sample.readTimeUs[type] = timeUs;
+  }
+
+  m_sample.roadSpeedMPH = (uint8_t)qBound(0, qRound(m_speedIsKph ? (speed / 1.609344) : speed), 255);
+  m_sample.engineSpeedRPM = (uint16_t)qBound(0, qRound(value(LogChannel_EngineSpeed)), 65535);
+  m_sample.targetIdleSpeed = (uint16_t)qBound(0, qRound(value(LogChannel_TargetIdle)), 65535);
+  m_sample.coolantTempF = (int16_t)qRound(m_tempIsCelsius ? ((waterTemp * 1.8) + 32) : waterTemp);
+  m_sample.fuelTempF = (int16_t)qRound(m_tempIsCelsius ? ((fuelTemp * 1.8) + 32) : fuelTemp);
+  m_sample.throttlePos = value(LogChannel_ThrottlePos);
+  m_sample.mafReading = value(LogChannel_MAFPercentage);
+  m_sample.idleBypassPos = value(LogChannel_IdleBypassPos);
+  m_sample.mainVoltage = value(LogChannel_MainVoltage);
+  m_sample.currentFuelMapIndex = (uint8_t)qBound(0, qRound(value(LogChannel_CurrentFuelMapIndex)), 255);
+  m_sample.fuelMapRowIndex = (uint8_t)qBound(0, (int)floor(row), (int)FUEL_MAP_ROWS - 1);
+  m_sample.fuelMapRowWeighting = (uint8_t)qBound(0, qRound((row - floor(row)) * 16), 15);
+  m_sample.fuelMapColumnIndex = (uint8_t)qBound(0, (int)floor(col), (int)FUEL_MAP_COLUMNS - 1);
+  m_sample.fuelMapColWeighting = (uint8_t)qBound(0, qRound((col - floor(col)) * 16), 15);
+  m_sample.lambdaTrimOdd = (int16_t)qRound(value(LogChannel_LambdaTrimOdd));
+  m_sample.lambdaTrimEven = (int16_t)qRound(value(LogChannel_LambdaTrimEven));
+  m_sample.injectorPulseWidthMs = value(LogChannel_PulseWidthMs);
+
+  m_sample.idleMode = false;
+  m_sample.gear = C14CUX_Gear_NoReading;
+  m_sample.fuelPumpRelayOn = false;
+  m_sample.milOn = false;
+  m_sample.feedbackMode = C14CUX_FeedbackMode_ClosedLoop;
+  m_sample.coTrimVoltage = 0.0;
+}
+
+/**
+ * Restarts the playback clock from the current position.
+ */
+void LogPlayer::restartClock()
+{
+  m_anchorUs = m_positionUs;
+  m_clock.start();
+}
+
+/**
+ * Starts (or resumes) playback from the current position.
+ */
+void LogPlayer::play()
+{
+  if (isOpen() && m_hasNext)
+  {
+    restartClock();
+    m_timer->start(s_timerIntervalMs);
+  }
+}
+
+void LogPlayer::pause()
+{
+  m_timer->stop();
+}
+
+/**
+ * Sets the playback speed.
+ * @param multiplier Multiple of real time at which to play, or s_maxSpeed
+ */
+void LogPlayer::setSpeed(int multiplier)
+{
+  m_speed = (multiplier > 0) ? multiplier : s_maxSpeed;
+  restartClock();
+}
+
+/**
+ * Moves playback to the first record at or after the given time, and shows
+ * that record straight away (whether or not the log is playing) so that the
+ * gauges follow the position while scrubbing.
+ * @param timeUs Time to seek to, in microseconds since the Unix epoch
+ */
+void LogPlayer::seek(qint64 timeUs)
+{
+  if (!isOpen())
+  {
+    return;
+  }
+
+  m_hasNext = m_reader.seek(timeUs) && readNext();
+
+  if (advance())
+  {
+    emit sampleReady();
+  }
+  restartClock();
+  emit positionChanged(m_positionUs);
+}
+
+/**
+ * Moves through the log by the amount of time that has elapsed on the
+ * playback clock (scaled by the playback speed), and publishes the most
+ * recent record that was passed.
+ */
+void LogPlayer::onTimer()
+{
+  bool advanced = false;
+
+  if (m_speed == s_maxSpeed)
+  {
+    for (int count = 0; (count < s_maxSpeedRecordsPerTick) && advance(); count++)
+    {
+      advanced = true;
+    }
+  }
+  else
+  {
+    const qint64 targetUs = m_anchorUs + ((m_clock.nsecsElapsed() / 1000) * m_speed);
+
+    while (m_hasNext && (m_nextTimeUs <= targetUs))
+    {
+      advance();
+      advanced = true;
+    }
+
+    if (m_hasNext && (m_nextTimeUs - targetUs > s_maxGapUs))
+    {
+      m_positionUs = m_nextTimeUs;
+      restartClock();
+    }
+  }
+
+  if (advanced)
+  {
+    emit sampleReady();
+    emit positionChanged(m_positionUs);
+  }
+
+  if (!m_hasNext)
+  {
+    m_timer->stop();
+    emit finished();
+  }
+}
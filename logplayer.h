@@ -0,0 +1,128 @@
+#ifndef LOGPLAYER_H
+#define LOGPLAYER_H
+
+#include <QObject>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QVector>
+#include "logreader.h"
+#include "ecusample.h"
+#include "commonunits.h"
+
+/**
+ * Plays back a data log as a stream of EcuSamples, so that a recorded session
+ * can be reviewed on the same gauges as a live one. Records are read from the
+ * log as they're needed (only the next record is held in memory), and seeking
+ * uses the log's time index, so a long log is as quick to scrub through as a
+ * short one.
+ *
+ * Channels are matched to the sample by name, so that logs written by older
+ * versions (which lack some columns) can still be played. Speeds and
+ * temperatures are converted back to the ECU's units using the units recorded
+ * in the log; CSV logs don't record their units, so the units given to
+ * setCsvUnits() are assumed.
+ */
+class LogPlayer : public QObject
+{
+  Q_OBJECT
+
+public:
+  explicit LogPlayer(QObject* parent = 0);
+
+  bool open(QString fileName);
+  void close();
+
+  bool isOpen() const
+  {
+    return m_reader.isOpen();
+  }
+
+  bool isPlaying() const
+  {
+    return m_timer->isActive();
+  }
+
+  QString errorString() const
+  {
+    return m_reader.errorString();
+  }
+
+  qint64 startTimeUs() const
+  {
+    return m_reader.startTimeUs();
+  }
+
+  qint64 endTimeUs() const
+  {
+    return m_reader.endTimeUs();
+  }
+
+  qint64 positionUs() const
+  {
+    return m_positionUs;
+  }
+
+  const EcuSample& currentSample() const
+  {
+    return m_sample;
+  }
+
+  void setCsvUnits(SpeedUnits speedUnits, TemperatureUnits tempUnits);
+
+  // Playback speed multiplier that plays the log as fast as it can be displayed
+  static const int s_maxSpeed = 0;
+
+public slots:
+  void play();
+  void pause();
+  void setSpeed(int multiplier);
+  void seek(qint64 timeUs);
+
+signals:
+  void sampleReady();
+  void positionChanged(qint64 timeUs);
+  void finished();
+
+private slots:
+  void onTimer();
+
+private:
+  static const int s_timerIntervalMs = 20;
+  static const int s_maxSpeedRecordsPerTick = 64;
+
+  // gaps between records longer than this (such as those between sessions
+  // appended to the same log) are skipped rather than played out
+  static const qint64 s_maxGapUs = 5000000;
+
+  LogReader m_reader;
+  QTimer* m_timer;
+  QElapsedTimer m_clock;
+  int m_speed;
+
+  // log time corresponding to the moment the clock was started
+  qint64 m_anchorUs;
+  qint64 m_positionUs;
+
+  QVector<double> m_values;
+  QVector<double> m_nextValues;
+  qint64 m_nextTimeUs;
+  bool m_hasNext;
+
+  int m_headerCount;
+  int m_columns[LogChannel_NumChannels];
+  bool m_speedIsKph;
+  bool m_tempIsCelsius;
+  SpeedUnits m_csvSpeedUnits;
+  TemperatureUnits m_csvTempUnits;
+
+  EcuSample m_sample;
+
+  bool readNext();
+  bool advance();
+  void mapChannels();
+  double value(LogChannelId channel, double defaultValue = 0.0) const;
+  void updateSample(qint64 timeUs);
+  void restartClock();
+};
+
+#endif // LOGPLAYER_H
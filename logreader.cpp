@@ -0,0 +1,581 @@
+#include <QDataStream>
+#include <QDateTime>
+#include <QFileInfo>
+#include <QtEndian>
+#include <QStringList>
+#include <algorithm>
+#include <stdlib.h>
+#include <string.h>
+#include "logreader.h"
+#include "logcompressor.h"
+
+namespace
+{
+/**
+ * Parses a fixed-width run of decimal digits.
+ * @return True if every character was a digit; false otherwise
+ */
+bool parseDigits(const char* p, int count, int& value)
+{
+  value = 0;
+
+  for (int idx = 0; idx < count; idx++)
+  {
+    if ((p[idx] < '0') || (p[idx] > '9'))
+    {
+      return false;
+    }
+    value = (value * 10) + (p[idx] - '0');
+  }
+
+  return true;
+}
+
+// Length of the "yyyy-MM-dd_hh:mm:ss.zzz" date/time at the start of each CSV row
+const int s_csvTimeLength = 23;
+
+// Length of the "yyyy-MM-dd_hh" prefix of the date/time
+const int s_csvHourKeyLength = 13;
+}
+
+LogReader::LogReader() :
+  m_isOpen(false),
+  m_isBinary(false),
+  m_startTimeUs(0),
+  m_endTimeUs(0),
+  m_pendingTimeUs(0),
+  m_hasPending(false),
+  m_csvData(0),
+  m_csvSize(0),
+  m_csvPos(0),
+  m_csvMapped(false),
+  m_csvHourStartMs(0)
+{
+}
+
+LogReader::~LogReader()
+{
+  close();
+}
+
+/**
+ * Returns the name of the index file that accompanies a log.
+ */
+QString LogReader::indexFileName(QString logFileName)
+{
+  return logFileName + ".idx";
+}
+
+/**
+ * Opens a log, loading its index (or building one if there's no usable index
+ * on disk), and positions the reader at the first record.
+ * @return True if the log was opened; false otherwise
+ */
+bool LogReader::open(QString fileName)
+{
+  close();
+  m_fileName = fileName;
+
+  if (fileName.endsWith(LogCompressor::s_compressedSuffix))
+  {
+    m_errorString = "Compressed logs must be decompressed before they can be read.";
+    return false;
+  }
+
+  QFile probe(fileName);
+  quint32 magic = 0;
+
+  if (!probe.open(QFile::ReadOnly))
+  {
+    m_errorString = probe.errorString();
+    return false;
+  }
+  if (probe.read((char*)&magic, sizeof(magic)) == sizeof(magic))
+  {
+    magic = qFromLittleEndian(magic);
+  }
+  probe.close();
+
+  m_isBinary = (magic == BinaryLog::s_magic);
+
+  if (m_isBinary)
+  {
+    if (!m_binary.open(fileName))
+    {
+      m_errorString = m_binary.errorString();
+      return false;
+    }
+  }
+  else if (!openCsv())
+  {
+    return false;
+  }
+
+  if (!loadIndex())
+  {
+    if (!buildIndex())
+    {
+      close();
+      return false;
+    }
+    saveIndex();
+  }
+
+  m_isOpen = true;
+
+  if (!m_index.isEmpty())
+  {
+    seekToEntry(m_index.first());
+  }
+
+  return true;
+}
+
+void LogReader::close()
+{
+  m_binary.close();
+
+  if (m_csvMapped)
+  {
+    m_csvFile.unmap((uchar*)m_csvData);
+  }
+  m_csvFile.close();
+  m_csvFileData.clear();
+  m_csvData = 0;
+  m_csvSize = 0;
+  m_csvPos = 0;
+  m_csvMapped = false;
+  m_csvChannels.clear();
+  m_csvHourKey.clear();
+
+  m_index.clear();
+  m_startTimeUs = 0;
+  m_endTimeUs = 0;
+  m_hasPending = false;
+  m_isOpen = false;
+}
+
+/**
+ * Returns the descriptions of the log's channels. For binary logs, these are
+ * taken from the header that describes the most recently read record.
+ */
+const QVector<LogChannel>& LogReader::channels() const
+{
+  return m_isBinary ? m_binary.channels() : m_csvChannels;
+}
+
+/**
+ * Maps a CSV log into memory and parses its column names.
+ * @return True if the file looks like a CSV log; false otherwise
+ */
+bool LogReader::openCsv()
+{
+  m_csvFile.setFileName(m_fileName);
+
+  if (!m_csvFile.open(QFile::ReadOnly))
+  {
+    m_errorString = m_csvFile.errorString();
+    return false;
+  }
+
+  m_csvSize = m_csvFile.size();
+  m_csvData = (m_csvSize > 0) ? (const char*)m_csvFile.map(0, m_csvSize) : 0;
+  m_csvMapped = (m_csvData != 0);
+
+  if (!m_csvMapped)
+  {
+    m_csvFileData = m_csvFile.readAll();
+    m_csvData = m_csvFileData.constData();
+    m_csvSize = m_csvFileData.size();
+  }
+
+  const char* end = (const char*)memchr(m_csvData, '\n', m_csvSize);
+  const int headerLength = end ? (end - m_csvData) : m_csvSize;
+  const QStringList names =
+    QString::fromLatin1(m_csvData, headerLength).trimmed().split(",");
+
+  if ((names.size() < 2) || (names.first() != "#datetime"))
+  {
+    m_errorString = "Not a RoverGauge data log.";
+    return false;
+  }
+
+  for (int idx = 1; idx < names.size(); idx++)
+  {
+    LogChannel c;
+    c.name = names.at(idx);
+    c.type = LogChannelType_Float32;
+    c.scale = 1.0;
+    c.deadband = 0.0;
+    c.timeChannel = -1;
+    m_csvChannels.append(c);
+  }
+
+  m_csvPos = end ? (headerLength + 1) : m_csvSize;
+
+  return true;
+}
+
+/**
+ * Converts the date/time at the start of a CSV row to microseconds since the
+ * Unix epoch. The (relatively expensive) conversion from local time is only
+ * done when the hour changes, which also keeps it correct across daylight
+ * saving changes.
+ * @return True if the date/time was valid; false otherwise
+ */
+bool LogReader::parseCsvTime(const char* line, int length, qint64& timeUs)
+{
+  int minute = 0;
+  int second = 0;
+  int msec = 0;
+
+  if ((length < s_csvTimeLength) ||
+      !parseDigits(line + 14, 2, minute) ||
+      !parseDigits(line + 17, 2, second) ||
+      !parseDigits(line + 20, 3, msec))
+  {
+    return false;
+  }
+
+  if ((m_csvHourKey.size() != s_csvHourKeyLength) ||
+      (memcmp(m_csvHourKey.constData(), line, s_csvHourKeyLength) != 0))
+  {
+    int year = 0;
+    int month = 0;
+    int day = 0;
+    int hour = 0;
+
+    if (!parseDigits(line, 4, year) ||
+        !parseDigits(line + 5, 2, month) ||
+        !parseDigits(line + 8, 2, day) ||
+        !parseDigits(line + 11, 2, hour))
+    {
+      return false;
+    }
+
+    const QDateTime hourStart(QDate(year, month, day), QTime(hour, 0));
+    if (!hourStart.isValid())
+    {
+      return false;
+    }
+
+    m_csvHourKey = QByteArray(line, s_csvHourKeyLength);
+    m_csvHourStartMs = hourStart.toMSecsSinceEpoch();
+  }
+
+  timeUs = (m_csvHourStartMs + (minute * 60000) + (second * 1000) + msec) * 1000;
+  return true;
+}
+
+/**
+ * Reads the next row of a CSV log, skipping blank, comment and malformed lines.
+ * @return True if a row was read; false at the end of the log
+ */
+bool LogReader::readCsvRow(QVector<double>& values, qint64& timeUs)
+{
+  char field[64];
+
+  values.resize(m_csvChannels.size());
+
+  while (m_csvPos < m_csvSize)
+  {
+    const char* line = m_csvData + m_csvPos;
+    const char* end = (const char*)memchr(line, '\n', m_csvSize - m_csvPos);
+    int length = end ? (end - line) : (m_csvSize - m_csvPos);
+
+    m_csvPos += length + 1;
+
+    if ((length > 0) && (line[length - 1] == '\r'))
+    {
+      length--;
+    }
+
+    if ((length == 0) || (line[0] == '#') || !parseCsvTime(line, length, timeUs))
+    {
+      continue;
+    }
+
+    int pos = s_csvTimeLength;
+    for (int idx = 0; idx < values.size(); idx++)
+    {
+      int fieldLength = 0;
+
+      if ((pos < length) && (line[pos] == ','))
+      {
+        pos++;
+        while ((pos + fieldLength < length) && (line[pos + fieldLength] != ','))
+        {
+          fieldLength++;
+        }
+      }
+
+      const int copyLength = qMin(fieldLength, (int)sizeof(field) - 1);
+      memcpy(field, line + pos, copyLength);
+      field[copyLength] = 0;
+      values[idx] = strtod(field, 0);
+
+      pos += fieldLength;
+    }
+
+    return true;
+  }
+
+  return false;
+}
+
+/**
+ * Reads the next record from the log, whichever its format.
+ */
+bool LogReader::readNext(QVector<double>& values, qint64& timeUs)
+{
+  bool status = false;
+
+  if (m_isBinary)
+  {
+    status = m_binary.readRecord(values);
+    if (status)
+    {
+      timeUs = (m_binary.epoch().toMSecsSinceEpoch() * 1000) +
+               (qint64)values.at(m_binary.timeChannel());
+    }
+  }
+  else
+  {
+    status = readCsvRow(values, timeUs);
+  }
+
+  return status;
+}
+
+/**
+ * Reads the next record from the log.
+ * @param values Populated with the value of each channel
+ * @param timeUs Populated with the time of the record
+ * @return True if a record was read; false at the end of the log
+ */
+bool LogReader::readRecord(QVector<double>& values, qint64& timeUs)
+{
+  if (!m_isOpen)
+  {
+    return false;
+  }
+
+  if (m_hasPending)
+  {
+    values = m_pendingValues;
+    timeUs = m_pendingTimeUs;
+    m_hasPending = false;
+    return true;
+  }
+
+  return readNext(values, timeUs);
+}
+
+/**
+ * Positions the reader at the start of the section of log covered by an
+ * index entry.
+ */
+bool LogReader::seekToEntry(const IndexEntry& entry)
+{
+  m_hasPending = false;
+
+  if (m_isBinary)
+  {
+    return m_binary.seekToChunk(entry.headerOffset, entry.offset);
+  }
+
+  m_csvPos = entry.offset;
+  return true;
+}
+
+bool LogReader::isEarlierThan(qint64 timeUs, const IndexEntry& entry)
+{
+  return timeUs < entry.timeUs;
+}
+
+/**
+ * Positions the reader so that the next record read is the first one at or
+ * after the given time. The index is searched for the last entry that starts
+ * before the target, so at most one index interval is read and discarded.
+ * @param timeUs Time to seek to, in microseconds since the Unix epoch
+ * @return True if there's a record at or after the given time; false otherwise
+ */
+bool LogReader::seek(qint64 timeUs)
+{
+  if (!m_isOpen || m_index.isEmpty())
+  {
+    return false;
+  }
+
+  QVector<IndexEntry>::const_iterator entry =
+    std::upper_bound(m_index.constBegin(), m_index.constEnd(), timeUs, isEarlierThan);
+
+  if (entry != m_index.constBegin())
+  {
+    entry--;
+  }
+
+  if (!seekToEntry(*entry))
+  {
+    return false;
+  }
+
+  while (readNext(m_pendingValues, m_pendingTimeUs))
+  {
+    if (m_pendingTimeUs >= timeUs)
+    {
+      m_hasPending = true;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+/**
+ * Loads the index from disk, if it exists and was built from the log in its
+ * current state.
+ * @return True if a valid index was loaded; false otherwise
+ */
+bool LogReader::loadIndex()
+{
+  QFile file(indexFileName(m_fileName));
+  const QFileInfo logInfo(m_fileName);
+
+  if (!file.open(QFile::ReadOnly))
+  {
+    return false;
+  }
+
+  QDataStream in(&file);
+  in.setVersion(QDataStream::Qt_5_0);
+  in.setByteOrder(QDataStream::BigEndian);
+
+  quint32 magic = 0;
+  quint16 version = 0;
+  qint64 logSize = 0;
+  qint64 logModified = 0;
+  quint32 count = 0;
+
+  in >> magic >> version >> logSize >> logModified;
+
+  if ((magic != s_indexMagic) || (version != s_indexVersion) ||
+      (logSize != logInfo.size()) ||
+      (logModified != logInfo.lastModified().toMSecsSinceEpoch()))
+  {
+    return false;
+  }
+
+  in >> m_startTimeUs >> m_endTimeUs >> count;
+
+  // sanity check the count against the length of the file before allocating
+  if ((in.status() != QDataStream::Ok) || ((qint64)count * 24 > file.size()))
+  {
+    return false;
+  }
+
+  m_index.resize(count);
+  for (quint32 idx = 0; idx < count; idx++)
+  {
+    IndexEntry& e = m_index[idx];
+    in >> e.timeUs >> e.offset >> e.headerOffset;
+  }
+
+  if (in.status() != QDataStream::Ok)
+  {
+    m_index.clear();
+    return false;
+  }
+
+  return true;
+}
+
+/**
+ * Builds the index by reading through the whole log once.
+ * @return True if the log was read; false otherwise
+ */
+bool LogReader::buildIndex()
+{
+  QVector<double> values;
+  qint64 timeUs = 0;
+  qint64 lastChunkOffset = -1;
+  int rows = 0;
+
+  m_index.clear();
+
+  while (true)
+  {
+    const qint64 rowOffset = m_csvPos;
+
+    if (!readNext(values, timeUs))
+    {
+      break;
+    }
+
+    if (m_index.isEmpty())
+    {
+      m_startTimeUs = timeUs;
+      m_endTimeUs = timeUs;
+    }
+    m_endTimeUs = qMax(m_endTimeUs, timeUs);
+
+    IndexEntry e;
+    e.timeUs = timeUs;
+    e.offset = -1;
+    e.headerOffset = 0;
+
+    if (m_isBinary)
+    {
+      if (m_binary.chunkOffset() != lastChunkOffset)
+      {
+        lastChunkOffset = m_binary.chunkOffset();
+        e.offset = lastChunkOffset;
+        e.headerOffset = m_binary.headerOffset();
+      }
+    }
+    else if ((rows % s_csvRowsPerIndexEntry) == 0)
+    {
+      e.offset = rowOffset;
+    }
+
+    if (e.offset >= 0)
+    {
+      m_index.append(e);
+    }
+    rows++;
+  }
+
+  if (m_index.isEmpty())
+  {
+    m_errorString = "The log contains no records.";
+    return false;
+  }
+
+  return true;
+}
+
+/**
+ * Writes the index to disk. Failure isn't fatal; the index will simply be
+ * rebuilt the next time the log is opened.
+ */
+void LogReader::saveIndex()
+{
+  QFile file(indexFileName(m_fileName));
+  const QFileInfo logInfo(m_fileName);
+
+  if (file.open(QFile::WriteOnly | QFile::Truncate))
+  {
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_5_0);
+    out.setByteOrder(QDataStream::BigEndian);
+
+    out << s_indexMagic << s_indexVersion
+        << (qint64)logInfo.size() << (qint64)logInfo.lastModified().toMSecsSinceEpoch()
+        << m_startTimeUs << m_endTimeUs << (quint32)m_index.size();
+
+    foreach(const IndexEntry& e, m_index)
+    {
+      out << e.timeUs << e.offset << e.headerOffset;
+    }
+  }
+}
@@ -0,0 +1,125 @@
+#ifndef LOGREADER_H
+#define LOGREADER_H
+
+#include <QString>
+#include <QFile>
+#include <QVector>
+#include <QByteArray>
+#include "logchannels.h"
+#include "binarylog.h"
+
+/**
+ * Reads a data log (in either the CSV or binary format) and supports seeking
+ * to a point in time without scanning the whole file.
+ *
+ * Seeking uses a sparse index that maps wall-clock times to file offsets: one
+ * entry per records chunk for binary logs (each chunk begins with a full
+ * record), and one entry every few hundred rows for CSV logs. The index is
+ * built the first time a log is opened and saved alongside it, and is rebuilt
+ * whenever the log's size or modification time no longer match. The log
+ * itself is mapped into memory rather than read through a buffer.
+ *
+ * Times are in microseconds since 1970-01-01 UTC. The index assumes that
+ * records are in time order, as they are when written by the Logger.
+ */
+class LogReader
+{
+public:
+  LogReader();
+  ~LogReader();
+
+  bool open(QString fileName);
+  void close();
+
+  bool isOpen() const
+  {
+    return m_isOpen;
+  }
+
+  QString errorString() const
+  {
+    return m_errorString;
+  }
+
+  bool isBinary() const
+  {
+    return m_isBinary;
+  }
+
+  const QVector<LogChannel>& channels() const;
+
+  // Changes whenever a new set of channel descriptions takes effect
+  int headerCount() const
+  {
+    return m_isBinary ? m_binary.headerCount() : 1;
+  }
+
+  qint64 startTimeUs() const
+  {
+    return m_startTimeUs;
+  }
+
+  qint64 endTimeUs() const
+  {
+    return m_endTimeUs;
+  }
+
+  bool seek(qint64 timeUs);
+  bool readRecord(QVector<double>& values, qint64& timeUs);
+
+  static QString indexFileName(QString logFileName);
+
+  // Number of CSV rows between successive index entries
+  static const int s_csvRowsPerIndexEntry = 256;
+
+private:
+  struct IndexEntry
+  {
+    qint64 timeUs;
+    qint64 offset;
+    qint64 headerOffset;
+  };
+
+  static bool isEarlierThan(qint64 timeUs, const IndexEntry& entry);
+
+  static const quint32 s_indexMagic = 0x52474958;
+  static const quint16 s_indexVersion = 1;
+
+  QString m_fileName;
+  bool m_isOpen;
+  bool m_isBinary;
+  QString m_errorString;
+
+  QVector<IndexEntry> m_index;
+  qint64 m_startTimeUs;
+  qint64 m_endTimeUs;
+
+  QVector<double> m_pendingValues;
+  qint64 m_pendingTimeUs;
+  bool m_hasPending;
+
+  BinaryLogReader m_binary;
+
+  QFile m_csvFile;
+  const char* m_csvData;
+  qint64 m_csvSize;
+  qint64 m_csvPos;
+  bool m_csvMapped;
+  QByteArray m_csvFileData;
+  QVector<LogChannel> m_csvChannels;
+  QByteArray m_csvHourKey;
+  qint64 m_csvHourStartMs;
+
+  bool openCsv();
+  bool readCsvRow(QVector<double>& values, qint64& timeUs);
+  bool parseCsvTime(const char* line, int length, qint64& timeUs);
+
+  bool readNext(QVector<double>& values, qint64& timeUs);
+  bool seekToEntry(const IndexEntry& entry);
+
+  bool loadIndex();
+  bool buildIndex();
+  void saveIndex();
+};
+
+#endif // LOGREADER_H
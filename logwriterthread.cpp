@@ -0,0 +1,88 @@
+#include "logwriterthread.h"
+#include "logger.h"
+
+/**
+ * Constructor.
+ * @param logger Logger whose writeRecords() is called with each batch
+ */
+LogWriterThread::LogWriterThread(Logger* logger) :
+  m_logger(logger),
+  m_ring(s_ringCapacityPow2)
+{
+}
+
+/**
+ * Queues a record to be written. Called from the producer thread only.
+ * @return False if the record was dropped because the queue is full
+ */
+bool LogWriterThread::enqueue(const LogRecord& record)
+{
+  if (!m_ring.push(record))
+  {
+    m_droppedRecords.fetchAndAddRelaxed(1);
+    return false;
+  }
+
+  const int queued = m_ring.size();
+  if (queued > m_maxQueuedRecords.loadAcquire())
+  {
+    m_maxQueuedRecords.storeRelease(queued);
+  }
+
+  return true;
+}
+
+/**
+ * Asks the writer to finish and waits for it to do so. Everything queued
+ * before this call is written first.
+ */
+void LogWriterThread::stop()
+{
+  if (isRunning())
+  {
+    m_stopRequested.storeRelease(1);
+    wait();
+  }
+
+  m_stopRequested.storeRelease(0);
+}
+
+/**
+ * Clears the dropped and high-water-mark counts. Call while the writer is
+ * stopped.
+ */
+void LogWriterThread::resetCounters()
+{
+  m_droppedRecords.storeRelease(0);
+  m_maxQueuedRecords.storeRelease(0);
+}
+
+/**
+ * Writer loop. Drains the ring in batches, sleeping whenever it's empty, until
+ * a stop is requested and the ring has been emptied.
+ */
+void LogWriterThread::run()
+{
+  QVector<LogRecord> batch(s_maxBatchSize);
+
+  forever
+  {
+    // check for a stop request before draining, so that nothing queued
+    // ahead of the request is left behind
+    const bool stopping = m_stopRequested.loadAcquire();
+    const int count = m_ring.pop(batch.data(), s_maxBatchSize);
+
+    if (count > 0)
+    {
+      m_logger->writeRecords(batch.constData(), count);
+    }
+    else if (stopping)
+    {
+      break;
+    }
+    else
+    {
+      msleep(s_idleSleepMs);
+    }
+  }
+}
@@ -0,0 +1,59 @@
+#ifndef LOGWRITERTHREAD_H
+#define LOGWRITERTHREAD_H
+
+#include <QThread>
+#include <QAtomicInt>
+#include "logchannels.h"
+#include "spscring.h"
+
+class Logger;
+
+/**
+ * Writes log records to disk on a dedicated thread, so that a slow storage
+ * device never stalls the GUI or polling threads. Records are passed from the
+ * polling thread through a lock-free ring; the writer wakes periodically,
+ * takes everything that has been queued and hands it to the Logger as a
+ * single batch. If the ring fills up (because the disk has fallen behind),
+ * new records are dropped and counted rather than blocking the producer.
+ */
+class LogWriterThread : public QThread
+{
+public:
+  explicit LogWriterThread(Logger* logger);
+
+  bool enqueue(const LogRecord& record);
+  void stop();
+  void resetCounters();
+
+  int droppedRecords() const
+  {
+    return m_droppedRecords.loadAcquire();
+  }
+
+  int maxQueuedRecords() const
+  {
+    return m_maxQueuedRecords.loadAcquire();
+  }
+
+protected:
+  void run();
+
+private:
+  // Log2 of the ring capacity: 4096 records, which is over half a minute of
+  // data at the fastest polling rates
+  static const int s_ringCapacityPow2 = 12;
+
+  // Most records handed to the Logger at once
+  static const int s_maxBatchSize = 256;
+
+  // Time the writer sleeps when it finds the ring empty
+  static const unsigned int s_idleSleepMs = 50;
+
+  Logger* m_logger;
+  SpscRing<LogRecord> m_ring;
+  QAtomicInt m_stopRequested;
+  QAtomicInt m_droppedRecords;
+  QAtomicInt m_maxQueuedRecords;
+};
+
+#endif // LOGWRITERTHREAD_H
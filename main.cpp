@@ -2,7 +2,12 @@
 #include <QCommandLineParser>
 #include <QCommandLineOption>
 #include <QString>
+#include <QTextStream>
 #include "mainwindow.h"
+#include "comm14cuxtransport.h"
+#include "virtualecutransport.h"
+#include "recordingtransport.h"
+#include "replaytransport.h"
 
 int main(int argc, char* argv[])
 {
@@ -25,6 +30,14 @@ int main(int argc, char* argv[])
   QCommandLineOption doublebaudOption
       ({"d", "doublebaud"}, "Connect to an ECU that has customized firmware doubling the serial baud rate.");
   doublebaudOption.setFlags(QCommandLineOption::HiddenFromHelp);
+  const QCommandLineOption virtualEcuOption
+      ("virtual-ecu", "Connect to a simulated ECU instead of a serial device (for testing.)");
+  const QCommandLineOption recordOption
+      ("record", "Record all traffic with the ECU to <file>.", "file");
+  const QCommandLineOption replayOption
+      ("replay", "Play back a session recorded with --record instead of connecting to an ECU.", "file");
+  const QCommandLineOption replayFastOption
+      ("replay-fast", "Play back the recorded session as fast as possible rather than in real time.");
 
   parser.addHelpOption();
   parser.addVersionOption();
@@ -32,10 +45,51 @@ int main(int argc, char* argv[])
   parser.addOption(autologOption);
   parser.addOption(fullscreenOption);
   parser.addOption(doublebaudOption);
+  parser.addOption(virtualEcuOption);
+  parser.addOption(recordOption);
+  parser.addOption(replayOption);
+  parser.addOption(replayFastOption);
 
   parser.process(a);
 
-  MainWindow w (parser.isSet(autoconnectOption),
+  EcuTransport* transport = 0;
+
+  if (parser.isSet(replayOption))
+  {
+    ReplayTransport* replay = new ReplayTransport(parser.value(replayOption), !parser.isSet(replayFastOption));
+
+    if (!replay->isValid())
+    {
+      QTextStream(stderr) << "Unable to read " << parser.value(replayOption) << ": " << replay->errorString() << endl;
+      delete replay;
+      return 1;
+    }
+    transport = replay;
+  }
+  else if (parser.isSet(virtualEcuOption))
+  {
+    transport = new VirtualEcuTransport();
+  }
+  else
+  {
+    transport = new Comm14CUXTransport();
+  }
+
+  if (parser.isSet(recordOption))
+  {
+    RecordingTransport* recorder = new RecordingTransport(transport, parser.value(recordOption));
+
+    if (!recorder->isRecording())
+    {
+      QTextStream(stderr) << "Unable to record to " << parser.value(recordOption) << ": " << recorder->errorString() << endl;
+      delete recorder;
+      return 1;
+    }
+    transport = recorder;
+  }
+
+  MainWindow w (transport,
+                parser.isSet(autoconnectOption),
                 parser.isSet(autologOption),
                 parser.isSet(doublebaudOption));
 
@@ -5,9 +5,15 @@
 #include <QFileDialog>
 #include <QGraphicsOpacityEffect>
 #include <QIcon>
+#include <QElapsedTimer>
+#include <QRegExp>
+#include <QApplication>
+#include <QDir>
+#include <QFileInfo>
 #include "mainwindow.h"
 #include "ui_mainwindow.h"
 #include "faultcodedialog.h"
+#include "romanalyzer.h"
 
 const float MainWindow::s_speedometerMaxMPH = 160.0;
 const float MainWindow::s_speedometerMaxKPH = 240.0;
@@ -17,7 +23,8 @@ const float MainWindow::s_speedometerMaxKPH = 240.0;
 /**
  * Constructor; sets up main UI
  */
-MainWindow::MainWindow (bool autoconnect,
+MainWindow::MainWindow (EcuTransport* transport,
+                        bool autoconnect,
                         bool autolog,
                         bool doublebaud,
                         QWidget* parent)
@@ -33,8 +40,19 @@ MainWindow::MainWindow (bool autoconnect,
     m_aboutBox(0),
     m_pleaseWaitBox(0),
     m_helpViewerDialog(0),
+    m_linkMetricsDialog(0),
+    m_fuelMapResidencyDialog(0),
+    m_dashboardDialog(0),
+    m_logPlayer(0),
+    m_logPlaybackDialog(0),
+    m_romLibrary(0),
     m_doubleBaudRate(doublebaud),
+    m_fuelMapModel(0),
     m_fuelMapDataIsCurrent(false),
+    m_displayPending(false),
+    m_displayFuelMapPosition(false),
+    m_displayedSampleValid(false),
+    m_displayedFuelMapPosition(false),
     m_isLogging(false)
 {
   // register this special enum type for use in Qt signals/slots
@@ -48,13 +66,17 @@ MainWindow::MainWindow (bool autoconnect,
                        QString::number(ROVERGAUGE_VER_PATCH));
 
   m_options = new OptionsDialog(this->windowTitle(), this);
-  m_cux = new CUXInterface(m_options->getSerialDeviceName(), CUXInterface::getBaudRate(doublebaud),
+  m_cux = new CUXInterface(transport, m_options->getSerialDeviceName(), CUXInterface::getBaudRate(doublebaud),
                            m_options->getSpeedUnits(), m_options->getTemperatureUnits(),
                            m_options->getRefreshFuelMap());
+  m_sample = m_cux->getLatestSample();
+  m_lastSampleSequence = m_sample.sequence;
 
   m_enabledSamples = m_options->getEnabledSamples();
   m_cux->setEnabledSamples(m_enabledSamples);
   m_cux->setReadIntervals(m_options->getReadIntervals());
+  m_cux->setReadIntervalBounds(m_options->getReadIntervalBounds());
+  m_cux->setAdaptiveReadIntervals(m_options->getAdaptiveReadIntervals());
 
   m_iacDialog = new IdleAirControlDialog(this->windowTitle(), this);
   connect(m_iacDialog, SIGNAL(requestIdleAirControlMovement(int, int)),
@@ -65,10 +87,9 @@ MainWindow::MainWindow (bool autoconnect,
   m_fuelPumpRefreshTimer = new QTimer(this);
   m_fuelPumpRefreshTimer->setInterval(1000);
 
-  for (int idx = 0; idx < NUM_ACTIVE_FUEL_MAP_CELLS; idx += 1)
-  {
-    m_lastHighlightedFuelMapCell[idx] = 0;
-  }
+  m_displayTimer = new QTimer(this);
+  m_displayTimer->setSingleShot(true);
+  setDisplayRate(m_options->getDisplayRateHz());
 
   m_shortcutStartLogging = new QShortcut(QKeySequence(Qt::Key_F5), this);
   m_shortcutStopLogging  = new QShortcut(QKeySequence(Qt::Key_F7), this);
@@ -90,6 +111,7 @@ MainWindow::MainWindow (bool autoconnect,
   connect(m_cux, SIGNAL(revisionNumberReady(int, int, int)), this, SLOT(onTuneRevisionReady(int, int, int)));
   connect(m_cux, SIGNAL(interfaceReadyForPolling()),         this, SLOT(onInterfaceReady()));
   connect(m_cux, SIGNAL(notConnected()),                     this, SLOT(onNotConnected()));
+  connect(m_cux, SIGNAL(romImageProgress(int, int)),         this, SLOT(onROMImageProgress(int, int)));
   connect(m_cux, SIGNAL(romImageReady()),                    this, SLOT(onROMImageReady()));
   connect(m_cux, SIGNAL(romImageReadFailed()),               this, SLOT(onROMImageReadFailed()));
   connect(m_cux, SIGNAL(rpmLimitReady(int)),                 this, SLOT(onRPMLimitReady(int)));
@@ -100,7 +122,9 @@ MainWindow::MainWindow (bool autoconnect,
   connect(m_cux, SIGNAL(forceOpenLoopState(bool)), this, SLOT(onForceOpenLoopStateReceived(bool)));
 #endif
   connect(m_fuelPumpRefreshTimer, SIGNAL(timeout()), m_cux, SLOT(onFuelPumpRunRequest()));
+  connect(m_displayTimer, SIGNAL(timeout()), this, SLOT(onDisplayTimerExpired()));
   connect(this, SIGNAL(requestToStartPolling()), m_cux, SLOT(onStartPollingRequest()));
+  connect(this, SIGNAL(requestDisconnect()), m_cux, SLOT(onDisconnectRequest()));
   connect(this, SIGNAL(requestThreadShutdown()), m_cux, SLOT(onShutdownThreadRequest()));
   connect(this, SIGNAL(requestFuelMapData(unsigned int)), m_cux, SLOT(onFuelMapRequested(unsigned int)));
   connect(this, SIGNAL(requestROMImage()), m_cux, SLOT(onReadROMImageRequested()));
@@ -137,6 +161,7 @@ MainWindow::~MainWindow()
   delete m_cux;
   delete m_cuxThread;
   delete m_batteryBackedDisplay;
+  delete m_romLibrary;
 }
 
 /**
@@ -178,11 +203,19 @@ void MainWindow::setupWidgets()
 
   // connect menu item signals
   connect(m_ui->m_saveROMImageAction,   SIGNAL(triggered()),     this,  SLOT(onSaveROMImageSelected()));
+  connect(m_ui->m_analyzeROMImagesAction, SIGNAL(triggered()),   this,  SLOT(onAnalyzeROMImagesSelected()));
+  connect(m_ui->m_addROMsToLibraryAction, SIGNAL(triggered()),   this,  SLOT(onAddROMsToLibrarySelected()));
+  connect(m_ui->m_findClosestROMAction, SIGNAL(triggered()),     this,  SLOT(onFindClosestROMSelected()));
+  connect(m_ui->m_convertBinaryLogAction, SIGNAL(triggered()),   this,  SLOT(onConvertBinaryLogSelected()));
+  connect(m_ui->m_playBackLogAction,    SIGNAL(triggered()),     this,  SLOT(onPlayBackLogSelected()));
   connect(m_ui->m_exitAction,           SIGNAL(triggered()),     this,  SLOT(onExitSelected()));
   connect(m_ui->m_showFaultCodesAction, SIGNAL(triggered()),     m_cux, SLOT(onFaultCodesRequested()));
   connect(m_ui->m_idleAirControlAction, SIGNAL(triggered()),     this,  SLOT(onIdleAirControlClicked()));
   connect(m_ui->m_batteryBackedAction,  SIGNAL(triggered(bool)), m_cux, SLOT(onBatteryBackedMemRequested()));
   connect(m_ui->m_editSettingsAction,   SIGNAL(triggered()),     this,  SLOT(onEditOptionsClicked()));
+  connect(m_ui->m_linkMetricsAction,    SIGNAL(triggered()),     this,  SLOT(onLinkMetricsClicked()));
+  connect(m_ui->m_fuelMapResidencyAction, SIGNAL(triggered()),   this,  SLOT(onFuelMapResidencyClicked()));
+  connect(m_ui->m_dashboardAction,      SIGNAL(triggered()),     this,  SLOT(onDashboardClicked()));
   connect(m_ui->m_helpContentsAction,   SIGNAL(triggered()),     this,  SLOT(onHelpContentsClicked()));
   connect(m_ui->m_helpAboutAction,      SIGNAL(triggered()),     this,  SLOT(onHelpAboutClicked()));
 
@@ -235,27 +268,15 @@ void MainWindow::setupWidgets()
   m_ui->m_fuelPumpRelayStateLed->setDisabled(true);
 
   // set up the fuel map display
-  setStyleSheet("QTableWidget {background-color: transparent;}");
+  setStyleSheet("QTableView {background-color: transparent;}");
 
+  m_fuelMapModel = new FuelMapModel(this);
+  m_ui->m_fuelMapDisplay->setModel(m_fuelMapModel);
+  m_ui->m_fuelMapDisplay->setItemDelegate(new FuelMapDelegate(m_fuelMapModel, this));
+  m_ui->m_fuelMapDisplay->setSelectionMode(QAbstractItemView::NoSelection);
   m_ui->m_fuelMapDisplay->horizontalHeader()->setStyleSheet("QHeaderView { font-size: 11pt; }");
   m_ui->m_fuelMapDisplay->horizontalHeader()->setSectionResizeMode(QHeaderView::Stretch);
   m_ui->m_fuelMapDisplay->verticalHeader()->setSectionResizeMode(QHeaderView::Stretch);
-  unsigned int rowCount = m_ui->m_fuelMapDisplay->rowCount();
-  unsigned int colCount = m_ui->m_fuelMapDisplay->columnCount();
-  QTableWidgetItem* item = 0;
-
-  for (int col = 0; col < colCount; col++)
-  {
-    m_ui->m_fuelMapDisplay->setHorizontalHeaderItem(col, new QTableWidgetItem(""));
-
-    for (int row = 0; row < rowCount; row++)
-    {
-      item = new QTableWidgetItem("");
-      item->setTextAlignment(Qt::AlignCenter);
-      item->setFlags(0);
-      m_ui->m_fuelMapDisplay->setItem(row, col, item);
-    }
-  }
 
   m_ui->m_logFileNameBox->setText(QDateTime::currentDateTime().toString("yyyy-MM-dd_hh.mm.ss"));
   m_ui->m_injectorDutyCycleBar->setAlignment(Qt::AlignCenter);
@@ -391,7 +412,7 @@ void MainWindow::onInterfaceReady()
 void MainWindow::onDisconnectClicked()
 {
   m_ui->m_disconnectButton->setEnabled(false);
-  m_cux->disconnectFromECU();
+  emit requestDisconnect();
   m_logger->onDisconnect();
 }
 
@@ -451,38 +472,15 @@ void MainWindow::onBatteryBackedMemReadFailed()
 
 /**
  * Uses a fuel map array to populate a 16x8 grid that shows all the fueling
- * values.
+ * values. Only the cells whose values differ from those already displayed
+ * are repainted.
  * @param data Pointer to the ByteArray that contains the map data
  */
 void MainWindow::populateFuelMapDisplay(const QByteArray* data, unsigned int fuelMapMultiplier, unsigned int rowScaler)
 {
   if (data != 0)
   {
-    int rowCount = m_ui->m_fuelMapDisplay->rowCount();
-    int colCount = m_ui->m_fuelMapDisplay->columnCount();
-    QTableWidgetItem* item = 0;
-    unsigned char byte = 0;
-
-    removeFuelMapCellHighlight();
-
-    // populate all the cells with the data for this map
-    for (int row = 0; row < rowCount; row++)
-    {
-      for (int col = 0; col < colCount; col++)
-      {
-        item = m_ui->m_fuelMapDisplay->item(row, col);
-
-        if (item != 0)
-        {
-          // retrieve the fuel map value at the current row/col
-          byte = data->at(row * colCount + col);
-
-          item->setText(QString("%1").arg(byte, 2, 16, QChar('0')).toUpper());
-          item->setBackgroundColor(getColorForFuelMapCell(byte));
-          item->setTextColor(Qt::black);
-        }
-      }
-    }
+    m_fuelMapModel->setFuelMap(*data);
 
     QString label = QString("%1").arg(fuelMapMultiplier, 0, 16).toUpper();
     m_ui->m_fuelMapFactorLabel->setText(QString("Multiplier: 0x") + label);
@@ -509,23 +507,136 @@ void MainWindow::onFuelMapDataReady(unsigned int fuelMapId)
                            m_cux->getRowScaler(fuelMapId));
     m_fuelMapDataIsCurrent = true;
 
+    // the new map has to be highlighted at the engine's current position even
+    // if that position hasn't changed since the last sample was displayed
+    m_displayedFuelMapPosition = false;
+
     m_logger->onFuelMapDataReady(fuelMapId);
   }
 }
 
 /**
- * Updates the gauges and indicators with the latest data available from
- * the ECU.
+ * Passes the latest snapshot of data published by the ECU interface to the
+ * logger, and schedules the gauges and indicators to be updated with it.
+ * (The rows of the log itself are queued by the interface as each snapshot is
+ * published.) Only the latest snapshot is kept, so when the GUI falls behind,
+ * several queued signals can find the same one; it's handled only for the
+ * first of them.
  */
 void MainWindow::onDataReady()
 {
+  QElapsedTimer processingTimer;
+
+  processingTimer.start();
+
+  const EcuSample& sample = m_cux->getLatestSample();
+
+  if (sample.sequence <= m_lastSampleSequence)
+  {
+    return;
+  }
+
+  m_sample = sample;
+  m_lastSampleSequence = sample.sequence;
+  m_logger->onDataReady(m_sample);
+
+  requestDisplayUpdate(m_fuelMapDataIsCurrent);
+
+  m_cux->getLinkMetrics()->recordGuiProcessing(processingTimer.nsecsElapsed() / 1000);
+}
+
+/**
+ * Updates the display with the current sample, unless it was updated less
+ * than one frame period ago. In that case the update is deferred until the
+ * frame timer expires, and any other samples that arrive in the meantime are
+ * coalesced into it, so that the display is redrawn no faster than the
+ * configured rate however quickly the ECU is being polled.
+ * @param showFuelMapPosition True to highlight the active fuel map cells
+ */
+void MainWindow::requestDisplayUpdate(bool showFuelMapPosition)
+{
+  m_displayFuelMapPosition = showFuelMapPosition;
+
+  if (m_displayTimer->isActive())
+  {
+    m_displayPending = true;
+  }
+  else
+  {
+    m_displayPending = false;
+    displaySample(m_displayFuelMapPosition);
+
+    if (m_displayTimer->interval() > 0)
+    {
+      m_displayTimer->start();
+    }
+  }
+}
+
+/**
+ * Ends the current frame period, drawing the most recent sample if any
+ * arrived during it.
+ */
+void MainWindow::onDisplayTimerExpired()
+{
+  if (m_displayPending)
+  {
+    QElapsedTimer processingTimer;
+
+    processingTimer.start();
+
+    m_displayPending = false;
+    displaySample(m_displayFuelMapPosition);
+    m_displayTimer->start();
+
+    m_cux->getLinkMetrics()->recordGuiProcessing(processingTimer.nsecsElapsed() / 1000);
+  }
+}
+
+/**
+ * Sets the maximum rate at which the display is redrawn.
+ * @param rateHz Frames per second, or zero to redraw on every sample
+ */
+void MainWindow::setDisplayRate(unsigned int rateHz)
+{
+  m_displayTimer->setInterval((rateHz > 0) ? (1000 / rateHz) : 0);
+}
+
+/**
+ * Forgets what the widgets are showing, so that the next sample displayed
+ * updates all of them. This is needed whenever the widgets are changed
+ * other than by displaySample() (e.g. when they're reset on disconnect, or
+ * when the display units change).
+ */
+void MainWindow::invalidateDisplay()
+{
+  m_displayTimer->stop();
+  m_displayPending = false;
+  m_displayedSampleValid = false;
+}
+
+/**
+ * Updates the gauges and indicators from the current sample, which is either
+ * live data from the ECU or a record from a log being played back. Only the
+ * widgets whose values differ from the last sample displayed are touched.
+ * @param showFuelMapPosition True to highlight the active fuel map cells
+ */
+void MainWindow::displaySample(bool showFuelMapPosition)
+{
+  const EcuSample& last = m_displayedSample;
+  const bool all = !m_displayedSampleValid;
   int rpm = 0;
   float pulseWidth = 0;
 
-  m_ui->m_milLed->setChecked(m_cux->isMILOn());
+  m_ui->m_milLed->setChecked(m_sample.milOn);
 
   // if fuel map display updates are enabled...
-  if (m_enabledSamples[SampleType_FuelMapRowCol] && m_fuelMapDataIsCurrent)
+  if (m_enabledSamples[SampleType_FuelMapRowCol] && showFuelMapPosition &&
+      (all || !m_displayedFuelMapPosition ||
+       (m_sample.fuelMapRowIndex != last.fuelMapRowIndex) ||
+       (m_sample.fuelMapColumnIndex != last.fuelMapColumnIndex) ||
+       (m_sample.fuelMapRowWeighting != last.fuelMapRowWeighting) ||
+       (m_sample.fuelMapColWeighting != last.fuelMapColWeighting)))
   {
     removeFuelMapCellHighlight();
     highlightActiveFuelMapCells();
@@ -533,62 +644,64 @@ void MainWindow::onDataReady()
 
   if (m_enabledSamples[SampleType_Throttle])
   {
-    m_ui->m_throttleBar->setValue(m_cux->getThrottlePos() * 100);
+    m_ui->m_throttleBar->setValue(m_sample.throttlePos * 100);
   }
 
   if (m_enabledSamples[SampleType_MAF])
   {
-    m_ui->m_mafReadingBar->setValue(m_cux->getMAFReading() * 100);
+    m_ui->m_mafReadingBar->setValue(m_sample.mafReading * 100);
   }
 
   if (m_enabledSamples[SampleType_IdleBypassPosition])
   {
-    m_ui->m_idleBypassPosBar->setValue(m_cux->getIdleBypassPos() * 100);
+    m_ui->m_idleBypassPosBar->setValue(m_sample.idleBypassPos * 100);
   }
 
-  if (m_enabledSamples[SampleType_RoadSpeed])
+  if (m_enabledSamples[SampleType_RoadSpeed] && (all || (m_sample.roadSpeedMPH != last.roadSpeedMPH)))
   {
     if (m_options->getSpeedoAdjust())
     {
       int adjustedSpeed =
-        (m_cux->getRoadSpeed() * m_options->getSpeedoMultiplier()) + m_options->getSpeedoOffset();
+        (m_cux->convertSpeed(m_sample.roadSpeedMPH) * m_options->getSpeedoMultiplier()) + m_options->getSpeedoOffset();
       m_ui->m_speedo->setValue(adjustedSpeed);
     }
     else
     {
-      m_ui->m_speedo->setValue((int)m_cux->getRoadSpeed());
+      m_ui->m_speedo->setValue((int)m_cux->convertSpeed(m_sample.roadSpeedMPH));
     }
   }
 
   if (m_enabledSamples[SampleType_EngineRPM])
   {
-    rpm = m_cux->getEngineSpeedRPM();
+    rpm = m_sample.engineSpeedRPM;
     m_ui->m_revCounter->setValue(rpm);
   }
 
-  if (m_enabledSamples[SampleType_EngineTemperature])
+  if (m_enabledSamples[SampleType_EngineTemperature] && (all || (m_sample.coolantTempF != last.coolantTempF)))
   {
-    m_ui->m_waterTempGauge->setValue(m_cux->getCoolantTemp());
+    m_ui->m_waterTempGauge->setValue(m_cux->convertTemperature(m_sample.coolantTempF));
   }
 
-  if (m_enabledSamples[SampleType_FuelTemperature])
+  if (m_enabledSamples[SampleType_FuelTemperature] && (all || (m_sample.fuelTempF != last.fuelTempF)))
   {
-    m_ui->m_fuelTempGauge->setValue(m_cux->getFuelTemp());
+    m_ui->m_fuelTempGauge->setValue(m_cux->convertTemperature(m_sample.fuelTempF));
   }
 
-  if (m_enabledSamples[SampleType_MainVoltage])
+  if (m_enabledSamples[SampleType_MainVoltage] && (all || (m_sample.mainVoltage != last.mainVoltage)))
   {
-    m_ui->m_voltage->setText(QString::number(m_cux->getMainVoltage(), 'f', 1) + "V");
+    m_ui->m_voltage->setText(QString::number(m_sample.mainVoltage, 'f', 1) + "V");
   }
 
   if (m_enabledSamples[SampleType_FuelPumpRelay])
   {
-    m_ui->m_fuelPumpRelayStateLed->setChecked(m_cux->getFuelPumpRelayState());
+    m_ui->m_fuelPumpRelayStateLed->setChecked(m_sample.fuelPumpRelayOn);
   }
 
-  if (m_enabledSamples[SampleType_InjectorPulseWidth])
+  if (m_enabledSamples[SampleType_InjectorPulseWidth] &&
+      (all || (m_sample.injectorPulseWidthMs != last.injectorPulseWidthMs) ||
+       (m_sample.engineSpeedRPM != last.engineSpeedRPM)))
   {
-    pulseWidth = m_cux->getInjectorPulseWidthMs();
+    pulseWidth = m_sample.injectorPulseWidthMs;
 
     // if we're also monitoring the engine speed, we can compute the injector duty
     // cycle as a percentage of the time available between spark interrupts
@@ -600,9 +713,10 @@ void MainWindow::onDataReady()
     m_ui->m_injectorPulseWidthLabel->setText(QString("Pulse width: %1 ms").arg(pulseWidth, 0, 'f', 2));
   }
 
-  if (m_enabledSamples[SampleType_TargetIdleRPM])
+  if (m_enabledSamples[SampleType_TargetIdleRPM] &&
+      (all || (m_sample.targetIdleSpeed != last.targetIdleSpeed) || (m_sample.idleMode != last.idleMode)))
   {
-    int targetIdleSpeedRPM = m_cux->getTargetIdleSpeed();
+    int targetIdleSpeedRPM = m_sample.targetIdleSpeed;
 
     if (targetIdleSpeedRPM > 0)
     {
@@ -613,26 +727,37 @@ void MainWindow::onDataReady()
       m_ui->m_targetIdle->setText("");
     }
 
-    m_ui->m_idleModeLed->setChecked(m_cux->getIdleMode());
+    m_ui->m_idleModeLed->setChecked(m_sample.idleMode);
   }
 
+  // the trim label is shared between the lambda trim and the CO trim, so a
+  // change of feedback mode redraws whichever one now owns it
+  const bool modeChanged = all || (m_sample.feedbackMode != last.feedbackMode);
+
   if ((m_enabledSamples[SampleType_LambdaTrimShort] || m_enabledSamples[SampleType_LambdaTrimLong]) &&
-      (m_cux->getFeedbackMode() == C14CUX_FeedbackMode_ClosedLoop))
+      (m_sample.feedbackMode == C14CUX_FeedbackMode_ClosedLoop) &&
+      (modeChanged || (m_sample.lambdaTrimOdd != last.lambdaTrimOdd) ||
+       (m_sample.lambdaTrimEven != last.lambdaTrimEven)))
   {
-    setLambdaTrimIndicators(m_cux->getLambdaTrimOdd(), m_cux->getLambdaTrimEven());
+    setLambdaTrimIndicators(m_sample.lambdaTrimOdd, m_sample.lambdaTrimEven);
   }
 
-  if (m_enabledSamples[SampleType_COTrimVoltage] && (m_cux->getFeedbackMode() == C14CUX_FeedbackMode_OpenLoop))
+  if (m_enabledSamples[SampleType_COTrimVoltage] && (m_sample.feedbackMode == C14CUX_FeedbackMode_OpenLoop) &&
+      (modeChanged || (m_sample.coTrimVoltage != last.coTrimVoltage)))
   {
-    m_ui->m_oddFuelTrimBarAndMAFCOLabel->setText(QString::number(m_cux->getCOTrimVoltage(), 'f', 2) + "V");
+    m_ui->m_oddFuelTrimBarAndMAFCOLabel->setText(QString::number(m_sample.coTrimVoltage, 'f', 2) + "V");
   }
 
-  if (m_enabledSamples[SampleType_GearSelection])
+  if (m_enabledSamples[SampleType_GearSelection] && (all || (m_sample.gear != last.gear)))
   {
-    setGearLabel(m_cux->getGear());
+    setGearLabel(m_sample.gear);
   }
 
-  m_logger->logData();
+  updateDashboard();
+
+  m_displayedSample = m_sample;
+  m_displayedSampleValid = true;
+  m_displayedFuelMapPosition = showFuelMapPosition;
 }
 
 /**
@@ -686,85 +811,9 @@ void MainWindow::setGearLabel(c14cux_gear gearReading)
  */
 void MainWindow::highlightActiveFuelMapCells()
 {
-  int fuelMapRow = m_cux->getFuelMapRowIndex();
-  int fuelMapCol = m_cux->getFuelMapColumnIndex();
-  int rowWeight = m_cux->getFuelMapRowWeighting();
-  int colWeight = m_cux->getFuelMapColWeighting();
-
-  if (m_options->getSoftHighlight())
-  {
-    int idx;
-    QColor currentColor;
-    QColor newColor;
-
-    // Compute the distribution of shading that should be applied left/right
-    // and top/bottom to the block of four cells.
-    float leftPercent = 1.0 - (colWeight / 15.0);
-    float rightPercent = 1.0 - leftPercent;
-    float topPercent = 1.0 - (rowWeight / 15.0);
-    float bottomPercent = 1.0 - topPercent;
-
-    float shadePercentage[NUM_ACTIVE_FUEL_MAP_CELLS];
-
-    // We subtract from 1.0 here because these values will be used as multipliers
-    // against the un-highlighted cell's R/G/B components to produce a shade of
-    // the appropriate darkness.
-    shadePercentage[0] = 1.0 - (leftPercent * topPercent);
-    shadePercentage[1] = 1.0 - (rightPercent * topPercent);
-    shadePercentage[2] = 1.0 - (leftPercent * bottomPercent);
-    shadePercentage[3] = 1.0 - (rightPercent * bottomPercent);
-
-    m_lastHighlightedFuelMapCell[0] = m_ui->m_fuelMapDisplay->item(fuelMapRow, fuelMapCol);
-    m_lastHighlightedFuelMapCell[1] = m_ui->m_fuelMapDisplay->item(fuelMapRow, fuelMapCol + 1);
-    m_lastHighlightedFuelMapCell[2] = m_ui->m_fuelMapDisplay->item(fuelMapRow + 1, fuelMapCol);
-    m_lastHighlightedFuelMapCell[3] = m_ui->m_fuelMapDisplay->item(fuelMapRow + 1, fuelMapCol + 1);
-
-    for (idx = 0; idx < NUM_ACTIVE_FUEL_MAP_CELLS; idx += 1)
-    {
-      if (m_lastHighlightedFuelMapCell[idx] != 0)
-      {
-        currentColor = m_lastHighlightedFuelMapCell[idx]->backgroundColor();
-        newColor.setRgb(currentColor.red() * shadePercentage[idx],
-                        currentColor.green() * shadePercentage[idx],
-                        currentColor.blue() * shadePercentage[idx]);
-        m_lastHighlightedFuelMapCell[idx]->setBackgroundColor(newColor);
-        m_lastHighlightedFuelMapCell[idx]->setTextColor((newColor.value() > 128) ? Qt::black : Qt::white);
-      }
-    }
-  }
-  else
-  {
-    // we're not doing a soft-highlight using the weightings, so simply use the row/column
-    // weight to round up to the next row/col index if appropriate
-    if (rowWeight >= 8)
-    {
-      fuelMapRow += 1;
-
-      if (fuelMapRow >= FUEL_MAP_ROWS)
-      {
-        fuelMapRow = FUEL_MAP_ROWS - 1;
-      }
-    }
-
-    if (colWeight >= 8)
-    {
-      fuelMapCol += 1;
-
-      if (fuelMapCol >= FUEL_MAP_COLUMNS)
-      {
-        fuelMapCol = FUEL_MAP_COLUMNS - 1;
-      }
-    }
-
-    // we're only highlighting a single cell (not a block of four), so zero the other pointers
-    m_lastHighlightedFuelMapCell[0] = m_ui->m_fuelMapDisplay->item(fuelMapRow, fuelMapCol);
-    m_lastHighlightedFuelMapCell[1] = 0;
-    m_lastHighlightedFuelMapCell[2] = 0;
-    m_lastHighlightedFuelMapCell[3] = 0;
-
-    m_lastHighlightedFuelMapCell[0]->setBackgroundColor(Qt::black);
-    m_lastHighlightedFuelMapCell[0]->setTextColor(Qt::white);
-  }
+  m_fuelMapModel->setHighlight(m_sample.fuelMapRowIndex, m_sample.fuelMapColumnIndex,
+                               m_sample.fuelMapRowWeighting, m_sample.fuelMapColWeighting,
+                               m_options->getSoftHighlight());
 }
 
 /**
@@ -773,28 +822,7 @@ void MainWindow::highlightActiveFuelMapCells()
  */
 void MainWindow::removeFuelMapCellHighlight()
 {
-  for (int idx = 0; idx < NUM_ACTIVE_FUEL_MAP_CELLS; idx += 1)
-  {
-    if (m_lastHighlightedFuelMapCell[idx] != 0)
-    {
-      bool ok = false;
-      unsigned char value = (unsigned char)(m_lastHighlightedFuelMapCell[idx]->text().toInt(&ok, 16));
-
-      if (ok)
-      {
-        m_lastHighlightedFuelMapCell[idx]->setBackgroundColor(getColorForFuelMapCell(value));
-        m_lastHighlightedFuelMapCell[idx]->setTextColor(Qt::black);
-      }
-    }
-  }
-}
-
-/**
- * Generates a color whose intensity corresponds to a fueling value
- */
-QColor MainWindow::getColorForFuelMapCell(unsigned char value)
-{
-  return QColor::fromRgb(255, (value / 2 * -1) + 255, 255.0 - value);
+  m_fuelMapModel->clearHighlight();
 }
 
 /**
@@ -863,9 +891,19 @@ void MainWindow::onEditOptionsClicked()
     }
 
     dimUnusedControls();
+    setDisplayRate(m_options->getDisplayRateHz());
+    invalidateDisplay();
+
+    if (m_dashboardDialog != 0)
+    {
+      m_dashboardDialog->setFrameRate(m_options->getDisplayRateHz());
+      updateDashboard();
+    }
 
     m_cux->setEnabledSamples(m_enabledSamples);
     m_cux->setReadIntervals(m_options->getReadIntervals());
+    m_cux->setReadIntervalBounds(m_options->getReadIntervalBounds());
+    m_cux->setAdaptiveReadIntervals(m_options->getAdaptiveReadIntervals());
 
     // If the user changed the serial device name and/or the polling
     // interval, stop the timer, re-connect to the 14CUX (if neccessary),
@@ -874,7 +912,7 @@ void MainWindow::onEditOptionsClicked()
     {
       if (m_cux->isConnected())
       {
-        m_cux->disconnectFromECU();
+        emit requestDisconnect();
       }
 
       m_cux->setSerialDevice(m_options->getSerialDeviceName());
@@ -951,7 +989,7 @@ void MainWindow::dimUnusedControls()
   m_ui->m_targetIdle->setEnabled(enabled);
   m_idleModeLedOpacity->setEnabled(!enabled);
 
-  setLambdaWidgetsForFeedbackMode(m_cux->getFeedbackMode(),
+  setLambdaWidgetsForFeedbackMode(m_sample.feedbackMode,
                                   m_enabledSamples[SampleType_COTrimVoltage],
                                   m_enabledSamples[SampleType_LambdaTrimShort] || m_enabledSamples[SampleType_LambdaTrimLong]);
 
@@ -1011,6 +1049,9 @@ void MainWindow::closeEvent(QCloseEvent* event)
     m_cuxThread->wait(2000);
   }
 
+  // let the last segment of a segmented log finish compressing
+  m_logger->waitForSegments();
+
   event->accept();
 }
 
@@ -1020,6 +1061,12 @@ void MainWindow::closeEvent(QCloseEvent* event)
  */
 void MainWindow::onConnect()
 {
+  // live data takes over the gauges from any log that was being played back
+  if ((m_logPlaybackDialog != 0) && m_logPlaybackDialog->isVisible())
+  {
+    m_logPlaybackDialog->close();
+  }
+
   m_ui->m_connectButton->setEnabled(false);
   m_ui->m_disconnectButton->setEnabled(true);
   m_ui->m_commsGoodLed->setChecked(false);
@@ -1069,7 +1116,7 @@ void MainWindow::onDisconnect()
   m_ui->m_fuelPumpRelayStateLed->setChecked(false);
   m_ui->m_oddFuelTrimBar->setValue(0);
 
-  if (m_cux->getFeedbackMode() == C14CUX_FeedbackMode_ClosedLoop)
+  if (m_sample.feedbackMode == C14CUX_FeedbackMode_ClosedLoop)
   {
     m_ui->m_oddFuelTrimBarAndMAFCOLabel->setText("+0%");
   }
@@ -1087,6 +1134,8 @@ void MainWindow::onDisconnect()
   m_ui->m_evenFuelTrimBar->repaint();
 
   removeFuelMapCellHighlight();
+  invalidateDisplay();
+  updateDashboard();
 
   m_fuelMapDataIsCurrent = false;
   m_cux->invalidateFuelMapData();
@@ -1152,6 +1201,13 @@ void MainWindow::onStopLogging()
   m_ui->m_logFileNameBox->setEnabled(true);
   m_ui->m_stopLoggingButton->setEnabled(false);
   m_ui->m_startLoggingButton->setEnabled(true);
+
+  if (m_logger->getDroppedRecords() > 0)
+  {
+    QMessageBox::warning(this, "Warning",
+                         QString("%1 samples were not logged because the log file could not be written quickly enough.")
+                         .arg(m_logger->getDroppedRecords()), QMessageBox::Ok);
+  }
 }
 
 /**
@@ -1224,7 +1280,206 @@ void MainWindow::onNotConnected()
 void MainWindow::onSaveROMImageSelected()
 {
   sendROMImageRequest(
-    QString("Read the ROM image from the ECU? This will take approximately 25 seconds."));
+    QString("Read the ROM image from the ECU? This will take approximately 25 seconds, "
+            "during which the live readings will update more slowly."));
+}
+
+/**
+ * Prompts for a directory of saved ROM images, decodes the tables in each
+ * of them, and saves a CSV report that compares them.
+ */
+void MainWindow::onAnalyzeROMImagesSelected()
+{
+  const QString dirName = QFileDialog::getExistingDirectory(this, "Select directory of ROM images:");
+
+  if (!dirName.isEmpty())
+  {
+    RomAnalyzer analyzer;
+
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    analyzer.learnLayoutsFromCache();
+    analyzer.loadLayouts(RomAnalyzer::defaultLayoutFileName());
+    const int decoded = analyzer.analyzeDirectory(dirName);
+    QApplication::restoreOverrideCursor();
+
+    if (analyzer.count() == 0)
+    {
+      QMessageBox::warning(this, "Error", QString("No 16KB ROM images were found in:\n%1").arg(dirName),
+                           QMessageBox::Ok);
+    }
+    else
+    {
+      if (decoded < analyzer.count())
+      {
+        QMessageBox::information(this, "ROM analysis",
+                                 QString("The tables could be found in %1 of %2 images.\n\n"
+                                         "Table locations are learned from ROM images read from a connected ECU, "
+                                         "and can also be described in:\n%3")
+                                 .arg(decoded).arg(analyzer.count()).arg(RomAnalyzer::defaultLayoutFileName()),
+                                 QMessageBox::Ok);
+      }
+
+      const QString fileName =
+        QFileDialog::getSaveFileName(this, "Select output file for ROM report:", QDir(dirName).filePath("romreport.csv"));
+
+      if (!fileName.isEmpty())
+      {
+        QFile outFile(fileName);
+
+        if (outFile.open(QIODevice::WriteOnly | QIODevice::Text))
+        {
+          QTextStream out(&outFile);
+          out << analyzer.formatReport();
+          outFile.close();
+        }
+        else
+        {
+          QMessageBox::warning(this, "Error", "Error writing ROM report file:\n" + outFile.errorString(),
+                               QMessageBox::Ok);
+        }
+      }
+    }
+  }
+}
+
+/**
+ * Returns the library of known ROM images, loading it on first use.
+ */
+RomLibrary* MainWindow::romLibrary()
+{
+  if (m_romLibrary == 0)
+  {
+    m_romLibrary = new RomLibrary();
+    m_romLibrary->load();
+  }
+
+  return m_romLibrary;
+}
+
+/**
+ * Reports the known ROM that is closest to an image, and which of its tables
+ * differ.
+ * @param fp Fingerprint of the image
+ * @param reportNoMatch True to say so when no similar ROM is known; false to
+ *  show nothing in that case
+ */
+void MainWindow::showClosestROM(const RomFingerprint& fp, bool reportNoMatch)
+{
+  const RomLibrary::Match match = romLibrary()->closest(fp);
+
+  if (match.index >= 0)
+  {
+    const RomFingerprint& known = romLibrary()->at(match.index);
+    const QStringList diffs = RomLibrary::differences(fp, known);
+    QString text = QString("Closest known ROM:\n%1\n\n%2 of %3 blocks are identical.")
+                   .arg(QDir::toNativeSeparators(known.fileName))
+                   .arg(match.matchingBlocks).arg(RomFingerprint::s_numBlocks);
+
+    if (diffs.isEmpty())
+    {
+      text += "\n\nThe images are identical.";
+    }
+    else
+    {
+      text += "\n\nDifferences:\n" + diffs.join("\n");
+    }
+
+    QMessageBox::information(this, "Closest known ROM", text, QMessageBox::Ok);
+  }
+  else if (reportNoMatch)
+  {
+    QMessageBox::information(this, "Closest known ROM", "No similar ROM image is in the library.", QMessageBox::Ok);
+  }
+}
+
+/**
+ * Prompts for a directory of saved ROM images and adds them to the library.
+ */
+void MainWindow::onAddROMsToLibrarySelected()
+{
+  const QString dirName = QFileDialog::getExistingDirectory(this, "Select directory of ROM images:");
+
+  if (!dirName.isEmpty())
+  {
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    const int added = romLibrary()->addDirectory(dirName);
+    const bool saved = romLibrary()->save();
+    QApplication::restoreOverrideCursor();
+
+    if (saved)
+    {
+      QMessageBox::information(this, "ROM library",
+                               QString("Added %1 images. The library holds %2 images.")
+                               .arg(added).arg(romLibrary()->count()), QMessageBox::Ok);
+    }
+    else
+    {
+      QMessageBox::warning(this, "Error",
+                           QString("Error writing the ROM library:\n%1").arg(RomLibrary::libraryFileName()),
+                           QMessageBox::Ok);
+    }
+  }
+}
+
+/**
+ * Prompts for a saved ROM image and reports the closest one in the library.
+ */
+void MainWindow::onFindClosestROMSelected()
+{
+  const QString fileName = QFileDialog::getOpenFileName(this, "Select ROM image:");
+
+  if (!fileName.isEmpty())
+  {
+    QFile file(fileName);
+
+    if (file.open(QFile::ReadOnly))
+    {
+      const RomFingerprint fp = romLibrary()->fingerprint(file.readAll(), QFileInfo(fileName).absoluteFilePath());
+
+      if (fp.hash.isEmpty())
+      {
+        QMessageBox::warning(this, "Error", "The file is not a 16KB ROM image.", QMessageBox::Ok);
+      }
+      else
+      {
+        showClosestROM(fp, true);
+      }
+    }
+    else
+    {
+      QMessageBox::warning(this, "Error", "Error reading the ROM image file:\n" + file.errorString(),
+                           QMessageBox::Ok);
+    }
+  }
+}
+
+/**
+ * Prompts for a binary log and the name of a CSV file, and converts the log
+ * to the same layout that the text logger writes.
+ */
+void MainWindow::onConvertBinaryLogSelected()
+{
+  const QString binaryFileName =
+    QFileDialog::getOpenFileName(this, "Select binary log to convert:", "logs", "Binary logs (*.rgl)");
+
+  if (!binaryFileName.isEmpty())
+  {
+    QString csvFileName = binaryFileName;
+    csvFileName.replace(QRegExp("\\.rgl$"), ".txt");
+
+    csvFileName = QFileDialog::getSaveFileName(this, "Select output file for CSV log:", csvFileName);
+
+    if (!csvFileName.isEmpty())
+    {
+      QString error;
+
+      if (!BinaryLogReader::convertToCsv(binaryFileName, csvFileName, error))
+      {
+        QMessageBox::warning(this, "Error",
+                             QString("Error converting the binary log:\n%1").arg(error), QMessageBox::Ok);
+      }
+    }
+  }
 }
 
 /**
@@ -1269,6 +1524,19 @@ void MainWindow::onROMReadCancelled()
   m_cux->cancelRead();
 }
 
+/**
+ * Shows how much of the ROM image has been read.
+ */
+void MainWindow::onROMImageProgress(int bytesRead, int totalBytes)
+{
+  if ((m_pleaseWaitBox != 0) && (totalBytes > 0))
+  {
+    m_pleaseWaitBox->setText(QString("Please wait while the ROM image is read.\n\n"
+                                     "%1 of %2 bytes read (%3%)")
+                             .arg(bytesRead).arg(totalBytes).arg((bytesRead * 100) / totalBytes));
+  }
+}
+
 /**
  * Prompts the user for a file in which to save the ROM image.
  */
@@ -1297,6 +1565,15 @@ void MainWindow::onROMImageReady()
           QMessageBox::warning(this, "Error",
                                QString("Error writing the ROM image file:\n%1").arg(saveFileName), QMessageBox::Ok);
         }
+        else
+        {
+          // compare the new image with the known ROMs before adding it to them
+          const RomFingerprint fp = romLibrary()->fingerprint(*promData, QFileInfo(saveFileName).absoluteFilePath());
+
+          showClosestROM(fp, false);
+          romLibrary()->add(fp);
+          romLibrary()->save();
+        }
 
         saveFile.close();
       }
@@ -1424,12 +1701,7 @@ void MainWindow::onRPMLimitReady(int rpmLimit)
  */
 void MainWindow::onRPMTableReady()
 {
-  c14cux_rpmtable table = m_cux->getRPMTable();
-
-  for (int col = 0; col < FUEL_MAP_COLUMNS; col++)
-  {
-    m_ui->m_fuelMapDisplay->horizontalHeaderItem(col)->setText(QString::number(table.rpm[col]));
-  }
+  m_fuelMapModel->setRPMTable(m_cux->getRPMTable());
 }
 
 /**
@@ -1446,7 +1718,7 @@ void MainWindow::setLambdaWidgetsForFeedbackMode(c14cux_feedback_mode mode, bool
 
     m_ui->m_oddFuelTrimAndMAFCOLabel->setText("MAF CO trim:");
     m_ui->m_oddFuelTrimAndMAFCOLabel->setEnabled(coTrimEnabled);
-    m_ui->m_oddFuelTrimBarAndMAFCOLabel->setText(QString::number(m_cux->getCOTrimVoltage(), 'f', 2) + "V");
+    m_ui->m_oddFuelTrimBarAndMAFCOLabel->setText(QString::number(m_sample.coTrimVoltage, 'f', 2) + "V");
     m_ui->m_oddFuelTrimBarAndMAFCOLabel->setAlignment(Qt::AlignLeft);
     m_ui->m_oddFuelTrimBarAndMAFCOLabel->setEnabled(coTrimEnabled);
 
@@ -1473,7 +1745,7 @@ void MainWindow::setLambdaWidgetsForFeedbackMode(c14cux_feedback_mode mode, bool
     m_ui->m_oddFuelTrimAndMAFCOLabel->setEnabled(lambdaEnabled);
     m_ui->m_oddFuelTrimBarAndMAFCOLabel->setEnabled(lambdaEnabled);
     m_ui->m_oddFuelTrimBarAndMAFCOLabel->setAlignment(Qt::AlignRight);
-    setLambdaTrimIndicators(m_cux->getLambdaTrimOdd(), m_cux->getLambdaTrimEven());
+    setLambdaTrimIndicators(m_sample.lambdaTrimOdd, m_sample.lambdaTrimEven);
 
     m_ui->m_lambdaTrimHighLimitLabel->setVisible(true);
     m_ui->m_lambdaTrimLowLimitLabel->setVisible(true);
@@ -1490,6 +1762,8 @@ void MainWindow::setLambdaWidgetsForFeedbackMode(c14cux_feedback_mode mode, bool
  */
 void MainWindow::onFeedbackModeChanged(c14cux_feedback_mode mode)
 {
+  // the trim widgets are relabeled here, so they must all be redrawn
+  m_displayedSampleValid = false;
   setLambdaWidgetsForFeedbackMode(mode,
                                   m_enabledSamples[SampleType_COTrimVoltage],
                                   m_enabledSamples[SampleType_LambdaTrimLong] || m_enabledSamples[SampleType_LambdaTrimShort]);
@@ -1514,6 +1788,10 @@ void MainWindow::onFuelMapIndexChanged(unsigned int fuelMapId)
                            m_cux->getFuelMapAdjustmentFactor(fuelMapId),
                            m_cux->getRowScaler(fuelMapId));
     m_fuelMapDataIsCurrent = true;
+
+    // the new map has to be highlighted at the engine's current position even
+    // if that position hasn't changed since the last sample was displayed
+    m_displayedFuelMapPosition = false;
   }
   else
   {
@@ -1523,6 +1801,11 @@ void MainWindow::onFuelMapIndexChanged(unsigned int fuelMapId)
     m_fuelMapDataIsCurrent = false;
     emit requestFuelMapData(fuelMapId);
   }
+
+  if (m_fuelMapResidencyDialog != 0)
+  {
+    m_fuelMapResidencyDialog->setFuelMapId(fuelMapId);
+  }
 }
 
 #ifdef ENABLE_FORCE_OPEN_LOOP
@@ -1536,6 +1819,222 @@ void MainWindow::onForceOpenLoopStateReceived(bool forceOpen)
 }
 #endif
 
+/**
+ * Opens the serial link statistics dialog.
+ */
+void MainWindow::onLinkMetricsClicked()
+{
+  if (m_linkMetricsDialog == 0)
+  {
+    m_linkMetricsDialog = new LinkMetricsDialog(QString(this->windowTitle() + " - Serial Link Statistics"),
+                                                m_cux->getLinkMetrics(), this);
+  }
+
+  m_linkMetricsDialog->show();
+}
+
+/**
+ * Prompts for a log file and opens it for playback through the gauges.
+ */
+void MainWindow::onPlayBackLogSelected()
+{
+  if (m_cux->isConnected())
+  {
+    QMessageBox::information(this, "Play back log",
+                             "Disconnect from the ECU before playing back a log.", QMessageBox::Ok);
+    return;
+  }
+
+  const QString fileName =
+    QFileDialog::getOpenFileName(this, "Select log to play back:", "logs", "Logs (*.txt *.rgl)");
+
+  if (!fileName.isEmpty())
+  {
+    if (m_logPlayer == 0)
+    {
+      m_logPlayer = new LogPlayer(this);
+      connect(m_logPlayer, SIGNAL(sampleReady()), this, SLOT(onPlaybackSampleReady()));
+
+      m_logPlaybackDialog = new LogPlaybackDialog(QString(this->windowTitle() + " - Log Playback"),
+                                                  m_logPlayer, this);
+      connect(m_logPlaybackDialog, SIGNAL(finished(int)), this, SLOT(onPlaybackDialogClosed()));
+    }
+
+    m_logPlayer->setCsvUnits(m_options->getSpeedUnits(), m_options->getTemperatureUnits());
+
+    if (m_logPlayer->open(fileName))
+    {
+      m_logPlaybackDialog->logOpened(fileName);
+      m_logPlaybackDialog->show();
+    }
+    else
+    {
+      QMessageBox::warning(this, "Error", "Unable to play back the log:\n" + m_logPlayer->errorString(),
+                           QMessageBox::Ok);
+    }
+  }
+}
+
+/**
+ * Shows the record that the log player has just reached.
+ */
+void MainWindow::onPlaybackSampleReady()
+{
+  if (!m_cux->isConnected())
+  {
+    m_sample = m_logPlayer->currentSample();
+    requestDisplayUpdate(true);
+  }
+}
+
+/**
+ * Closes the log when playback is finished with, and returns the gauges to
+ * rest.
+ */
+void MainWindow::onPlaybackDialogClosed()
+{
+  m_logPlayer->close();
+
+  if (!m_cux->isConnected())
+  {
+    onDisconnect();
+  }
+}
+
+/**
+ * Opens the fuel map residency dialog, showing the map currently in use.
+ */
+void MainWindow::onFuelMapResidencyClicked()
+{
+  if (m_fuelMapResidencyDialog == 0)
+  {
+    m_fuelMapResidencyDialog = new FuelMapResidencyDialog(QString(this->windowTitle() + " - Fuel Map Residency"),
+                                                          m_cux->getFuelMapResidency(), this);
+  }
+
+  m_fuelMapResidencyDialog->setFuelMapId(m_sample.currentFuelMapIndex);
+  m_fuelMapResidencyDialog->show();
+}
+
+/**
+ * Opens the dashboard, which shows the main instruments in a separate window.
+ */
+void MainWindow::onDashboardClicked()
+{
+  if (m_dashboardDialog == 0)
+  {
+    m_dashboardDialog = new DashboardDialog(QString(this->windowTitle() + " - Dashboard"), this);
+    m_dashboardDialog->setFrameRate(m_options->getDisplayRateHz());
+    connect(m_dashboardDialog, SIGNAL(hideMainGauges(bool)), this, SLOT(onDashboardHideMainGauges(bool)));
+  }
+
+  updateDashboard();
+  m_dashboardDialog->show();
+}
+
+/**
+ * Hides the gauges in the main window while the dashboard is showing them,
+ * so that they aren't being redrawn in two places; shows them again when the
+ * dashboard is closed.
+ */
+void MainWindow::onDashboardHideMainGauges(bool hide)
+{
+  m_ui->m_waterTempGauge->setVisible(!hide);
+  m_ui->m_speedo->setVisible(!hide);
+  m_ui->m_revCounter->setVisible(!hide);
+  m_ui->m_fuelTempGauge->setVisible(!hide);
+  m_ui->m_waterTempLabel->setVisible(!hide);
+  m_ui->m_speedoLabel->setVisible(!hide);
+  m_ui->m_revCounterLabel->setVisible(!hide);
+  m_ui->m_fuelTempLabel->setVisible(!hide);
+}
+
+/**
+ * Copies the scales and readings of the main instruments to the dashboard,
+ * if it has been opened. The instruments already hold the readings converted
+ * to the selected units (and with any road speed adjustment applied.)
+ */
+void MainWindow::updateDashboard()
+{
+  if (m_dashboardDialog == 0)
+  {
+    return;
+  }
+
+  const ManoMeter* gauges[DashboardScene::Gauge_NumGauges];
+  QString labels[DashboardScene::Gauge_NumGauges];
+
+  gauges[DashboardScene::Gauge_RoadSpeed] = m_ui->m_speedo;
+  gauges[DashboardScene::Gauge_EngineSpeed] = m_ui->m_revCounter;
+  gauges[DashboardScene::Gauge_WaterTemp] = m_ui->m_waterTempGauge;
+  gauges[DashboardScene::Gauge_FuelTemp] = m_ui->m_fuelTempGauge;
+
+  labels[DashboardScene::Gauge_RoadSpeed] = "Road speed";
+  labels[DashboardScene::Gauge_EngineSpeed] = "Engine speed";
+  labels[DashboardScene::Gauge_WaterTemp] = "Engine temp";
+  labels[DashboardScene::Gauge_FuelTemp] = "Fuel temp";
+
+  for (int idx = 0; idx < DashboardScene::Gauge_NumGauges; idx++)
+  {
+    const DashboardScene::Gauge gauge = (DashboardScene::Gauge)idx;
+
+    m_dashboardDialog->setGauge(gauge, labels[idx], gauges[idx]->suffix(),
+                                gauges[idx]->minimum(), gauges[idx]->maximum(), gauges[idx]->critical());
+    m_dashboardDialog->setValue(gauge, gauges[idx]->value());
+  }
+
+  const QProgressBar* bars[DashboardScene::Bar_NumBars];
+  QString barLabels[DashboardScene::Bar_NumBars];
+  QString barText[DashboardScene::Bar_NumBars];
+
+  bars[DashboardScene::Bar_Throttle] = m_ui->m_throttleBar;
+  bars[DashboardScene::Bar_MAF] = m_ui->m_mafReadingBar;
+  bars[DashboardScene::Bar_IdleBypass] = m_ui->m_idleBypassPosBar;
+  bars[DashboardScene::Bar_InjectorDutyCycle] = m_ui->m_injectorDutyCycleBar;
+  bars[DashboardScene::Bar_LambdaTrimOdd] = m_ui->m_oddFuelTrimBar;
+  bars[DashboardScene::Bar_LambdaTrimEven] = m_ui->m_evenFuelTrimBar;
+
+  barLabels[DashboardScene::Bar_Throttle] = "Throttle";
+  barLabels[DashboardScene::Bar_MAF] = "MAF";
+  barLabels[DashboardScene::Bar_IdleBypass] = "Idle bypass";
+  barLabels[DashboardScene::Bar_InjectorDutyCycle] = "Injector duty";
+  barLabels[DashboardScene::Bar_LambdaTrimOdd] = "Lambda trim (odd)";
+  barLabels[DashboardScene::Bar_LambdaTrimEven] = "Lambda trim (even)";
+
+  for (int idx = 0; idx < DashboardScene::Bar_LambdaTrimOdd; idx++)
+  {
+    barText[idx] = bars[idx]->text();
+  }
+  barText[DashboardScene::Bar_LambdaTrimOdd] = m_ui->m_oddFuelTrimBarAndMAFCOLabel->text();
+  barText[DashboardScene::Bar_LambdaTrimEven] = m_ui->m_evenFuelTrimBarLabel->text();
+
+  for (int idx = 0; idx < DashboardScene::Bar_NumBars; idx++)
+  {
+    m_dashboardDialog->setBar((DashboardScene::Bar)idx, barLabels[idx], bars[idx]->minimum(), bars[idx]->maximum(),
+                              bars[idx]->value(), barText[idx]);
+  }
+
+  // in open loop, the odd bank's cell shows the MAF CO trim voltage instead
+  if (m_sample.feedbackMode == C14CUX_FeedbackMode_OpenLoop)
+  {
+    m_dashboardDialog->setBar(DashboardScene::Bar_LambdaTrimOdd, "MAF CO trim", 0, 0, 0,
+                              barText[DashboardScene::Bar_LambdaTrimOdd]);
+  }
+
+  m_dashboardDialog->setLamp(DashboardScene::Lamp_MIL, "MIL", m_ui->m_milLed->getOnColor1(),
+                             m_ui->m_milLed->getOffColor1(), m_ui->m_milLed->isChecked());
+  m_dashboardDialog->setLamp(DashboardScene::Lamp_IdleMode, "Idle mode", m_ui->m_idleModeLed->getOnColor1(),
+                             m_ui->m_idleModeLed->getOffColor1(), m_ui->m_idleModeLed->isChecked());
+  m_dashboardDialog->setLamp(DashboardScene::Lamp_FuelPumpRelay, "Fuel pump relay",
+                             m_ui->m_fuelPumpRelayStateLed->getOnColor1(),
+                             m_ui->m_fuelPumpRelayStateLed->getOffColor1(),
+                             m_ui->m_fuelPumpRelayStateLed->isChecked());
+
+  m_dashboardDialog->setReadout(DashboardScene::Readout_TargetIdle, "Target idle", m_ui->m_targetIdle->text());
+  m_dashboardDialog->setReadout(DashboardScene::Readout_Gear, "Gear", m_ui->m_gear->text());
+  m_dashboardDialog->setReadout(DashboardScene::Readout_MainVoltage, "Main voltage", m_ui->m_voltage->text());
+}
+
 #ifdef ENABLE_SIM_MODE
 void MainWindow::onSimDialogClicked()
 {
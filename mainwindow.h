@@ -13,7 +13,7 @@
 #include <QTextStream>
 #include <QThread>
 #include <QFrame>
-#include <QTableWidget>
+#include <QTableView>
 #include <QHash>
 #include <QMap>
 #include <QPair>
@@ -31,12 +31,17 @@
 #include "commonunits.h"
 #include "helpviewer.h"
 #include "batterybackeddisplay.h"
+#include "linkmetricsdialog.h"
+#include "fuelmapresidencydialog.h"
+#include "logplayer.h"
+#include "logplaybackdialog.h"
+#include "romlibrary.h"
+#include "fuelmapmodel.h"
+#include "dashboarddialog.h"
 #ifdef ENABLE_SIM_MODE
 #include "simulationmodedialog.h"
 #endif
 
-#define NUM_ACTIVE_FUEL_MAP_CELLS 4
-
 namespace Ui
 {
 class MainWindow;
@@ -47,7 +52,7 @@ class MainWindow : public QMainWindow
   Q_OBJECT
 
 public:
-  MainWindow (bool autoconnect, bool autolog, bool doublebaud, QWidget* parent = 0);
+  MainWindow (EcuTransport* transport, bool autoconnect, bool autolog, bool doublebaud, QWidget* parent = 0);
   ~MainWindow();
 
 public slots:
@@ -65,6 +70,7 @@ public slots:
   void onTuneRevisionReady(int tuneRevisionNum, int checksumFixer, int ident);
   void onRPMLimitReady(int rpmLimit);
   void onRPMTableReady();
+  void onROMImageProgress(int bytesRead, int totalBytes);
   void onROMImageReady();
   void onROMImageReadFailed();
   void onInterfaceReady();
@@ -77,6 +83,7 @@ public slots:
 
 signals:
   void requestToStartPolling();
+  void requestDisconnect();
   void requestFuelMapData(unsigned int fuelMapId);
   void requestROMImage();
   void requestThreadShutdown();
@@ -102,6 +109,12 @@ private:
   AboutBox* m_aboutBox;
   QMessageBox* m_pleaseWaitBox;
   HelpViewer* m_helpViewerDialog;
+  LinkMetricsDialog* m_linkMetricsDialog;
+  FuelMapResidencyDialog* m_fuelMapResidencyDialog;
+  DashboardDialog* m_dashboardDialog;
+  LogPlayer* m_logPlayer;
+  LogPlaybackDialog* m_logPlaybackDialog;
+  RomLibrary* m_romLibrary;
   bool m_doubleBaudRate;
 
   QShortcut* m_shortcutStartLogging;
@@ -118,13 +131,22 @@ private:
   QGraphicsOpacityEffect* m_fuelPumpLedOpacity;
 
   QMap<SampleType, bool> m_enabledSamples;
+  EcuSample m_sample;
+  quint64 m_lastSampleSequence;
 
   static const float s_speedometerMaxMPH;
   static const float s_speedometerMaxKPH;
 
-  QTableWidgetItem* m_lastHighlightedFuelMapCell[NUM_ACTIVE_FUEL_MAP_CELLS];
+  FuelMapModel* m_fuelMapModel;
   bool m_fuelMapDataIsCurrent;
 
+  QTimer* m_displayTimer;
+  bool m_displayPending;
+  bool m_displayFuelMapPosition;
+  EcuSample m_displayedSample;
+  bool m_displayedSampleValid;
+  bool m_displayedFuelMapPosition;
+
   QHash<SpeedUnits, QString>* m_speedUnitSuffix;
   QHash<TemperatureUnits, QString>* m_tempUnitSuffix;
   QHash<TemperatureUnits, QPair<int, int> >* m_tempRange;
@@ -136,19 +158,33 @@ private:
   void startLogging();
   void buildSpeedAndTempUnitTables();
   void setupWidgets();
+  void requestDisplayUpdate(bool showFuelMapPosition);
+  void invalidateDisplay();
+  void setDisplayRate(unsigned int rateHz);
+  void displaySample(bool showFuelMapPosition);
   void populateFuelMapDisplay(const QByteArray *data, unsigned int fuelMapMultiplier, unsigned int rowScaler);
-  QColor getColorForFuelMapCell(unsigned char value);
   void highlightActiveFuelMapCells();
   void removeFuelMapCellHighlight();
   void sendROMImageRequest(QString prompt);
+  RomLibrary* romLibrary();
+  void showClosestROM(const RomFingerprint& fp, bool reportNoMatch);
   void dimUnusedControls();
   void setGearLabel(c14cux_gear gearReading);
   void setLambdaTrimIndicators(int lambdaTrimOdd, int lambdaTrimEven);
   void setLambdaWidgetsForFeedbackMode(c14cux_feedback_mode mode, bool coTrimEnabled, bool lambdaEnabled);
   void setSpeedoLabel();
+  void updateDashboard();
 
 private slots:
   void onSaveROMImageSelected();
+  void onAnalyzeROMImagesSelected();
+  void onAddROMsToLibrarySelected();
+  void onFindClosestROMSelected();
+  void onConvertBinaryLogSelected();
+  void onPlayBackLogSelected();
+  void onPlaybackSampleReady();
+  void onDisplayTimerExpired();
+  void onPlaybackDialogClosed();
   void onROMReadCancelled();
   void onExitSelected();
   void onEditOptionsClicked();
@@ -160,6 +196,10 @@ private slots:
   void onStopLogging();
   void onFuelPumpContinuous();
   void onIdleAirControlClicked();
+  void onLinkMetricsClicked();
+  void onFuelMapResidencyClicked();
+  void onDashboardClicked();
+  void onDashboardHideMainGauges(bool hide);
   void onLambdaTrimButtonClicked(QAbstractButton* button);
   void onMAFReadingButtonClicked(QAbstractButton* button);
   void onThrottleTypeButtonClicked(QAbstractButton* button);
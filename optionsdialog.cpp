@@ -13,11 +13,19 @@ OptionsDialog::OptionsDialog(QString title, QWidget* parent) : QDialog(parent),
   m_settingSerialDev("SerialDevice"),
   m_settingRefreshFuelMap("RefreshFuelMap"),
   m_settingSoftHighlight("SoftHighlight"),
+  m_settingDisplayRate("DisplayRateHz"),
   m_settingSpeedUnits("SpeedUnits"),
   m_settingTemperatureUnits("TemperatureUnits"),
   m_settingSpeedoAdjust("SpeedometerAdjustment"),
   m_settingSpeedoMultiplier("SpeedometerMultiplier"),
   m_settingSpeedoOffset("SpeedometerOffset"),
+  m_settingAdaptiveReadIntervals("AdaptiveReadIntervals"),
+  m_settingLogFormat("LogFormat"),
+  m_settingLogRotateSizeMB("LogRotateSizeMB"),
+  m_settingLogRotateMinutes("LogRotateMinutes"),
+  m_settingCompressLogs("CompressLogs"),
+  m_settingMinIntervalPrefix("MinReadInterval_"),
+  m_settingMaxIntervalPrefix("MaxReadInterval_"),
   m_ui(new Ui::OptionsDialog)
 {
   m_ui->setupUi(this);
@@ -77,6 +85,16 @@ OptionsDialog::OptionsDialog(QString title, QWidget* parent) : QDialog(parent),
   m_readIntervalsMs[SampleType_InjectorPulseWidth] = 0;
   m_readIntervalsMs[SampleType_MIL]                = 347;
 
+  // When adaptive read intervals are enabled, each interval may be tuned
+  // between a quarter and four times its fixed value. These bounds can be
+  // overridden per sample in the settings file.
+  foreach(SampleType sType, m_readIntervalsMs.keys())
+  {
+    const unsigned int interval = m_readIntervalsMs[sType];
+    m_readIntervalBoundsMs[sType] =
+      qMakePair(interval / 4, (interval > 0) ? (interval * 4) : s_maxAdaptiveIntervalForFastSamplesMs);
+  }
+
   this->setWindowTitle(title);
   readSettings();
   setupWidgets();
@@ -107,6 +125,10 @@ void OptionsDialog::setupWidgets()
   m_ui->m_temperatureUnitsBox->addItem("Fahrenheit");
   m_ui->m_temperatureUnitsBox->addItem("Celsius");
 
+  m_ui->m_logFormatBox->addItem("Text (CSV)");
+  m_ui->m_logFormatBox->addItem("Binary");
+  m_ui->m_logFormatBox->addItem("Binary (changes only)");
+
   setWidgetValues();
 
   foreach(QCheckBox * sampleCheckBox, m_enabledSamplesBoxes)
@@ -136,9 +158,15 @@ void OptionsDialog::setWidgetValues()
   m_ui->m_serialDeviceBox->setCurrentText(m_serialDeviceName);
   m_ui->m_speedUnitsBox->setCurrentIndex((int)m_speedUnits);
   m_ui->m_temperatureUnitsBox->setCurrentIndex((int)m_tempUnits);
+  m_ui->m_logFormatBox->setCurrentIndex((int)m_logFormat);
+  m_ui->m_logRotateSizeSpinbox->setValue(m_logRotateSizeMB);
+  m_ui->m_logRotateTimeSpinbox->setValue(m_logRotateMinutes);
+  m_ui->m_compressLogsCheckbox->setChecked(m_compressLogs);
 
   m_ui->m_refreshFuelMapCheckbox->setChecked(m_refreshFuelMap);
   m_ui->m_softHighlightCheckbox->setChecked(m_softHighlight);
+  m_ui->m_displayRateSpinbox->setValue(m_displayRateHz);
+  m_ui->m_adaptiveIntervalsCheckbox->setChecked(m_adaptiveReadIntervals);
 
   m_ui->m_adjustSpeedoCheckbox->setChecked(m_speedoAdjust);
   m_ui->m_speedoMultiplierSpinbox->setValue(m_speedoMultiplier);
@@ -196,8 +224,14 @@ void OptionsDialog::accept()
 
   m_tempUnits        = (TemperatureUnits)(m_ui->m_temperatureUnitsBox->currentIndex());
   m_speedUnits       = (SpeedUnits)(m_ui->m_speedUnitsBox->currentIndex());
+  m_logFormat        = (LogFormat)(m_ui->m_logFormatBox->currentIndex());
+  m_logRotateSizeMB  = m_ui->m_logRotateSizeSpinbox->value();
+  m_logRotateMinutes = m_ui->m_logRotateTimeSpinbox->value();
+  m_compressLogs     = m_ui->m_compressLogsCheckbox->isChecked();
   m_refreshFuelMap   = m_ui->m_refreshFuelMapCheckbox->isChecked();
   m_softHighlight    = m_ui->m_softHighlightCheckbox->isChecked();
+  m_displayRateHz    = m_ui->m_displayRateSpinbox->value();
+  m_adaptiveReadIntervals = m_ui->m_adaptiveIntervalsCheckbox->isChecked();
   m_speedoAdjust     = m_ui->m_adjustSpeedoCheckbox->isChecked();
   m_speedoMultiplier = m_ui->m_speedoMultiplierSpinbox->value();
   m_speedoOffset     = m_ui->m_speedoOffsetSpinbox->value();
@@ -239,13 +273,23 @@ void OptionsDialog::readSettings()
   m_tempUnits = (TemperatureUnits)(settings.value(m_settingTemperatureUnits, Fahrenheit).toInt());
   m_refreshFuelMap = settings.value(m_settingRefreshFuelMap, false).toBool();
   m_softHighlight = settings.value(m_settingSoftHighlight, false).toBool();
+  m_displayRateHz = settings.value(m_settingDisplayRate, 30).toUInt();
   m_speedoAdjust = settings.value(m_settingSpeedoAdjust, false).toBool();
   m_speedoMultiplier = settings.value(m_settingSpeedoMultiplier, 1.0).toDouble();
   m_speedoOffset = settings.value(m_settingSpeedoOffset, 0).toInt();
+  m_adaptiveReadIntervals = settings.value(m_settingAdaptiveReadIntervals, false).toBool();
+  m_logFormat = (LogFormat)(settings.value(m_settingLogFormat, LogFormat_CSV).toInt());
+  m_logRotateSizeMB = settings.value(m_settingLogRotateSizeMB, 0).toUInt();
+  m_logRotateMinutes = settings.value(m_settingLogRotateMinutes, 0).toUInt();
+  m_compressLogs = settings.value(m_settingCompressLogs, false).toBool();
 
   foreach(SampleType sType, m_sampleTypeNames.keys())
   {
     m_enabledSamples[sType] = settings.value(m_sampleTypeNames[sType], true).toBool();
+
+    QPair<unsigned int, unsigned int>& bounds = m_readIntervalBoundsMs[sType];
+    bounds.first = settings.value(m_settingMinIntervalPrefix + m_sampleTypeNames[sType], bounds.first).toUInt();
+    bounds.second = settings.value(m_settingMaxIntervalPrefix + m_sampleTypeNames[sType], bounds.second).toUInt();
   }
 
   // special case for the MIL; this is always enabled
@@ -269,9 +313,15 @@ void OptionsDialog::writeSettings()
   settings.setValue(m_settingTemperatureUnits, m_tempUnits);
   settings.setValue(m_settingRefreshFuelMap, m_refreshFuelMap);
   settings.setValue(m_settingSoftHighlight, m_softHighlight);
+  settings.setValue(m_settingDisplayRate, m_displayRateHz);
   settings.setValue(m_settingSpeedoAdjust, m_speedoAdjust);
   settings.setValue(m_settingSpeedoMultiplier, m_speedoMultiplier);
   settings.setValue(m_settingSpeedoOffset, m_speedoOffset);
+  settings.setValue(m_settingAdaptiveReadIntervals, m_adaptiveReadIntervals);
+  settings.setValue(m_settingLogFormat, m_logFormat);
+  settings.setValue(m_settingLogRotateSizeMB, m_logRotateSizeMB);
+  settings.setValue(m_settingLogRotateMinutes, m_logRotateMinutes);
+  settings.setValue(m_settingCompressLogs, m_compressLogs);
 
   foreach(SampleType sType, m_sampleTypeNames.keys())
   {
@@ -5,6 +5,7 @@
 #include <QCheckBox>
 #include <QString>
 #include <QHash>
+#include <QPair>
 #include "commonunits.h"
 
 namespace Ui
@@ -36,6 +37,11 @@ public:
     return m_softHighlight;
   }
 
+  inline unsigned int getDisplayRateHz() const
+  {
+    return m_displayRateHz;
+  }
+
   inline SpeedUnits getSpeedUnits() const
   {
     return m_speedUnits;
@@ -56,6 +62,36 @@ public:
     return m_readIntervalsMs;
   }
 
+  inline bool getAdaptiveReadIntervals() const
+  {
+    return m_adaptiveReadIntervals;
+  }
+
+  inline QHash<SampleType, QPair<unsigned int, unsigned int> > getReadIntervalBounds() const
+  {
+    return m_readIntervalBoundsMs;
+  }
+
+  inline LogFormat getLogFormat() const
+  {
+    return m_logFormat;
+  }
+
+  inline unsigned int getLogRotateSizeMB() const
+  {
+    return m_logRotateSizeMB;
+  }
+
+  inline unsigned int getLogRotateMinutes() const
+  {
+    return m_logRotateMinutes;
+  }
+
+  inline bool getCompressLogs() const
+  {
+    return m_compressLogs;
+  }
+
   inline bool getSpeedoAdjust() const
   {
     return m_speedoAdjust;
@@ -88,14 +124,21 @@ private:
   QString m_serialDeviceName;
   TemperatureUnits m_tempUnits;
   SpeedUnits m_speedUnits;
+  LogFormat m_logFormat;
+  unsigned int m_logRotateSizeMB;
+  unsigned int m_logRotateMinutes;
+  bool m_compressLogs;
 
   QMap<SampleType, bool> m_enabledSamples;
   QMap<SampleType, QString> m_sampleTypeNames;
   QMap<SampleType, QString> m_sampleTypeLabels;
   QHash<SampleType, unsigned int> m_readIntervalsMs;
+  QHash<SampleType, QPair<unsigned int, unsigned int> > m_readIntervalBoundsMs;
+  bool m_adaptiveReadIntervals;
   bool m_serialDeviceChanged;
   bool m_refreshFuelMap;
   bool m_softHighlight;
+  unsigned int m_displayRateHz;
   bool m_speedoAdjust;
   double m_speedoMultiplier;
   int m_speedoOffset;
@@ -106,11 +149,23 @@ private:
   const QString m_settingSerialDev;
   const QString m_settingRefreshFuelMap;
   const QString m_settingSoftHighlight;
+  const QString m_settingDisplayRate;
   const QString m_settingSpeedUnits;
   const QString m_settingTemperatureUnits;
   const QString m_settingSpeedoAdjust;
   const QString m_settingSpeedoMultiplier;
   const QString m_settingSpeedoOffset;
+  const QString m_settingAdaptiveReadIntervals;
+  const QString m_settingLogFormat;
+  const QString m_settingLogRotateSizeMB;
+  const QString m_settingLogRotateMinutes;
+  const QString m_settingCompressLogs;
+  const QString m_settingMinIntervalPrefix;
+  const QString m_settingMaxIntervalPrefix;
+
+  // Upper bound on the adaptive interval of samples that are normally read
+  // on every pass (i.e. that have a fixed interval of zero)
+  static const unsigned int s_maxAdaptiveIntervalForFastSamplesMs = 250;
 
   void groupLikeSettings();
   void setupWidgets();
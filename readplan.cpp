@@ -0,0 +1,165 @@
+#include <algorithm>
+#include "readplan.h"
+
+namespace
+{
+/**
+ * RAM locations of the samples that can be decoded directly from raw memory,
+ * each being the location read by the libcomm14cux function named beside it.
+ * The fuel map row and column bytes are adjacent, and are read together.
+ */
+const ReadPlan::Location s_ramLocations[] =
+{
+  // c14cux_getFuelMapRowIndex(), c14cux_getFuelMapColumnIndex()
+  { SampleType_FuelMapRowCol,      C14CUX_FuelMapRowIndexOffset,
+    C14CUX_FuelMapColumnIndexOffset - C14CUX_FuelMapRowIndexOffset + 1 },
+  // c14cux_getRoadSpeed()
+  { SampleType_RoadSpeed,          C14CUX_RoadSpeedOffset,                1 },
+  // c14cux_getEngineRPM()
+  { SampleType_EngineRPM,          C14CUX_EngineSpeedFilteredOffset,      2 },
+  // c14cux_getInjectorPulseWidth()
+  { SampleType_InjectorPulseWidth, ReadPlan::s_injectorPulseWidthOffset,  2 }
+};
+
+const unsigned int s_ramLocationCount = sizeof(s_ramLocations) / sizeof(s_ramLocations[0]);
+
+bool isLowerOffset(const ReadPlan::Location& a, const ReadPlan::Location& b)
+{
+  return a.offset < b.offset;
+}
+}
+
+/**
+ * Constructor.
+ * @param maxGapBytes Largest run of unused bytes that will be read through in
+ *  order to merge two locations into one block
+ */
+ReadPlan::ReadPlan(unsigned int maxGapBytes) :
+  m_maxGapBytes(maxGapBytes)
+{
+}
+
+/**
+ * Looks up the RAM location of a sample type.
+ * @param type Sample type to look up
+ * @param location Populated with the location when one is known
+ * @return True if the sample can be read as part of a block; false otherwise
+ */
+bool ReadPlan::findLocation(SampleType type, Location& location)
+{
+  bool found = false;
+
+  for (unsigned int idx = 0; !found && (idx < s_ramLocationCount); idx++)
+  {
+    if (s_ramLocations[idx].type == type)
+    {
+      location = s_ramLocations[idx];
+      found = true;
+    }
+  }
+
+  return found;
+}
+
+/**
+ * Builds the set of block reads needed to fetch the provided samples. Samples
+ * with a known RAM location are sorted by address, and neighbours that are
+ * separated by no more than the maximum gap are merged into a single block.
+ * @param samples Sample types that are due to be read
+ */
+void ReadPlan::build(const QList<SampleType>& samples)
+{
+  QList<Location> located;
+  Location loc;
+
+  m_blocks.clear();
+  m_individualSamples.clear();
+
+  foreach(SampleType type, samples)
+  {
+    if (findLocation(type, loc))
+    {
+      located.append(loc);
+    }
+    else
+    {
+      m_individualSamples.append(type);
+    }
+  }
+
+  std::sort(located.begin(), located.end(), isLowerOffset);
+
+  foreach(const Location& l, located)
+  {
+    if (!m_blocks.isEmpty() &&
+        (l.offset <= m_blocks.last().offset + m_blocks.last().length + m_maxGapBytes))
+    {
+      Block& b = m_blocks.last();
+      const unsigned int end = qMax((unsigned int)(b.offset + b.length), (unsigned int)(l.offset + l.length));
+      b.length = (uint16_t)(end - b.offset);
+      b.members.append(l);
+    }
+    else
+    {
+      Block b;
+      b.offset = l.offset;
+      b.length = l.length;
+      b.members.append(l);
+      m_blocks.append(b);
+    }
+  }
+}
+
+/**
+ * Converts the filtered spark period (in 2us ticks) to engine speed, as
+ * c14cux_getEngineRPM() does.
+ * @param data Raw contents of the sample's RAM location
+ * @return Engine speed in RPM, or zero if the engine isn't turning
+ */
+uint16_t ReadPlan::decodeEngineRPM(const uint8_t* data)
+{
+  const uint16_t period = (data[0] << 8) | data[1];
+
+  // a period of 0xFFFF indicates that the engine isn't turning
+  return ((period == 0) || (period == 0xFFFF)) ? 0 : (uint16_t)(s_rpmPeriodDividend / period);
+}
+
+/**
+ * Converts the road speed (held by the ECU in KPH) to MPH, rounding as
+ * c14cux_getRoadSpeed() does.
+ * @param data Raw contents of the sample's RAM location
+ * @return Road speed in MPH
+ */
+uint8_t ReadPlan::decodeRoadSpeedMPH(const uint8_t* data)
+{
+  return (uint8_t)((float)data[0] / 1.609344 + 0.5);
+}
+
+/**
+ * Splits the fuel map row and column bytes into their indices (upper nibble)
+ * and weightings (lower nibble), as c14cux_getFuelMapRowIndex() and
+ * c14cux_getFuelMapColumnIndex() do.
+ * @param data Raw contents of the sample's RAM location
+ */
+void ReadPlan::decodeFuelMapRowCol(const uint8_t* data, uint8_t* row, uint8_t* rowWeighting,
+                                   uint8_t* col, uint8_t* colWeighting)
+{
+  const uint8_t rowByte = data[0];
+  const uint8_t colByte = data[C14CUX_FuelMapColumnIndexOffset - C14CUX_FuelMapRowIndexOffset];
+
+  *row = rowByte >> 4;
+  *rowWeighting = rowByte & 0x0F;
+  *col = colByte >> 4;
+  *colWeighting = colByte & 0x0F;
+}
+
+/**
+ * Converts the injector pulse width timer count to microseconds, as
+ * c14cux_getInjectorPulseWidth() does.
+ * @param data Raw contents of the sample's RAM location
+ * @return Pulse width in microseconds
+ */
+uint16_t ReadPlan::decodeInjectorPulseWidthUs(const uint8_t* data)
+{
+  return ((data[0] << 8) | data[1]) * s_timerTickUs;
+}
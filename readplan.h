@@ -0,0 +1,73 @@
+#ifndef READPLAN_H
+#define READPLAN_H
+
+#include <QList>
+#include <stdint.h>
+#include "comm14cux.h"
+#include "commonunits.h"
+
+/**
+ * Groups samples that live in nearby locations of the 14CUX RAM so that they
+ * can be fetched with a single block read rather than one library call each.
+ * Samples with no known RAM location (or whose conversion depends on state
+ * held inside libcomm14cux) are left for the caller to read individually.
+ */
+class ReadPlan
+{
+public:
+  struct Location
+  {
+    SampleType type;
+    uint16_t offset;
+    uint16_t length;
+  };
+
+  struct Block
+  {
+    uint16_t offset;
+    uint16_t length;
+    QList<Location> members;
+  };
+
+  explicit ReadPlan(unsigned int maxGapBytes = s_defaultMaxGapBytes);
+
+  void build(const QList<SampleType>& samples);
+
+  const QList<Block>& blocks() const
+  {
+    return m_blocks;
+  }
+
+  const QList<SampleType>& individualSamples() const
+  {
+    return m_individualSamples;
+  }
+
+  static bool findLocation(SampleType type, Location& location);
+
+  static uint16_t decodeEngineRPM(const uint8_t* data);
+  static uint8_t decodeRoadSpeedMPH(const uint8_t* data);
+  static void decodeFuelMapRowCol(const uint8_t* data, uint8_t* row, uint8_t* rowWeighting,
+                                  uint8_t* col, uint8_t* colWeighting);
+  static uint16_t decodeInjectorPulseWidthUs(const uint8_t* data);
+
+  // Locations and conversions that libcomm14cux uses internally but doesn't
+  // export. Each mirrors the library function named beside it, so that a
+  // sample read as part of a block gives the same reading as the library
+  // call would; they must be kept in step with the library.
+  static const uint16_t s_injectorPulseWidthOffset = 0x2010; // c14cux_getInjectorPulseWidth()
+  static const uint16_t s_timerTickUs = 2;                   // c14cux_getInjectorPulseWidth()
+  static const uint32_t s_rpmPeriodDividend = 7500000;       // c14cux_getEngineRPM()
+
+  // Gaps up to this size are read through rather than split, since each
+  // extra request costs several bytes of addressing overhead on the link.
+  static const unsigned int s_defaultMaxGapBytes = 8;
+
+private:
+  unsigned int m_maxGapBytes;
+  QList<Block> m_blocks;
+  QList<SampleType> m_individualSamples;
+};
+
+#endif // READPLAN_H
+
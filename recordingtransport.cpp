@@ -0,0 +1,119 @@
+#include <QDateTime>
+#include "recordingtransport.h"
+
+/**
+ * Constructor. Opens the session file and writes its header.
+ * @param transport Transport whose traffic is to be recorded. The recorder
+ *  takes ownership of it.
+ * @param fileName Path of the session file to create
+ */
+RecordingTransport::RecordingTransport(EcuTransport* transport, QString fileName) :
+  m_transport(transport),
+  m_file(fileName)
+{
+  m_clock.start();
+
+  if (m_file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+  {
+    m_stream.setDevice(&m_file);
+    m_stream.setVersion(QDataStream::Qt_5_0);
+    m_stream.setByteOrder(QDataStream::BigEndian);
+
+    m_stream << s_fileMagic << s_fileVersion << QDateTime::currentDateTime();
+  }
+}
+
+/**
+ * Destructor. Closes the session file and deletes the wrapped transport.
+ */
+RecordingTransport::~RecordingTransport()
+{
+  m_file.close();
+  delete m_transport;
+}
+
+/**
+ * Writes the fields common to all records.
+ */
+void RecordingTransport::writeRecordHeader(RecordType type, qint64 startUs, qint64 endUs)
+{
+  m_stream << (quint8)type << startUs << (qint32)(endUs - startUs);
+}
+
+void RecordingTransport::init()
+{
+  m_transport->init();
+}
+
+/**
+ * Connects the wrapped transport, recording the outcome.
+ */
+bool RecordingTransport::connect(QString device, unsigned int baud)
+{
+  const qint64 startUs = m_clock.nsecsElapsed() / 1000;
+  const bool status = m_transport->connect(device, baud);
+
+  if (isRecording())
+  {
+    writeRecordHeader(RecordType_Connect, startUs, m_clock.nsecsElapsed() / 1000);
+    m_stream << (quint8)status;
+  }
+
+  return status;
+}
+
+/**
+ * Disconnects the wrapped transport, recording the event and flushing the file.
+ */
+void RecordingTransport::disconnect()
+{
+  const qint64 startUs = m_clock.nsecsElapsed() / 1000;
+
+  m_transport->disconnect();
+
+  if (isRecording())
+  {
+    writeRecordHeader(RecordType_Disconnect, startUs, m_clock.nsecsElapsed() / 1000);
+    m_file.flush();
+  }
+}
+
+bool RecordingTransport::isConnected()
+{
+  return m_transport->isConnected();
+}
+
+void RecordingTransport::cancelRead()
+{
+  m_transport->cancelRead();
+}
+
+void RecordingTransport::resetState()
+{
+  m_transport->resetState();
+}
+
+/**
+ * Passes an operation to the wrapped transport and records the exchange.
+ */
+bool RecordingTransport::call(const EcuRequest& request, uint8_t* result, unsigned int resultSize)
+{
+  const qint64 startUs = m_clock.nsecsElapsed() / 1000;
+  const bool status = m_transport->call(request, result, resultSize);
+
+  if (isRecording())
+  {
+    writeRecordHeader(RecordType_Call, startUs, m_clock.nsecsElapsed() / 1000);
+    m_stream << (quint8)request.op
+             << request.args[0] << request.args[1] << request.args[2]
+             << (quint8)status;
+
+    if (status)
+    {
+      m_stream << (quint32)resultSize;
+      m_stream.writeRawData((const char*)result, resultSize);
+    }
+  }
+
+  return status;
+}
@@ -0,0 +1,64 @@
+#ifndef RECORDINGTRANSPORT_H
+#define RECORDINGTRANSPORT_H
+
+#include <QFile>
+#include <QDataStream>
+#include <QElapsedTimer>
+#include "ecutransport.h"
+
+/**
+ * Wraps another transport and records every exchange that passes through it
+ * to a session file, which can later be played back with a ReplayTransport.
+ *
+ * The file starts with a header (magic number, format version, and the
+ * wall-clock time at which recording started), followed by one record per
+ * exchange. Each record holds its type, the time at which it started (in
+ * microseconds since recording started) and its duration; call records then
+ * hold the operation, its arguments, the result status, and (when the call
+ * succeeded) the result bytes. All values are big-endian.
+ */
+class RecordingTransport : public EcuTransport
+{
+public:
+  enum RecordType
+  {
+    RecordType_Connect = 1,
+    RecordType_Disconnect = 2,
+    RecordType_Call = 3
+  };
+
+  static const quint32 s_fileMagic = 0x52475352; // "RGSR"
+  static const quint16 s_fileVersion = 1;
+
+  RecordingTransport(EcuTransport* transport, QString fileName);
+  ~RecordingTransport();
+
+  bool isRecording() const
+  {
+    return m_file.isOpen();
+  }
+
+  QString errorString() const
+  {
+    return m_file.errorString();
+  }
+
+  void init();
+  bool connect(QString device, unsigned int baud);
+  void disconnect();
+  bool isConnected();
+  void cancelRead();
+  void resetState();
+
+  bool call(const EcuRequest& request, uint8_t* result, unsigned int resultSize);
+
+private:
+  EcuTransport* m_transport;
+  QFile m_file;
+  QDataStream m_stream;
+  QElapsedTimer m_clock;
+
+  void writeRecordHeader(RecordType type, qint64 startUs, qint64 endUs);
+};
+
+#endif // RECORDINGTRANSPORT_H
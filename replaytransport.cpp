@@ -0,0 +1,275 @@
+#include <QFile>
+#include <QDataStream>
+#include <QThread>
+#include <string.h>
+#include "replaytransport.h"
+
+/**
+ * Constructor. Reads the whole session file into memory.
+ * @param fileName Path of a session file written by a RecordingTransport
+ * @param realTime True to reproduce the recorded timing of each call; false
+ *  to return results as quickly as possible
+ */
+ReplayTransport::ReplayTransport(QString fileName, bool realTime) :
+  m_position(0),
+  m_realTime(realTime),
+  m_connected(false),
+  m_valid(false)
+{
+  m_valid = load(fileName);
+}
+
+/**
+ * Parses the session file.
+ * @return True if the file was read successfully; false otherwise
+ */
+bool ReplayTransport::load(QString fileName)
+{
+  QFile file(fileName);
+
+  if (!file.open(QIODevice::ReadOnly))
+  {
+    m_errorString = file.errorString();
+    return false;
+  }
+
+  QDataStream in(&file);
+  in.setVersion(QDataStream::Qt_5_0);
+  in.setByteOrder(QDataStream::BigEndian);
+
+  quint32 magic = 0;
+  quint16 version = 0;
+  in >> magic >> version >> m_startTime;
+
+  if ((magic != RecordingTransport::s_fileMagic) || (version != RecordingTransport::s_fileVersion))
+  {
+    m_errorString = "Not a recognized session recording.";
+    return false;
+  }
+
+  while (!in.atEnd() && (in.status() == QDataStream::Ok))
+  {
+    Record r;
+    qint64 startUs = 0;
+    quint8 status = 0;
+
+    in >> r.type >> startUs >> r.durationUs;
+    r.request.op = EcuOp_NumOps;
+    r.request.args[0] = r.request.args[1] = r.request.args[2] = 0;
+    r.status = false;
+
+    if (r.type == RecordingTransport::RecordType_Connect)
+    {
+      in >> status;
+      r.status = (status != 0);
+    }
+    else if (r.type == RecordingTransport::RecordType_Call)
+    {
+      quint8 op = 0;
+      in >> op >> r.request.args[0] >> r.request.args[1] >> r.request.args[2] >> status;
+      r.request.op = (EcuOp)op;
+      r.status = (status != 0);
+
+      if (r.status)
+      {
+        quint32 size = 0;
+        in >> size;
+        r.result.resize(size);
+        if (in.readRawData(r.result.data(), size) != (int)size)
+        {
+          in.setStatus(QDataStream::ReadPastEnd);
+        }
+      }
+    }
+
+    if (in.status() == QDataStream::Ok)
+    {
+      m_records.append(r);
+    }
+  }
+
+  // a truncated final record (e.g. from a recording that was cut short) is
+  // dropped, but everything before it is still usable
+  if (m_records.isEmpty())
+  {
+    m_errorString = "Session recording contains no data.";
+    return false;
+  }
+
+  return true;
+}
+
+/**
+ * Combines an operation and its arguments into a single hash key.
+ */
+quint64 ReplayTransport::requestKey(const EcuRequest& request)
+{
+  return ((quint64)request.op << 48) | ((quint64)request.args[0] << 32) |
+         ((quint64)request.args[1] << 16) | (quint64)request.args[2];
+}
+
+/**
+ * Returns true if the record is a call with the same operation and arguments
+ * as the request.
+ */
+bool ReplayTransport::matches(const Record& record, const EcuRequest& request)
+{
+  return (record.type == RecordingTransport::RecordType_Call) &&
+         (record.request.op == request.op) &&
+         (record.request.args[0] == request.args[0]) &&
+         (record.request.args[1] == request.args[1]) &&
+         (record.request.args[2] == request.args[2]);
+}
+
+void ReplayTransport::init()
+{
+}
+
+/**
+ * Advances to the next connection in the recording and returns its outcome.
+ * The device name and baud rate are ignored.
+ * @return True if the recorded connection attempt succeeded; false if it
+ *  failed or the recording has ended
+ */
+bool ReplayTransport::connect(QString device, unsigned int baud)
+{
+  Q_UNUSED(device);
+  Q_UNUSED(baud);
+
+  m_connected = false;
+
+  while (m_valid && (m_position < m_records.size()) && !m_connected)
+  {
+    const Record& r = m_records.at(m_position++);
+
+    if (r.type == RecordingTransport::RecordType_Connect)
+    {
+      if (m_realTime)
+      {
+        waitFor(r.durationUs);
+      }
+
+      // a failed attempt is reported as such; the next connect() moves on
+      // to the following attempt
+      if (!r.status)
+      {
+        return false;
+      }
+      m_connected = true;
+    }
+  }
+
+  return m_connected;
+}
+
+void ReplayTransport::disconnect()
+{
+  m_connected = false;
+}
+
+/**
+ * Returns true while connected and the recording has calls left to replay.
+ */
+bool ReplayTransport::isConnected()
+{
+  return m_connected && (m_position < m_records.size());
+}
+
+/**
+ * Cancels the operation in progress. May be called from any thread.
+ */
+void ReplayTransport::cancelRead()
+{
+  m_cancelRequested.storeRelease(1);
+}
+
+void ReplayTransport::resetState()
+{
+  m_lastMatch.clear();
+}
+
+/**
+ * Blocks for the given duration (in slices, so that it can be cancelled).
+ * @return False if the wait was interrupted by a cancel request; true otherwise
+ */
+bool ReplayTransport::waitFor(qint32 durationUs)
+{
+  qint32 remainingUs = durationUs;
+
+  while ((remainingUs > 0) && !m_cancelRequested.loadAcquire())
+  {
+    const qint32 sliceUs = qMin(remainingUs, (qint32)s_maxSleepSliceUs);
+    QThread::usleep(sliceUs);
+    remainingUs -= sliceUs;
+  }
+
+  return (m_cancelRequested.fetchAndStoreAcquire(0) == 0);
+}
+
+/**
+ * Answers a request from the recording.
+ */
+bool ReplayTransport::call(const EcuRequest& request, uint8_t* result, unsigned int resultSize)
+{
+  if (!isConnected())
+  {
+    return false;
+  }
+
+  const quint64 key = requestKey(request);
+  int found = -1;
+
+  for (int idx = m_position; (found < 0) && (idx < m_records.size()) && (idx - m_position < s_maxLookahead); idx++)
+  {
+    const Record& r = m_records.at(idx);
+
+    if (r.type == RecordingTransport::RecordType_Disconnect)
+    {
+      break;
+    }
+    else if (matches(r, request))
+    {
+      found = idx;
+    }
+  }
+
+  if (found >= 0)
+  {
+    m_position = found + 1;
+    m_lastMatch.insert(key, found);
+
+    // the recorded session disconnected here, so this one does too
+    if ((m_position < m_records.size()) &&
+        (m_records.at(m_position).type == RecordingTransport::RecordType_Disconnect))
+    {
+      m_position++;
+      m_connected = false;
+    }
+  }
+  else if (m_lastMatch.contains(key))
+  {
+    found = m_lastMatch.value(key);
+  }
+  else
+  {
+    return false;
+  }
+
+  const Record& r = m_records.at(found);
+
+  if (m_realTime && !waitFor(r.durationUs))
+  {
+    return false;
+  }
+
+  if (r.status)
+  {
+    if ((unsigned int)r.result.size() != resultSize)
+    {
+      return false;
+    }
+    memcpy(result, r.result.constData(), resultSize);
+  }
+
+  return r.status;
+}
@@ -0,0 +1,89 @@
+#ifndef REPLAYTRANSPORT_H
+#define REPLAYTRANSPORT_H
+
+#include <QVector>
+#include <QHash>
+#include <QByteArray>
+#include <QDateTime>
+#include <QAtomicInt>
+#include "ecutransport.h"
+#include "recordingtransport.h"
+
+/**
+ * Transport that plays back a session file written by a RecordingTransport.
+ * Each request is answered with the result recorded for the same operation
+ * and arguments. In real-time mode, each call takes as long as it did when it
+ * was recorded; otherwise results are returned immediately, so that the
+ * polling and logging code can be exercised as fast as it will go.
+ *
+ * Replay follows the recording in order. Because the polling schedule depends
+ * on timing, a request may not match the next recorded call exactly; in that
+ * case the transport looks a short distance ahead for a match, and failing
+ * that reuses the most recent result recorded for that request. The session
+ * ends (and the transport reports itself disconnected) once the end of the
+ * recording is reached.
+ */
+class ReplayTransport : public EcuTransport
+{
+public:
+  ReplayTransport(QString fileName, bool realTime);
+
+  bool isValid() const
+  {
+    return m_valid;
+  }
+
+  QString errorString() const
+  {
+    return m_errorString;
+  }
+
+  QDateTime recordingStartTime() const
+  {
+    return m_startTime;
+  }
+
+  void init();
+  bool connect(QString device, unsigned int baud);
+  void disconnect();
+  bool isConnected();
+  void cancelRead();
+  void resetState();
+
+  bool call(const EcuRequest& request, uint8_t* result, unsigned int resultSize);
+
+private:
+  struct Record
+  {
+    quint8 type;
+    qint32 durationUs;
+    EcuRequest request;
+    bool status;
+    QByteArray result;
+  };
+
+  // Number of recorded calls that will be skipped over to find one matching
+  // the current request
+  static const int s_maxLookahead = 64;
+
+  // Longest single sleep while replaying a call's duration, so that a cancel
+  // request is noticed promptly
+  static const unsigned int s_maxSleepSliceUs = 50000;
+
+  QVector<Record> m_records;
+  QHash<quint64, int> m_lastMatch;
+  int m_position;
+  bool m_realTime;
+  bool m_connected;
+  bool m_valid;
+  QString m_errorString;
+  QDateTime m_startTime;
+  QAtomicInt m_cancelRequested;
+
+  bool load(QString fileName);
+  static quint64 requestKey(const EcuRequest& request);
+  static bool matches(const Record& record, const EcuRequest& request);
+  bool waitFor(qint32 durationUs);
+};
+
+#endif // REPLAYTRANSPORT_H
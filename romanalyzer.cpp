@@ -0,0 +1,556 @@
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QRunnable>
+#include <QSettings>
+#include <QTextStream>
+#include <QThreadPool>
+#include <algorithm>
+#include "romanalyzer.h"
+#include "ecudatacache.h"
+
+namespace
+{
+  const int fuelMapSize = FUEL_MAP_ROWS * FUEL_MAP_COLUMNS;
+
+  /**
+   * Reads and analyzes a single ROM image file on a pool thread.
+   */
+  class AnalyzeTask : public QRunnable
+  {
+  public:
+    AnalyzeTask(const RomAnalyzer* analyzer, QString fileName, RomInfo* result) :
+      m_analyzer(analyzer),
+      m_fileName(fileName),
+      m_result(result)
+    {
+    }
+
+    void run()
+    {
+      QFile file(m_fileName);
+
+      if (file.open(QFile::ReadOnly))
+      {
+        // read one byte more than a ROM image so that larger files are rejected
+        *m_result = m_analyzer->analyze(file.read(RomAnalyzer::s_romSize + 1), m_fileName);
+      }
+      else
+      {
+        m_result->fileName = m_fileName;
+        m_result->error = file.errorString();
+      }
+    }
+
+  private:
+    const RomAnalyzer* m_analyzer;
+    QString m_fileName;
+    RomInfo* m_result;
+  };
+
+  /**
+   * Formats a value in hex for the report, or leaves the field empty if the
+   * value wasn't found.
+   */
+  QString hexOrBlank(int value, int width)
+  {
+    return (value >= 0) ? QString("%1").arg(value, width, 16, QChar('0')).toUpper() : QString();
+  }
+}
+
+RomLayout::RomLayout() :
+  mafScalerOffset(-1),
+  tuneOffset(-1),
+  checksumFixerOffset(-1),
+  identOffset(-1)
+{
+  for (int idx = 0; idx < s_numFuelMaps; idx++)
+  {
+    fuelMapOffsets[idx] = -1;
+    adjFactorOffsets[idx] = -1;
+    rowScalerOffsets[idx] = -1;
+  }
+}
+
+RomInfo::RomInfo() :
+  checksum(0),
+  mapRoughness(-1.0),
+  tune(-1),
+  checksumFixer(-1),
+  ident(-1),
+  mafScaler(-1)
+{
+  for (int idx = 0; idx < RomLayout::s_numFuelMaps; idx++)
+  {
+    adjFactors[idx] = -1;
+    rowScalers[idx] = -1;
+  }
+}
+
+RomAnalyzer::RomAnalyzer()
+{
+}
+
+/**
+ * Returns the name of the file in which additional layouts can be described,
+ * which is kept alongside the settings file.
+ */
+QString RomAnalyzer::defaultLayoutFileName()
+{
+  QSettings settings(QSettings::IniFormat, QSettings::UserScope, "RoverGauge");
+  return QFileInfo(settings.fileName()).absoluteDir().filePath("romlayouts.ini");
+}
+
+void RomAnalyzer::addLayout(const RomLayout& layout)
+{
+  m_layouts.append(layout);
+}
+
+/**
+ * Loads layouts from an INI file. Each section describes one layout, giving
+ * the ECU addresses of its tables, e.g.:
+ *
+ *   [MyLayout]
+ *   fuelMaps=0xC000, 0xC100, 0xC200, 0xC300, 0xC400, 0xC500
+ *   adjustmentFactors=0xC080, 0xC180, 0xC280, 0xC380, 0xC480, 0xC580
+ *   rowScalers=...
+ *   mafRowScaler=...
+ *   tune=...
+ *   checksumFixer=...
+ *   ident=...
+ *
+ * The MAF row scaler defaults to the address used by libcomm14cux; the other
+ * tables are left unknown unless given.
+ * @return Number of layouts loaded
+ */
+int RomAnalyzer::loadLayouts(QString fileName)
+{
+  int loaded = 0;
+
+  if (!QFile::exists(fileName))
+  {
+    return 0;
+  }
+
+  QSettings settings(fileName, QSettings::IniFormat);
+
+  foreach(const QString& group, settings.childGroups())
+  {
+    RomLayout layout;
+    bool found = false;
+
+    settings.beginGroup(group);
+
+    const QStringList maps = settings.value("fuelMaps").toStringList();
+    const QStringList factors = settings.value("adjustmentFactors").toStringList();
+    const QStringList scalers = settings.value("rowScalers").toStringList();
+
+    layout.name = group;
+    for (int idx = 0; idx < RomLayout::s_numFuelMaps; idx++)
+    {
+      layout.fuelMapOffsets[idx] = (idx < maps.size()) ? addressToOffset(maps.at(idx)) : -1;
+      layout.adjFactorOffsets[idx] = (idx < factors.size()) ? addressToOffset(factors.at(idx)) : -1;
+      layout.rowScalerOffsets[idx] = (idx < scalers.size()) ? addressToOffset(scalers.at(idx)) : -1;
+      found = found || (layout.fuelMapOffsets[idx] >= 0);
+    }
+
+    layout.mafScalerOffset =
+      addressToOffset(settings.value("mafRowScaler", QString::number(C14CUX_MAFRowScalerOffset)).toString());
+    layout.tuneOffset = addressToOffset(settings.value("tune").toString());
+    layout.checksumFixerOffset = addressToOffset(settings.value("checksumFixer").toString());
+    layout.identOffset = addressToOffset(settings.value("ident").toString());
+
+    settings.endGroup();
+
+    if (found)
+    {
+      addLayout(layout);
+      loaded++;
+    }
+  }
+
+  return loaded;
+}
+
+/**
+ * Learns layouts from the entries in the ECU data cache that hold a ROM
+ * image. The fuel maps in each entry were decoded from the same ROM by
+ * libcomm14cux, so finding them in the image gives their locations for that
+ * ROM revision. Each map's adjustment factor is looked for just after the
+ * map, and is only recorded if it appears exactly once there.
+ * @return Number of layouts learned
+ */
+int RomAnalyzer::learnLayoutsFromCache()
+{
+  int learned = 0;
+
+  foreach(const QString& fileName, EcuDataCache::entryFileNames())
+  {
+    EcuDataCache cache;
+
+    if (cache.openFile(fileName) && (cache.getROMImage().size() == s_romSize))
+    {
+      const QByteArray image = cache.getROMImage();
+      const int mafScalerOffset = C14CUX_MAFRowScalerOffset - s_romBaseAddress;
+      RomLayout layout;
+      uint16_t mafScaler = 0;
+      bool found = false;
+
+      layout.name = QFileInfo(fileName).completeBaseName();
+
+      for (int idx = 0; idx < RomLayout::s_numFuelMaps; idx++)
+      {
+        QByteArray data;
+        uint16_t adjFactor = 0;
+        uint8_t rowScaler = 0;
+
+        if (cache.getFuelMap(idx, data, adjFactor, rowScaler))
+        {
+          const int offset = uniqueIndexOf(image, data);
+
+          if (offset >= 0)
+          {
+            QByteArray factorBytes;
+            factorBytes.append((char)(adjFactor >> 8));
+            factorBytes.append((char)(adjFactor & 0xFF));
+
+            layout.fuelMapOffsets[idx] = offset;
+            layout.adjFactorOffsets[idx] =
+              uniqueIndexOf(image, factorBytes, offset + fuelMapSize, offset + fuelMapSize + s_adjFactorSearchBytes);
+            found = true;
+          }
+        }
+      }
+
+      if (cache.getMAFRowScaler(mafScaler) && (readWord(image, mafScalerOffset) == mafScaler))
+      {
+        layout.mafScalerOffset = mafScalerOffset;
+      }
+
+      if (found)
+      {
+        addLayout(layout);
+        learned++;
+      }
+    }
+  }
+
+  return learned;
+}
+
+/**
+ * Decodes the tables in a ROM image, using the layout that finds the
+ * smoothest fuel maps in it.
+ * @param image Contents of the ROM
+ * @param fileName Name of the file the image was read from, for reporting
+ * @return The decoded tables; the layout name is empty if no layout fits
+ */
+RomInfo RomAnalyzer::analyze(const QByteArray& image, QString fileName) const
+{
+  RomInfo info;
+  int best = -1;
+
+  info.fileName = fileName;
+
+  if (image.size() != s_romSize)
+  {
+    info.error = QString("Not a 16KB ROM image (%1 bytes)").arg(image.size());
+    return info;
+  }
+
+  info.hash = QCryptographicHash::hash(image, QCryptographicHash::Sha1);
+  for (int idx = 0; idx < image.size(); idx++)
+  {
+    info.checksum += (quint8)image.at(idx);
+  }
+
+  for (int idx = 0; idx < m_layouts.size(); idx++)
+  {
+    const double roughness = mapRoughness(image, m_layouts.at(idx));
+
+    if ((roughness >= 0.0) && (roughness <= s_maxMapRoughness) &&
+        ((best < 0) || (roughness < info.mapRoughness)))
+    {
+      best = idx;
+      info.mapRoughness = roughness;
+    }
+  }
+
+  if (best < 0)
+  {
+    info.error = "No known layout matches the image";
+    return info;
+  }
+
+  const RomLayout& layout = m_layouts.at(best);
+
+  info.layoutName = layout.name;
+  for (int idx = 0; idx < RomLayout::s_numFuelMaps; idx++)
+  {
+    if (layout.fuelMapOffsets[idx] >= 0)
+    {
+      info.fuelMaps[idx] = image.mid(layout.fuelMapOffsets[idx], fuelMapSize);
+      info.fuelMapHashes[idx] = QCryptographicHash::hash(info.fuelMaps[idx], QCryptographicHash::Sha1);
+    }
+    info.adjFactors[idx] = readWord(image, layout.adjFactorOffsets[idx]);
+    info.rowScalers[idx] = readByte(image, layout.rowScalerOffsets[idx]);
+  }
+
+  info.mafScaler = readWord(image, layout.mafScalerOffset);
+  info.tune = readWord(image, layout.tuneOffset);
+  info.checksumFixer = readByte(image, layout.checksumFixerOffset);
+  info.ident = readWord(image, layout.identOffset);
+
+  return info;
+}
+
+/**
+ * Analyzes a number of ROM image files, spread across the available cores,
+ * and adds them to the index.
+ * @return Number of images whose tables were decoded
+ */
+int RomAnalyzer::analyzeFiles(const QStringList& fileNames)
+{
+  QVector<RomInfo> results(fileNames.size());
+  QThreadPool pool;
+  int decoded = 0;
+
+  for (int idx = 0; idx < fileNames.size(); idx++)
+  {
+    pool.start(new AnalyzeTask(this, fileNames.at(idx), &results[idx]));
+  }
+  pool.waitForDone();
+
+  foreach(const RomInfo& info, results)
+  {
+    addToIndex(info);
+
+    if (!info.layoutName.isEmpty())
+    {
+      decoded++;
+    }
+  }
+
+  return decoded;
+}
+
+/**
+ * Analyzes every file in a directory that is the size of a ROM image.
+ * @return Number of images whose tables were decoded
+ */
+int RomAnalyzer::analyzeDirectory(QString dirName)
+{
+  QStringList fileNames;
+
+  foreach(const QFileInfo& info, QDir(dirName).entryInfoList(QDir::Files, QDir::Name))
+  {
+    if (info.size() == s_romSize)
+    {
+      fileNames.append(info.absoluteFilePath());
+    }
+  }
+
+  return analyzeFiles(fileNames);
+}
+
+void RomAnalyzer::clear()
+{
+  m_roms.clear();
+  m_imageIndex.clear();
+  m_fuelMapIndex.clear();
+}
+
+void RomAnalyzer::addToIndex(const RomInfo& info)
+{
+  const int idx = m_roms.size();
+
+  m_roms.append(info);
+
+  if (!info.hash.isEmpty() && !m_imageIndex.contains(info.hash))
+  {
+    m_imageIndex.insert(info.hash, idx);
+  }
+
+  for (int mapId = 0; mapId < RomLayout::s_numFuelMaps; mapId++)
+  {
+    if (!info.fuelMapHashes[mapId].isEmpty())
+    {
+      m_fuelMapIndex.insert(info.fuelMapHashes[mapId], idx);
+    }
+  }
+}
+
+/**
+ * Returns the index of the first analyzed image with the given SHA-1 hash,
+ * or -1 if there isn't one.
+ */
+int RomAnalyzer::findImage(const QByteArray& hash) const
+{
+  return m_imageIndex.value(hash, -1);
+}
+
+/**
+ * Returns the indices of the analyzed images that contain a fuel map with
+ * the given SHA-1 hash (in any position), in the order they were analyzed.
+ */
+QList<int> RomAnalyzer::findFuelMap(const QByteArray& mapHash) const
+{
+  QList<int> matches = m_fuelMapIndex.values(mapHash);
+
+  std::sort(matches.begin(), matches.end());
+  matches.erase(std::unique(matches.begin(), matches.end()), matches.end());
+  return matches;
+}
+
+/**
+ * Produces a CSV report of the analyzed images, with one row per image.
+ * Fuel maps are identified by the start of their hash, so that identical
+ * maps can be spotted across images, and each image that is identical to an
+ * earlier one names it.
+ */
+QString RomAnalyzer::formatReport() const
+{
+  QString report;
+  QTextStream out(&report);
+
+  out << "#generated," << QDateTime::currentDateTime().toString("yyyy-MM-dd_hh:mm:ss.zzz") << endl;
+  out << "#file,sha1,checksum,layout,tune,checksumFixer,ident,mafScaler,sameAs";
+  for (int mapId = 0; mapId < RomLayout::s_numFuelMaps; mapId++)
+  {
+    out << ",map" << mapId << ",map" << mapId << "Factor,map" << mapId << "RowScaler";
+  }
+  out << ",error" << endl;
+
+  for (int idx = 0; idx < m_roms.size(); idx++)
+  {
+    const RomInfo& info = m_roms.at(idx);
+    const int first = info.hash.isEmpty() ? idx : findImage(info.hash);
+
+    out << QFileInfo(info.fileName).fileName() << ","
+        << info.hash.toHex() << ","
+        << (info.hash.isEmpty() ? QString() : hexOrBlank(info.checksum, 2)) << ","
+        << info.layoutName << ","
+        << hexOrBlank(info.tune, 4) << ","
+        << hexOrBlank(info.checksumFixer, 2) << ","
+        << hexOrBlank(info.ident, 4) << ","
+        << hexOrBlank(info.mafScaler, 4) << ","
+        << ((first != idx) ? QFileInfo(m_roms.at(first).fileName).fileName() : QString());
+
+    for (int mapId = 0; mapId < RomLayout::s_numFuelMaps; mapId++)
+    {
+      out << "," << info.fuelMapHashes[mapId].left(4).toHex()
+          << "," << hexOrBlank(info.adjFactors[mapId], 4)
+          << "," << hexOrBlank(info.rowScalers[mapId], 2);
+    }
+    out << "," << info.error << endl;
+  }
+
+  return report;
+}
+
+/**
+ * Returns the mean difference between neighbouring cells across the fuel
+ * maps of a layout, or -1 if the layout has no maps or they don't fit in
+ * the image.
+ */
+double RomAnalyzer::mapRoughness(const QByteArray& image, const RomLayout& layout)
+{
+  const uchar* data = (const uchar*)image.constData();
+  qint64 total = 0;
+  int count = 0;
+  bool fits = true;
+
+  for (int idx = 0; idx < RomLayout::s_numFuelMaps; idx++)
+  {
+    const int offset = layout.fuelMapOffsets[idx];
+
+    if (offset >= 0)
+    {
+      if (offset + fuelMapSize > image.size())
+      {
+        fits = false;
+      }
+      else
+      {
+        const uchar* map = data + offset;
+
+        for (int row = 0; row < FUEL_MAP_ROWS; row++)
+        {
+          for (int col = 0; col < FUEL_MAP_COLUMNS; col++)
+          {
+            const int cell = map[(row * FUEL_MAP_COLUMNS) + col];
+
+            if (col + 1 < FUEL_MAP_COLUMNS)
+            {
+              total += qAbs(cell - map[(row * FUEL_MAP_COLUMNS) + col + 1]);
+              count++;
+            }
+            if (row + 1 < FUEL_MAP_ROWS)
+            {
+              total += qAbs(cell - map[((row + 1) * FUEL_MAP_COLUMNS) + col]);
+              count++;
+            }
+          }
+        }
+      }
+    }
+  }
+
+  return (fits && (count > 0)) ? ((double)total / count) : -1.0;
+}
+
+/**
+ * Returns the byte at an offset in the image, or -1 if the offset is unknown
+ * or out of range.
+ */
+int RomAnalyzer::readByte(const QByteArray& image, int offset)
+{
+  return ((offset >= 0) && (offset < image.size())) ? (uchar)image.at(offset) : -1;
+}
+
+/**
+ * Returns the (big-endian) word at an offset in the image, or -1 if the
+ * offset is unknown or out of range.
+ */
+int RomAnalyzer::readWord(const QByteArray& image, int offset)
+{
+  return ((offset >= 0) && (offset + 1 < image.size())) ?
+         (((uchar)image.at(offset) << 8) | (uchar)image.at(offset + 1)) : -1;
+}
+
+/**
+ * Finds a sequence of bytes that occurs exactly once within a range.
+ * @param from Offset at which to start searching
+ * @param to Offset at which the match must end, or -1 for the end of the data
+ * @return Offset of the match, or -1 if there isn't exactly one
+ */
+int RomAnalyzer::uniqueIndexOf(const QByteArray& haystack, const QByteArray& needle, int from, int to)
+{
+  const int end = (to < 0) ? haystack.size() : qMin(to, haystack.size());
+  const int pos = haystack.indexOf(needle, from);
+
+  if ((pos < 0) || (pos + needle.size() > end))
+  {
+    return -1;
+  }
+
+  const int next = haystack.indexOf(needle, pos + 1);
+
+  return ((next >= 0) && (next + needle.size() <= end)) ? -1 : pos;
+}
+
+/**
+ * Converts an ECU address (in decimal, or hex with a 0x prefix) into an
+ * offset within the ROM image.
+ * @return Offset into the image, or -1 if the address is empty, invalid, or
+ *  outside the ROM
+ */
+int RomAnalyzer::addressToOffset(QString address)
+{
+  bool ok = false;
+  const int offset = address.trimmed().toInt(&ok, 0) - s_romBaseAddress;
+
+  return (ok && (offset >= 0) && (offset < s_romSize)) ? offset : -1;
+}
@@ -0,0 +1,130 @@
+#ifndef ROMANALYZER_H
+#define ROMANALYZER_H
+
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QVector>
+#include <QHash>
+#include <QMultiHash>
+#include "comm14cux.h"
+
+/**
+ * Locations of the calibration tables within a 14CUX ROM image. Offsets are
+ * from the start of the 16KB image; -1 marks a table whose location isn't
+ * known for this layout.
+ */
+struct RomLayout
+{
+  static const int s_numFuelMaps = 6;
+
+  QString name;
+  int fuelMapOffsets[s_numFuelMaps];
+  int adjFactorOffsets[s_numFuelMaps];
+  int rowScalerOffsets[s_numFuelMaps];
+  int mafScalerOffset;
+  int tuneOffset;
+  int checksumFixerOffset;
+  int identOffset;
+
+  RomLayout();
+};
+
+/**
+ * The tables decoded from a single ROM image. Values that couldn't be
+ * located are -1 (or, for fuel maps, empty).
+ */
+struct RomInfo
+{
+  QString fileName;
+  QString error;
+  QByteArray hash;
+  quint8 checksum;
+  QString layoutName;
+  double mapRoughness;
+  int tune;
+  int checksumFixer;
+  int ident;
+  int mafScaler;
+  QByteArray fuelMaps[RomLayout::s_numFuelMaps];
+  QByteArray fuelMapHashes[RomLayout::s_numFuelMaps];
+  int adjFactors[RomLayout::s_numFuelMaps];
+  int rowScalers[RomLayout::s_numFuelMaps];
+
+  RomInfo();
+};
+
+/**
+ * Decodes the fuel maps and scalers from saved 14CUX ROM images, and keeps an
+ * index of the analyzed images so that tunes can be compared across a number
+ * of vehicles.
+ *
+ * The table locations vary between ROM revisions. Layouts are learned from
+ * the ECU data cache (whose fuel maps were decoded by libcomm14cux from the
+ * same ROM as the cached image), and can also be described in an INI file.
+ * Each image is decoded with whichever layout places smooth fuel maps in it,
+ * since the fueling values in a real map change gradually from cell to cell
+ * while code and other data don't.
+ */
+class RomAnalyzer
+{
+public:
+  static const int s_romSize = 16384;
+  static const uint16_t s_romBaseAddress = 0xC000;
+
+  RomAnalyzer();
+
+  void addLayout(const RomLayout& layout);
+  int loadLayouts(QString fileName);
+  int learnLayoutsFromCache();
+
+  int layoutCount() const
+  {
+    return m_layouts.size();
+  }
+
+  RomInfo analyze(const QByteArray& image, QString fileName = QString()) const;
+  int analyzeFiles(const QStringList& fileNames);
+  int analyzeDirectory(QString dirName);
+  void clear();
+
+  int count() const
+  {
+    return m_roms.size();
+  }
+
+  const RomInfo& at(int idx) const
+  {
+    return m_roms.at(idx);
+  }
+
+  int findImage(const QByteArray& hash) const;
+  QList<int> findFuelMap(const QByteArray& mapHash) const;
+
+  QString formatReport() const;
+
+  static QString defaultLayoutFileName();
+
+private:
+  // largest mean difference between neighbouring fuel map cells for which
+  // a layout is considered to have found real fuel maps
+  static const int s_maxMapRoughness = 24;
+
+  // number of bytes after a fuel map that are searched for its adjustment
+  // factor when learning a layout
+  static const int s_adjFactorSearchBytes = 16;
+
+  QVector<RomLayout> m_layouts;
+  QVector<RomInfo> m_roms;
+  QHash<QByteArray, int> m_imageIndex;
+  QMultiHash<QByteArray, int> m_fuelMapIndex;
+
+  void addToIndex(const RomInfo& info);
+  static double mapRoughness(const QByteArray& image, const RomLayout& layout);
+  static int readByte(const QByteArray& image, int offset);
+  static int readWord(const QByteArray& image, int offset);
+  static int uniqueIndexOf(const QByteArray& haystack, const QByteArray& needle, int from = 0, int to = -1);
+  static int addressToOffset(QString address);
+};
+
+#endif // ROMANALYZER_H
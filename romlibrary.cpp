@@ -0,0 +1,405 @@
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include "romlibrary.h"
+
+RomFingerprint::RomFingerprint() :
+  mafScaler(-1)
+{
+  for (int block = 0; block < s_numBlocks; block++)
+  {
+    blockHashes[block] = 0;
+  }
+
+  for (int idx = 0; idx < RomLayout::s_numFuelMaps; idx++)
+  {
+    adjFactors[idx] = -1;
+    rowScalers[idx] = -1;
+  }
+}
+
+RomLibrary::RomLibrary() :
+  m_dirty(false)
+{
+}
+
+/**
+ * Returns the name of the file in which the library is kept.
+ */
+QString RomLibrary::libraryFileName()
+{
+  return QDir(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation)).filePath("romlibrary.dat");
+}
+
+/**
+ * Sets up the table layouts used to fingerprint new images, and loads the
+ * library from disk.
+ * @return True if a stored library was loaded; false if there wasn't one (or
+ *  it couldn't be read), in which case the library starts out empty
+ */
+bool RomLibrary::load()
+{
+  m_analyzer.learnLayoutsFromCache();
+  m_analyzer.loadLayouts(RomAnalyzer::defaultLayoutFileName());
+
+  m_entries.clear();
+  m_dirty = false;
+
+  QFile file(libraryFileName());
+
+  if (!file.open(QFile::ReadOnly))
+  {
+    rebuildIndex();
+    return false;
+  }
+
+  QDataStream in(&file);
+  in.setVersion(QDataStream::Qt_5_0);
+  in.setByteOrder(QDataStream::BigEndian);
+
+  quint32 magic = 0;
+  quint16 version = 0;
+  quint32 count = 0;
+
+  in >> magic >> version >> count;
+
+  // sanity check the count against the length of the file before allocating
+  if ((magic != s_magic) || (version != s_version) || (in.status() != QDataStream::Ok) ||
+      ((qint64)count * RomFingerprint::s_numBlocks * 8 > file.size()))
+  {
+    rebuildIndex();
+    return false;
+  }
+
+  m_entries.resize(count);
+  for (quint32 idx = 0; idx < count; idx++)
+  {
+    RomFingerprint& fp = m_entries[idx];
+
+    in >> fp.fileName >> fp.hash >> fp.layoutName;
+    for (int block = 0; block < RomFingerprint::s_numBlocks; block++)
+    {
+      in >> fp.blockHashes[block];
+    }
+    for (int mapId = 0; mapId < RomLayout::s_numFuelMaps; mapId++)
+    {
+      qint32 adjFactor = -1;
+      qint32 rowScaler = -1;
+
+      in >> fp.fuelMapHashes[mapId] >> adjFactor >> rowScaler;
+      fp.adjFactors[mapId] = adjFactor;
+      fp.rowScalers[mapId] = rowScaler;
+    }
+
+    qint32 mafScaler = -1;
+    in >> mafScaler;
+    fp.mafScaler = mafScaler;
+  }
+
+  if (in.status() != QDataStream::Ok)
+  {
+    m_entries.clear();
+  }
+
+  rebuildIndex();
+  return !m_entries.isEmpty();
+}
+
+/**
+ * Writes the library to disk if it has changed since it was loaded.
+ * @return True if the library is up to date on disk; false otherwise
+ */
+bool RomLibrary::save()
+{
+  if (!m_dirty)
+  {
+    return true;
+  }
+
+  QDir().mkpath(QFileInfo(libraryFileName()).absolutePath());
+
+  QSaveFile file(libraryFileName());
+
+  if (!file.open(QFile::WriteOnly))
+  {
+    return false;
+  }
+
+  QDataStream out(&file);
+  out.setVersion(QDataStream::Qt_5_0);
+  out.setByteOrder(QDataStream::BigEndian);
+
+  out << s_magic << s_version << (quint32)m_entries.size();
+
+  foreach(const RomFingerprint& fp, m_entries)
+  {
+    out << fp.fileName << fp.hash << fp.layoutName;
+    for (int block = 0; block < RomFingerprint::s_numBlocks; block++)
+    {
+      out << fp.blockHashes[block];
+    }
+    for (int mapId = 0; mapId < RomLayout::s_numFuelMaps; mapId++)
+    {
+      out << fp.fuelMapHashes[mapId] << (qint32)fp.adjFactors[mapId] << (qint32)fp.rowScalers[mapId];
+    }
+    out << (qint32)fp.mafScaler;
+  }
+
+  if ((out.status() != QDataStream::Ok) || !file.commit())
+  {
+    return false;
+  }
+
+  m_dirty = false;
+  return true;
+}
+
+/**
+ * Fingerprints a ROM image.
+ * @return The fingerprint; its hash is empty if the image isn't a 16KB ROM
+ */
+RomFingerprint RomLibrary::fingerprint(const QByteArray& image, QString fileName) const
+{
+  RomFingerprint fp;
+  const RomInfo info = m_analyzer.analyze(image, fileName);
+
+  fp.fileName = fileName;
+  fp.hash = info.hash;
+
+  if (!fp.hash.isEmpty())
+  {
+    for (int block = 0; block < RomFingerprint::s_numBlocks; block++)
+    {
+      fp.blockHashes[block] = blockHash(image, block);
+    }
+
+    fp.layoutName = info.layoutName;
+    for (int mapId = 0; mapId < RomLayout::s_numFuelMaps; mapId++)
+    {
+      fp.fuelMapHashes[mapId] = info.fuelMapHashes[mapId];
+      fp.adjFactors[mapId] = info.adjFactors[mapId];
+      fp.rowScalers[mapId] = info.rowScalers[mapId];
+    }
+    fp.mafScaler = info.mafScaler;
+  }
+
+  return fp;
+}
+
+/**
+ * Adds a fingerprint to the library, replacing any entry for the same file.
+ * @return Index of the entry, or -1 if the fingerprint isn't valid
+ */
+int RomLibrary::add(const RomFingerprint& fp)
+{
+  if (fp.hash.isEmpty())
+  {
+    return -1;
+  }
+
+  int idx = fp.fileName.isEmpty() ? -1 : m_fileIndex.value(fp.fileName, -1);
+
+  if (idx >= 0)
+  {
+    m_entries[idx] = fp;
+    rebuildIndex();
+  }
+  else
+  {
+    idx = m_entries.size();
+    m_entries.append(fp);
+    indexEntry(idx);
+  }
+
+  m_dirty = true;
+  return idx;
+}
+
+/**
+ * Fingerprints a ROM image and adds it to the library.
+ * @return Index of the entry, or -1 if the image isn't a 16KB ROM
+ */
+int RomLibrary::addImage(const QByteArray& image, QString fileName)
+{
+  return add(fingerprint(image, fileName));
+}
+
+/**
+ * Adds every file in a directory that is the size of a ROM image.
+ * @return Number of images added
+ */
+int RomLibrary::addDirectory(QString dirName)
+{
+  int added = 0;
+
+  foreach(const QFileInfo& info, QDir(dirName).entryInfoList(QDir::Files, QDir::Name))
+  {
+    if (info.size() == RomAnalyzer::s_romSize)
+    {
+      QFile file(info.absoluteFilePath());
+
+      if (file.open(QFile::ReadOnly) && (addImage(file.readAll(), info.absoluteFilePath()) >= 0))
+      {
+        added++;
+      }
+    }
+  }
+
+  return added;
+}
+
+/**
+ * Finds the known ROM that has the most blocks in common with a fingerprint.
+ * @param fp Fingerprint to look up
+ * @param excludeSameFile True to skip any entry for the fingerprint's own file
+ * @return The closest entry and the number of blocks it shares; the index is
+ *  -1 if no entry shares any blocks
+ */
+RomLibrary::Match RomLibrary::closest(const RomFingerprint& fp, bool excludeSameFile) const
+{
+  QVector<int> counts(m_entries.size(), 0);
+  const int self = (excludeSameFile && !fp.fileName.isEmpty()) ? m_fileIndex.value(fp.fileName, -1) : -1;
+  Match best;
+
+  best.index = -1;
+  best.matchingBlocks = 0;
+
+  for (int block = 0; block < RomFingerprint::s_numBlocks; block++)
+  {
+    QHash<quint64, QVector<int> >::const_iterator it = m_blockIndex.constFind(fp.blockHashes[block]);
+
+    if (it != m_blockIndex.constEnd())
+    {
+      foreach(int idx, it.value())
+      {
+        if ((idx != self) && (++counts[idx] > best.matchingBlocks))
+        {
+          best.index = idx;
+          best.matchingBlocks = counts[idx];
+        }
+      }
+    }
+  }
+
+  return best;
+}
+
+/**
+ * Lists the differences between two ROM images: the decoded tables that
+ * differ (when both images were decoded), followed by the address ranges of
+ * all the blocks that differ.
+ */
+QStringList RomLibrary::differences(const RomFingerprint& a, const RomFingerprint& b)
+{
+  QStringList diffs;
+
+  if (a.hash == b.hash)
+  {
+    return diffs;
+  }
+
+  if (!a.layoutName.isEmpty() && !b.layoutName.isEmpty())
+  {
+    for (int mapId = 0; mapId < RomLayout::s_numFuelMaps; mapId++)
+    {
+      if (a.fuelMapHashes[mapId] != b.fuelMapHashes[mapId])
+      {
+        diffs.append(QString("Fuel map %1").arg(mapId));
+      }
+      if (a.adjFactors[mapId] != b.adjFactors[mapId])
+      {
+        diffs.append(QString("Fuel map %1 adjustment factor").arg(mapId));
+      }
+      if (a.rowScalers[mapId] != b.rowScalers[mapId])
+      {
+        diffs.append(QString("Fuel map %1 row scaler").arg(mapId));
+      }
+    }
+
+    if (a.mafScaler != b.mafScaler)
+    {
+      diffs.append("MAF row scaler");
+    }
+  }
+
+  int first = -1;
+
+  for (int block = 0; block <= RomFingerprint::s_numBlocks; block++)
+  {
+    const bool differs = (block < RomFingerprint::s_numBlocks) && (a.blockHashes[block] != b.blockHashes[block]);
+
+    if (differs && (first < 0))
+    {
+      first = block;
+    }
+    else if (!differs && (first >= 0))
+    {
+      const int start = RomAnalyzer::s_romBaseAddress + (first * RomFingerprint::s_blockSize);
+      const int end = RomAnalyzer::s_romBaseAddress + (block * RomFingerprint::s_blockSize) - 1;
+
+      diffs.append(QString("Bytes %1-%2").arg(start, 4, 16, QChar('0')).arg(end, 4, 16, QChar('0')).toUpper());
+      first = -1;
+    }
+  }
+
+  return diffs;
+}
+
+/**
+ * Rebuilds the lookup tables from the list of entries.
+ */
+void RomLibrary::rebuildIndex()
+{
+  m_fileIndex.clear();
+  m_blockIndex.clear();
+
+  for (int idx = 0; idx < m_entries.size(); idx++)
+  {
+    indexEntry(idx);
+  }
+}
+
+/**
+ * Adds an entry to the lookup tables.
+ */
+void RomLibrary::indexEntry(int idx)
+{
+  const RomFingerprint& fp = m_entries.at(idx);
+
+  if (!fp.fileName.isEmpty())
+  {
+    m_fileIndex.insert(fp.fileName, idx);
+  }
+
+  for (int block = 0; block < RomFingerprint::s_numBlocks; block++)
+  {
+    m_blockIndex[fp.blockHashes[block]].append(idx);
+  }
+}
+
+/**
+ * Hashes one block of an image, along with its position, so that the same
+ * bytes at different addresses don't match.
+ */
+quint64 RomLibrary::blockHash(const QByteArray& image, int block)
+{
+  QCryptographicHash hash(QCryptographicHash::Md5);
+  const char position = (char)block;
+
+  hash.addData(&position, 1);
+  hash.addData(image.constData() + (block * RomFingerprint::s_blockSize), RomFingerprint::s_blockSize);
+
+  const QByteArray digest = hash.result();
+  quint64 value = 0;
+
+  for (int idx = 0; idx < 8; idx++)
+  {
+    value = (value << 8) | (uchar)digest.at(idx);
+  }
+
+  return value;
+}
@@ -0,0 +1,90 @@
+#ifndef ROMLIBRARY_H
+#define ROMLIBRARY_H
+
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QVector>
+#include <QHash>
+#include "romanalyzer.h"
+
+/**
+ * A compact description of a ROM image that can be compared with others
+ * without the image itself: a hash of each fixed-size block of the image
+ * (so that images differing only in a few places can be recognized), and the
+ * hashes and values of the tables that RomAnalyzer decodes from it.
+ */
+struct RomFingerprint
+{
+  static const int s_blockSize = 256;
+  static const int s_numBlocks = RomAnalyzer::s_romSize / s_blockSize;
+
+  QString fileName;
+  QByteArray hash;
+  quint64 blockHashes[s_numBlocks];
+  QString layoutName;
+  QByteArray fuelMapHashes[RomLayout::s_numFuelMaps];
+  int adjFactors[RomLayout::s_numFuelMaps];
+  int rowScalers[RomLayout::s_numFuelMaps];
+  int mafScaler;
+
+  RomFingerprint();
+};
+
+/**
+ * A library of fingerprints of known ROM images, kept on disk, that answers
+ * "which known ROM is this closest to" and "which tables differ" quickly.
+ * Block hashes include the position of the block, and an inverted index maps
+ * each one to the images that contain it, so finding the closest ROM only
+ * has to visit the images that share at least one block with the query.
+ */
+class RomLibrary
+{
+public:
+  struct Match
+  {
+    int index;
+    int matchingBlocks;
+  };
+
+  RomLibrary();
+
+  bool load();
+  bool save();
+
+  int count() const
+  {
+    return m_entries.size();
+  }
+
+  const RomFingerprint& at(int idx) const
+  {
+    return m_entries.at(idx);
+  }
+
+  RomFingerprint fingerprint(const QByteArray& image, QString fileName = QString()) const;
+  int add(const RomFingerprint& fp);
+  int addImage(const QByteArray& image, QString fileName);
+  int addDirectory(QString dirName);
+
+  Match closest(const RomFingerprint& fp, bool excludeSameFile = true) const;
+  static QStringList differences(const RomFingerprint& a, const RomFingerprint& b);
+
+  static QString libraryFileName();
+
+private:
+  static const quint32 s_magic = 0x52474c42;
+  static const quint16 s_version = 1;
+
+  RomAnalyzer m_analyzer;
+  QVector<RomFingerprint> m_entries;
+  QHash<QString, int> m_fileIndex;
+  QHash<quint64, QVector<int> > m_blockIndex;
+  bool m_dirty;
+
+  void rebuildIndex();
+  void indexEntry(int idx);
+  static quint64 blockHash(const QByteArray& image, int block);
+};
+
+#endif // ROMLIBRARY_H
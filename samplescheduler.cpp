@@ -0,0 +1,306 @@
+#include <QMutexLocker>
+#include <algorithm>
+#include "samplescheduler.h"
+
+/**
+ * Constructor. All sample types start out disabled, with a zero interval and
+ * no deadband (i.e. not subject to adaptive tuning).
+ */
+SampleScheduler::SampleScheduler() :
+  m_adaptive(false)
+{
+  for (int type = 0; type < (int)SampleType_NumSampleTypes; type++)
+  {
+    m_enabled[type] = false;
+    m_intervalMs[type] = 0;
+    m_nextDueMs[type] = 0;
+    m_minIntervalMs[type] = 0;
+    m_maxIntervalMs[type] = 0;
+    m_adaptiveIntervalMs[type] = 0;
+    m_alwaysAdaptive[type] = false;
+    m_deadband[type] = 0.0;
+    m_lastValue[type] = 0.0;
+    m_lastSecondValue[type] = 0.0;
+    m_hasLastValue[type] = false;
+  }
+
+  m_clock.start();
+}
+
+/**
+ * Comparison used to order the heap so that the earliest deadline is at the
+ * front. Ties are broken by sample type so that the read order is stable.
+ */
+bool SampleScheduler::isLaterThan(const Deadline& a, const Deadline& b)
+{
+  return (a.dueMs > b.dueMs) || ((a.dueMs == b.dueMs) && (a.type > b.type));
+}
+
+/**
+ * Rebuilds the heap from the stored deadlines of the enabled sample types.
+ * Must be called with the lock held.
+ */
+void SampleScheduler::rebuildHeap()
+{
+  m_heap.clear();
+
+  for (int type = 0; type < (int)SampleType_NumSampleTypes; type++)
+  {
+    if (m_enabled[type])
+    {
+      Deadline d;
+      d.dueMs = m_nextDueMs[type];
+      d.type = (SampleType)type;
+      m_heap.append(d);
+    }
+  }
+
+  std::make_heap(m_heap.begin(), m_heap.end(), isLaterThan);
+}
+
+/**
+ * Enables or disables scheduling of a sample type. A newly-enabled sample is
+ * due immediately.
+ */
+void SampleScheduler::setEnabled(SampleType type, bool enabled)
+{
+  QMutexLocker locker(&m_lock);
+
+  if (m_enabled[type] != enabled)
+  {
+    m_enabled[type] = enabled;
+    m_nextDueMs[type] = m_clock.elapsed();
+    rebuildHeap();
+  }
+}
+
+/**
+ * Sets the minimum interval between successive reads of a sample type. The
+ * new interval takes effect when the sample is next rescheduled.
+ */
+void SampleScheduler::setInterval(SampleType type, unsigned int intervalMs)
+{
+  QMutexLocker locker(&m_lock);
+  m_intervalMs[type] = intervalMs;
+  m_adaptiveIntervalMs[type] = qBound(m_minIntervalMs[type], intervalMs, m_maxIntervalMs[type]);
+}
+
+/**
+ * Sets the range within which adaptive mode may tune a sample's interval.
+ */
+void SampleScheduler::setIntervalBounds(SampleType type, unsigned int minMs, unsigned int maxMs)
+{
+  QMutexLocker locker(&m_lock);
+  m_minIntervalMs[type] = minMs;
+  m_maxIntervalMs[type] = qMax(minMs, maxMs);
+  m_adaptiveIntervalMs[type] = qBound(m_minIntervalMs[type], m_intervalMs[type], m_maxIntervalMs[type]);
+}
+
+/**
+ * Sets the change in a sample's reading (in the units reported through
+ * reportValue()) that is considered significant. Samples with a deadband of
+ * zero always use their fixed interval.
+ */
+void SampleScheduler::setDeadband(SampleType type, double deadband)
+{
+  QMutexLocker locker(&m_lock);
+  m_deadband[type] = deadband;
+}
+
+/**
+ * Turns adaptive interval tuning on or off. Either way, tuning restarts from
+ * the fixed intervals.
+ */
+void SampleScheduler::setAdaptive(bool adaptive)
+{
+  QMutexLocker locker(&m_lock);
+  m_adaptive = adaptive;
+  resetAdaptiveIntervals();
+}
+
+/**
+ * Tunes a sample's interval from its readings even while adaptive mode is
+ * off. The sample still needs a deadband for its interval to be tuned.
+ */
+void SampleScheduler::setAlwaysAdaptive(SampleType type, bool always)
+{
+  QMutexLocker locker(&m_lock);
+  m_alwaysAdaptive[type] = always;
+}
+
+/**
+ * Resets every tuned interval to the fixed interval (clamped to the bounds)
+ * and forgets the last reported readings. Must be called with the lock held.
+ */
+void SampleScheduler::resetAdaptiveIntervals()
+{
+  for (int type = 0; type < (int)SampleType_NumSampleTypes; type++)
+  {
+    m_adaptiveIntervalMs[type] = qBound(m_minIntervalMs[type], m_intervalMs[type], m_maxIntervalMs[type]);
+    m_hasLastValue[type] = false;
+  }
+}
+
+/**
+ * Indicates whether a sample's interval is being tuned from its readings.
+ * Must be called with the lock held.
+ */
+bool SampleScheduler::isAdaptive(SampleType type) const
+{
+  return (m_adaptive || m_alwaysAdaptive[type]) && (m_deadband[type] > 0.0);
+}
+
+/**
+ * Returns the interval currently in effect for a sample type. Must be called
+ * with the lock held.
+ */
+unsigned int SampleScheduler::intervalFor(SampleType type) const
+{
+  return isAdaptive(type) ? m_adaptiveIntervalMs[type] : m_intervalMs[type];
+}
+
+/**
+ * Returns the interval currently in effect for a sample type.
+ */
+unsigned int SampleScheduler::currentInterval(SampleType type)
+{
+  QMutexLocker locker(&m_lock);
+  return intervalFor(type);
+}
+
+/**
+ * Reports a newly-read value for a sample so that its interval can be tuned.
+ * Has no effect unless the sample has a deadband and either adaptive mode is
+ * on or the sample is always adaptive.
+ * @param type Type of sample that was read
+ * @param value Reading, in the same units as the sample's deadband
+ * @param secondValue Second part of a reading made up of two values, which
+ *  is compared separately so that a change in either counts as movement
+ */
+void SampleScheduler::reportValue(SampleType type, double value, double secondValue)
+{
+  QMutexLocker locker(&m_lock);
+
+  if (!isAdaptive(type))
+  {
+    return;
+  }
+
+  if (m_hasLastValue[type])
+  {
+    const unsigned int oldInterval = m_adaptiveIntervalMs[type];
+    unsigned int interval = oldInterval;
+
+    if ((qAbs(value - m_lastValue[type]) >= m_deadband[type]) ||
+        (qAbs(secondValue - m_lastSecondValue[type]) >= m_deadband[type]))
+    {
+      // the signal is moving, so sample it more often
+      interval /= 2;
+    }
+    else
+    {
+      interval += (interval / 4) + s_adaptiveGrowthMs;
+    }
+
+    interval = qBound(m_minIntervalMs[type], interval, m_maxIntervalMs[type]);
+    m_adaptiveIntervalMs[type] = interval;
+
+    // The sample was already rescheduled using the old interval; if the
+    // interval has shrunk, pull the next deadline in to match.
+    if ((interval < oldInterval) && m_enabled[type])
+    {
+      const qint64 due = m_clock.elapsed() + interval;
+
+      if (due < m_nextDueMs[type])
+      {
+        m_nextDueMs[type] = due;
+        rebuildHeap();
+      }
+    }
+  }
+
+  m_lastValue[type] = value;
+  m_lastSecondValue[type] = secondValue;
+  m_hasLastValue[type] = true;
+}
+
+/**
+ * Makes every enabled sample due immediately. Used when (re)connecting so that
+ * the first sweep reads everything.
+ */
+void SampleScheduler::restart()
+{
+  QMutexLocker locker(&m_lock);
+  const qint64 now = m_clock.elapsed();
+
+  for (int type = 0; type < (int)SampleType_NumSampleTypes; type++)
+  {
+    m_nextDueMs[type] = now;
+  }
+
+  resetAdaptiveIntervals();
+  rebuildHeap();
+}
+
+/**
+ * Removes every sample whose deadline has passed from the heap, reschedules
+ * each one for its next interval, and returns them in deadline order.
+ * Deadlines advance by a whole interval from the previous deadline (rather
+ * than from the current time) so that the read cadence doesn't drift; a
+ * sample that has fallen more than an interval behind is rescheduled from
+ * the current time instead of being read in a burst to catch up.
+ * @return List of sample types that are due to be read now
+ */
+QList<SampleType> SampleScheduler::takeDueSamples()
+{
+  QList<SampleType> due;
+  QVector<Deadline> rescheduled;
+  QMutexLocker locker(&m_lock);
+  const qint64 now = m_clock.elapsed();
+
+  while (!m_heap.isEmpty() && (m_heap.first().dueMs <= now))
+  {
+    std::pop_heap(m_heap.begin(), m_heap.end(), isLaterThan);
+    Deadline d = m_heap.last();
+    m_heap.removeLast();
+
+    due.append(d.type);
+
+    const unsigned int interval = intervalFor(d.type);
+    d.dueMs += interval;
+    if (d.dueMs <= now)
+    {
+      d.dueMs = now + interval;
+    }
+
+    m_nextDueMs[d.type] = d.dueMs;
+    rescheduled.append(d);
+  }
+
+  foreach(const Deadline& d, rescheduled)
+  {
+    m_heap.append(d);
+    std::push_heap(m_heap.begin(), m_heap.end(), isLaterThan);
+  }
+
+  return due;
+}
+
+/**
+ * Returns the number of milliseconds until the earliest deadline.
+ * @return Milliseconds until the next sample is due (0 if one is already due),
+ *   or -1 if no samples are enabled
+ */
+qint64 SampleScheduler::msecsUntilNextDue()
+{
+  QMutexLocker locker(&m_lock);
+  qint64 wait = -1;
+
+  if (!m_heap.isEmpty())
+  {
+    wait = qMax(m_heap.first().dueMs - m_clock.elapsed(), (qint64)0);
+  }
+
+  return wait;
+}
+
@@ -0,0 +1,77 @@
+#ifndef SAMPLESCHEDULER_H
+#define SAMPLESCHEDULER_H
+
+#include <QList>
+#include <QVector>
+#include <QMutex>
+#include <QElapsedTimer>
+#include "commonunits.h"
+
+/**
+ * Tracks the time at which each type of sample is next due to be read from
+ * the ECU. Deadlines are kept in a min-heap (keyed on a monotonic clock) so
+ * that the polling loop only visits samples that are actually due, and can
+ * sleep until the earliest upcoming deadline when nothing is.
+ *
+ * In adaptive mode, the interval for each sample that has a deadband is tuned
+ * from the readings reported back to the scheduler: it is halved whenever a
+ * reading moves by more than the deadband, and grows gradually while the
+ * signal is stable, always staying within the configured bounds. Samples
+ * can also be marked to be tuned this way even when adaptive mode is off.
+ */
+class SampleScheduler
+{
+public:
+  SampleScheduler();
+
+  void setEnabled(SampleType type, bool enabled);
+  void setInterval(SampleType type, unsigned int intervalMs);
+  void setIntervalBounds(SampleType type, unsigned int minMs, unsigned int maxMs);
+  void setDeadband(SampleType type, double deadband);
+  void setAdaptive(bool adaptive);
+  void setAlwaysAdaptive(SampleType type, bool always);
+  void restart();
+
+  void reportValue(SampleType type, double value, double secondValue = 0.0);
+  unsigned int currentInterval(SampleType type);
+
+  QList<SampleType> takeDueSamples();
+  qint64 msecsUntilNextDue();
+
+private:
+  struct Deadline
+  {
+    qint64 dueMs;
+    SampleType type;
+  };
+
+  static bool isLaterThan(const Deadline& a, const Deadline& b);
+  void rebuildHeap();
+  void resetAdaptiveIntervals();
+  bool isAdaptive(SampleType type) const;
+  unsigned int intervalFor(SampleType type) const;
+
+  // fixed amount added to an interval each time a stable reading is seen,
+  // so that a zero interval can start to grow
+  static const unsigned int s_adaptiveGrowthMs = 5;
+
+  QMutex m_lock;
+  QElapsedTimer m_clock;
+  QVector<Deadline> m_heap;
+  bool m_enabled[SampleType_NumSampleTypes];
+  unsigned int m_intervalMs[SampleType_NumSampleTypes];
+  qint64 m_nextDueMs[SampleType_NumSampleTypes];
+
+  bool m_adaptive;
+  bool m_alwaysAdaptive[SampleType_NumSampleTypes];
+  unsigned int m_minIntervalMs[SampleType_NumSampleTypes];
+  unsigned int m_maxIntervalMs[SampleType_NumSampleTypes];
+  unsigned int m_adaptiveIntervalMs[SampleType_NumSampleTypes];
+  double m_deadband[SampleType_NumSampleTypes];
+  double m_lastValue[SampleType_NumSampleTypes];
+  double m_lastSecondValue[SampleType_NumSampleTypes];
+  bool m_hasLastValue[SampleType_NumSampleTypes];
+};
+
+#endif // SAMPLESCHEDULER_H
+
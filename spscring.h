@@ -0,0 +1,90 @@
+#ifndef SPSCRING_H
+#define SPSCRING_H
+
+#include <QAtomicInt>
+#include <QVector>
+
+/**
+ * Fixed-capacity queue that passes values from one producer thread to one
+ * consumer thread without locking. The producer only ever advances the head
+ * and the consumer only ever advances the tail, so each index has a single
+ * writer; the acquire/release pairs on the two indices make the slot
+ * contents visible to the other side before the index that covers them.
+ * When the queue is full, push() fails rather than waiting.
+ */
+template <typename T>
+class SpscRing
+{
+public:
+  /**
+   * Constructor.
+   * @param capacityPow2 Log2 of the number of slots
+   */
+  explicit SpscRing(int capacityPow2) :
+    m_slots(1 << capacityPow2),
+    m_mask((1 << capacityPow2) - 1),
+    m_head(0),
+    m_tail(0)
+  {
+  }
+
+  int capacity() const
+  {
+    return m_slots.size();
+  }
+
+  /**
+   * Returns the number of values waiting. Exact only when called from the
+   * producer or the consumer while the other side is idle.
+   */
+  int size() const
+  {
+    return (int)((unsigned int)m_head.loadAcquire() - (unsigned int)m_tail.loadAcquire());
+  }
+
+  /**
+   * Adds a value to the queue. Called by the producer only.
+   * @return False if the queue is full; true otherwise
+   */
+  bool push(const T& value)
+  {
+    const unsigned int head = (unsigned int)m_head.loadAcquire();
+
+    if (head - (unsigned int)m_tail.loadAcquire() >= (unsigned int)m_slots.size())
+    {
+      return false;
+    }
+
+    m_slots[head & m_mask] = value;
+    m_head.storeRelease((int)(head + 1));
+    return true;
+  }
+
+  /**
+   * Removes up to maxCount values from the queue. Called by the consumer only.
+   * @return Number of values copied into the array
+   */
+  int pop(T* values, int maxCount)
+  {
+    const unsigned int tail = (unsigned int)m_tail.loadAcquire();
+    const int count = qMin((int)((unsigned int)m_head.loadAcquire() - tail), maxCount);
+
+    for (int idx = 0; idx < count; idx++)
+    {
+      values[idx] = m_slots[(tail + idx) & m_mask];
+    }
+
+    m_tail.storeRelease((int)(tail + count));
+    return count;
+  }
+
+private:
+  QVector<T> m_slots;
+  const unsigned int m_mask;
+  QAtomicInt m_head;
+  QAtomicInt m_tail;
+
+  Q_DISABLE_COPY(SpscRing)
+};
+
+#endif // SPSCRING_H
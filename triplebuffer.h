@@ -0,0 +1,72 @@
+#ifndef TRIPLEBUFFER_H
+#define TRIPLEBUFFER_H
+
+#include <QAtomicInt>
+
+/**
+ * Passes the latest value of a type from one writer thread to one reader
+ * thread without locking. Three copies are kept: one owned by the writer,
+ * one owned by the reader, and one in the middle. Publishing swaps the
+ * writer's copy with the middle one; reading swaps the middle copy with the
+ * reader's own if a newer one has been published. Neither side ever touches
+ * the copy owned by the other, so a read never sees a partially-written value
+ * and the writer never waits for the reader.
+ */
+template <typename T>
+class TripleBuffer
+{
+public:
+  TripleBuffer() :
+    m_buffers(),
+    m_writeIndex(0),
+    m_readIndex(1),
+    m_middle(2)
+  {
+  }
+
+  /**
+   * Returns the copy owned by the writer, to be filled in before publish().
+   * Note that this does not necessarily hold the last published value.
+   */
+  T& writeBuffer()
+  {
+    return m_buffers[m_writeIndex];
+  }
+
+  /**
+   * Makes the contents of the write buffer available to the reader.
+   */
+  void publish()
+  {
+    m_writeIndex = m_middle.fetchAndStoreAcquireRelease(m_writeIndex | s_freshFlag) & s_indexMask;
+  }
+
+  /**
+   * Returns the most recently published value. The reference remains valid
+   * until the next call to read().
+   */
+  const T& read()
+  {
+    // Only the reader clears the flag, so if it's set here it's still set
+    // when the swap happens, even if the writer publishes in between.
+    if (m_middle.loadAcquire() & s_freshFlag)
+    {
+      m_readIndex = m_middle.fetchAndStoreAcquireRelease(m_readIndex) & s_indexMask;
+    }
+
+    return m_buffers[m_readIndex];
+  }
+
+private:
+  static const int s_indexMask = 0x3;
+  static const int s_freshFlag = 0x4;
+
+  T m_buffers[3];
+  int m_writeIndex;
+  int m_readIndex;
+  QAtomicInt m_middle;
+
+  Q_DISABLE_COPY(TripleBuffer)
+};
+
+#endif // TRIPLEBUFFER_H
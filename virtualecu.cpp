@@ -0,0 +1,276 @@
+#include <math.h>
+#include <string.h>
+#include "virtualecu.h"
+#include "readplan.h"
+
+// Engine speed breakpoints for the fuel map columns
+const uint16_t VirtualEcu::s_rpmTable[FUEL_MAP_COLUMNS] =
+{
+  600, 800, 1000, 1200, 1500, 1800, 2100, 2400,
+  2700, 3000, 3400, 3800, 4200, 4600, 5000, 5500
+};
+
+namespace
+{
+// Airflow (as a fraction of full scale) breakpoints for the fuel map rows
+const double s_loadTable[FUEL_MAP_ROWS] =
+{
+  0.0, 0.08, 0.16, 0.26, 0.38, 0.52, 0.70, 0.90
+};
+
+// Length of the repeating drive cycle, in seconds
+const double s_driveCycleSec = 30.0;
+
+const double s_pi = 3.14159265358979;
+
+double exponentialApproach(double current, double target, double dtSec, double timeConstantSec)
+{
+  return current + (target - current) * (1.0 - exp(-dtSec / timeConstantSec));
+}
+}
+
+/**
+ * Constructor. Builds the ROM image and starts the engine model from a cold
+ * start at idle.
+ */
+VirtualEcu::VirtualEcu() :
+  m_lastUpdateMs(-1),
+  m_memory(0x10000, (char)0x00)
+{
+  memset(&m_state, 0, sizeof(m_state));
+  m_state.gear = C14CUX_Gear_ManualGearbox;
+  m_state.fuelMapIndex = s_fuelMapIndex;
+  m_state.fuelPumpRelayOn = true;
+  m_state.coTrimVoltage = 2.5;
+
+  buildROM();
+
+  m_clock.start();
+  update();
+}
+
+/**
+ * Fills the ROM image with the simulated fuel maps.
+ */
+void VirtualEcu::buildROM()
+{
+  char* mem = m_memory.data();
+
+  memset(mem + s_romBase, 0xFF, m_memory.size() - s_romBase);
+
+  for (unsigned int mapId = 0; mapId < s_fuelMapCount; mapId++)
+  {
+    uint8_t* map = (uint8_t*)(mem + fuelMapOffset(mapId));
+
+    for (int row = 0; row < FUEL_MAP_ROWS; row++)
+    {
+      for (int col = 0; col < FUEL_MAP_COLUMNS; col++)
+      {
+        map[row * FUEL_MAP_COLUMNS + col] = (uint8_t)qMin(0x20 + (row * 0x14) + (col * 4) + mapId, (unsigned int)0xFF);
+      }
+    }
+  }
+}
+
+/**
+ * Returns the address of the data for a fuel map.
+ */
+uint16_t VirtualEcu::fuelMapOffset(unsigned int fuelMapId) const
+{
+  return s_romBase + 0x0100 + (fuelMapId * 0x0100);
+}
+
+/**
+ * Returns the throttle opening (0 to 1) at a point in the drive cycle.
+ * @param seconds Time since the start of the cycle
+ */
+double VirtualEcu::throttleForCycleTime(double seconds)
+{
+  double throttle = 0.0;
+
+  if (seconds < 8.0)
+  {
+    throttle = 0.0;                                  // idle
+  }
+  else if (seconds < 10.0)
+  {
+    throttle = (seconds - 8.0) / 2.0 * 0.6;          // accelerate
+  }
+  else if (seconds < 16.0)
+  {
+    throttle = 0.6;
+  }
+  else if (seconds < 17.0)
+  {
+    throttle = 0.6 - (seconds - 16.0) * 0.45;        // lift off to cruise
+  }
+  else if (seconds < 25.0)
+  {
+    throttle = 0.15;
+  }
+  else
+  {
+    throttle = 0.0;                                  // overrun back to idle
+  }
+
+  return throttle;
+}
+
+/**
+ * Finds the position of a value along a fuel map axis.
+ * @return Byte with the index of the cell in the upper nibble and the
+ *  weighting towards the next cell (in sixteenths) in the lower
+ */
+uint8_t VirtualEcu::axisPosition(double value, const double* breakpoints, int count)
+{
+  int index = 0;
+  int weighting = 0;
+
+  while ((index < (count - 1)) && (value >= breakpoints[index + 1]))
+  {
+    index++;
+  }
+
+  if ((index < (count - 1)) && (value > breakpoints[index]))
+  {
+    weighting = (int)((value - breakpoints[index]) / (breakpoints[index + 1] - breakpoints[index]) * 16.0);
+    weighting = qMin(weighting, 15);
+  }
+
+  return (uint8_t)((index << 4) | weighting);
+}
+
+/**
+ * Advances the engine model to the current time and updates the memory image.
+ */
+void VirtualEcu::update()
+{
+  const qint64 nowMs = m_clock.elapsed();
+  const double t = nowMs / 1000.0;
+  const bool firstUpdate = (m_lastUpdateMs < 0);
+  const double dt = firstUpdate ? 0.0 : ((nowMs - m_lastUpdateMs) / 1000.0);
+  State& s = m_state;
+
+  m_lastUpdateMs = nowMs;
+
+  s.coolantTempF = 190.0 - (130.0 * exp(-t / 300.0));
+  s.fuelTempF = 70.0 + (35.0 * (1.0 - exp(-t / 900.0)));
+  s.targetIdle = (s.coolantTempF < 140.0) ? 1000 : 700;
+
+  s.throttle = throttleForCycleTime(fmod(t, s_driveCycleSec));
+
+  if (firstUpdate)
+  {
+    s.rpm = s.targetIdle;
+  }
+  else
+  {
+    const double rpmTarget = qMin(s.targetIdle + (s.throttle * 4800.0), (double)s_rpmLimit);
+    s.rpm = exponentialApproach(s.rpm, rpmTarget, dt, 0.4);
+
+    const double speedTarget = (s.throttle > 0.05) ? ((s.rpm - 700.0) * 0.035) : 0.0;
+    s.roadSpeedKph = exponentialApproach(s.roadSpeedKph, qMax(speedTarget, 0.0), dt, 3.0);
+  }
+
+  s.maf = qBound(0.0, 0.04 + (0.9 * s.throttle * (0.3 + 0.7 * s.rpm / s_rpmLimit)), 1.0);
+  s.idleMode = (s.throttle < 0.02) && (s.rpm < (s.targetIdle + 300));
+  s.idleBypassPos = s.idleMode ? (0.35 + 0.05 * sin(t)) : 0.15;
+  s.pulseWidthMs = 1.2 + (9.0 * s.maf);
+  s.mainVoltage = 14.1 + (0.1 * sin(t * 0.7));
+
+  s.lambdaTrimShortOdd = (int)(25.0 * sin(2.0 * s_pi * t / 1.5));
+  s.lambdaTrimShortEven = (int)(25.0 * sin((2.0 * s_pi * t / 1.5) + 1.0));
+  s.lambdaTrimLongOdd = (int)(8.0 + 2.0 * sin(t / 60.0));
+  s.lambdaTrimLongEven = -5;
+
+  double rpmBreakpoints[FUEL_MAP_COLUMNS];
+  for (int col = 0; col < FUEL_MAP_COLUMNS; col++)
+  {
+    rpmBreakpoints[col] = s_rpmTable[col];
+  }
+
+  s.fuelMapRowCol[0] = axisPosition(s.maf, s_loadTable, FUEL_MAP_ROWS);
+  s.fuelMapRowCol[1] = axisPosition(s.rpm, rpmBreakpoints, FUEL_MAP_COLUMNS);
+
+  updateMemory();
+}
+
+/**
+ * Writes the values that are read directly from RAM into the memory image,
+ * using the same encoding as the ECU.
+ */
+void VirtualEcu::updateMemory()
+{
+  uint8_t* mem = (uint8_t*)m_memory.data();
+  const uint16_t period = (m_state.rpm >= 1.0) ?
+                          (uint16_t)qMin(ReadPlan::s_rpmPeriodDividend / m_state.rpm, 65534.0) : 0xFFFF;
+  const uint16_t pulseWidthTicks = (uint16_t)(m_state.pulseWidthMs * 1000.0 / ReadPlan::s_timerTickUs);
+
+  mem[C14CUX_FuelMapRowIndexOffset] = m_state.fuelMapRowCol[0];
+  mem[C14CUX_FuelMapColumnIndexOffset] = m_state.fuelMapRowCol[1];
+  mem[C14CUX_RoadSpeedOffset] = (uint8_t)qMin(m_state.roadSpeedKph + 0.5, 255.0);
+  mem[C14CUX_EngineSpeedFilteredOffset] = period >> 8;
+  mem[C14CUX_EngineSpeedFilteredOffset + 1] = period & 0xFF;
+  mem[ReadPlan::s_injectorPulseWidthOffset] = pulseWidthTicks >> 8;
+  mem[ReadPlan::s_injectorPulseWidthOffset + 1] = pulseWidthTicks & 0xFF;
+}
+
+/**
+ * Copies a block of the memory image. Reads past the end of the address space
+ * wrap around to the start.
+ */
+void VirtualEcu::readMem(uint16_t offset, uint16_t length, uint8_t* buffer) const
+{
+  const uint8_t* mem = (const uint8_t*)m_memory.constData();
+
+  for (unsigned int idx = 0; idx < length; idx++)
+  {
+    buffer[idx] = mem[(uint16_t)(offset + idx)];
+  }
+}
+
+/**
+ * Writes a byte of the memory image. Writes to the ROM are ignored.
+ */
+void VirtualEcu::writeMem(uint16_t offset, uint8_t value)
+{
+  if (offset < s_romBase)
+  {
+    m_memory[offset] = (char)value;
+  }
+}
+
+/**
+ * Returns a pointer to the start of the ROM image.
+ */
+const uint8_t* VirtualEcu::rom() const
+{
+  return (const uint8_t*)(m_memory.constData() + s_romBase);
+}
+
+/**
+ * Returns a pointer to the data for a fuel map, or 0 if the ID is invalid.
+ */
+const uint8_t* VirtualEcu::fuelMap(unsigned int fuelMapId) const
+{
+  return (fuelMapId < s_fuelMapCount) ? (const uint8_t*)(m_memory.constData() + fuelMapOffset(fuelMapId)) : 0;
+}
+
+/**
+ * Returns the adjustment factor for a fuel map.
+ */
+uint16_t VirtualEcu::fuelMapAdjustmentFactor(unsigned int fuelMapId) const
+{
+  return 0x5000 + (fuelMapId * 0x0100);
+}
+
+/**
+ * Fills in the engine speed breakpoints used for the fuel map columns.
+ */
+void VirtualEcu::getRpmTable(c14cux_rpmtable* table) const
+{
+  for (int col = 0; col < FUEL_MAP_COLUMNS; col++)
+  {
+    table->rpm[col] = s_rpmTable[col];
+  }
+}
@@ -0,0 +1,87 @@
+#ifndef VIRTUALECU_H
+#define VIRTUALECU_H
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <stdint.h>
+#include "comm14cux.h"
+
+/**
+ * A simulated 14CUX. A simple engine model runs through a repeating drive
+ * cycle (idle, acceleration, cruise, deceleration) while the engine warms up,
+ * and the resulting readings are kept both as engineering values (returned
+ * by the transport's high-level operations) and in a 64KB memory image whose
+ * RAM locations match those used by the ReadPlan, so that block reads decode
+ * to the same values. The ROM image occupies the top 16KB of the address
+ * space and contains the simulated fuel maps.
+ */
+class VirtualEcu
+{
+public:
+  struct State
+  {
+    double throttle;
+    double rpm;
+    double maf;
+    double coolantTempF;
+    double fuelTempF;
+    double roadSpeedKph;
+    double mainVoltage;
+    double idleBypassPos;
+    double pulseWidthMs;
+    double coTrimVoltage;
+    int lambdaTrimShortOdd;
+    int lambdaTrimShortEven;
+    int lambdaTrimLongOdd;
+    int lambdaTrimLongEven;
+    uint16_t targetIdle;
+    bool idleMode;
+    bool fuelPumpRelayOn;
+    bool milOn;
+    c14cux_gear gear;
+    uint8_t fuelMapIndex;
+    uint8_t fuelMapRowCol[2];
+  };
+
+  VirtualEcu();
+
+  void update();
+
+  const State& state() const
+  {
+    return m_state;
+  }
+
+  void readMem(uint16_t offset, uint16_t length, uint8_t* buffer) const;
+  void writeMem(uint16_t offset, uint8_t value);
+  const uint8_t* rom() const;
+  const uint8_t* fuelMap(unsigned int fuelMapId) const;
+  uint16_t fuelMapAdjustmentFactor(unsigned int fuelMapId) const;
+  void getRpmTable(c14cux_rpmtable* table) const;
+
+  static const uint16_t s_tune = 0x3360;
+  static const uint8_t s_checksumFixer = 0x5A;
+  static const uint16_t s_ident = 0x0B1D;
+  static const uint16_t s_rpmLimit = 5500;
+  static const uint8_t s_fuelMapRowScaler = 0x80;
+  static const uint16_t s_romBase = 0xC000;
+
+private:
+  static const unsigned int s_fuelMapCount = 6;
+  static const unsigned int s_fuelMapSize = FUEL_MAP_ROWS * FUEL_MAP_COLUMNS;
+  static const uint8_t s_fuelMapIndex = 5;
+  static const uint16_t s_rpmTable[FUEL_MAP_COLUMNS];
+
+  QElapsedTimer m_clock;
+  qint64 m_lastUpdateMs;
+  QByteArray m_memory;
+  State m_state;
+
+  static double throttleForCycleTime(double seconds);
+  static uint8_t axisPosition(double value, const double* breakpoints, int count);
+  void buildROM();
+  void updateMemory();
+  uint16_t fuelMapOffset(unsigned int fuelMapId) const;
+};
+
+#endif // VIRTUALECU_H
@@ -0,0 +1,267 @@
+#include <QThread>
+#include <string.h>
+#include "virtualecutransport.h"
+
+/**
+ * Constructor.
+ */
+VirtualEcuTransport::VirtualEcuTransport() :
+  m_connected(false),
+  m_baud(C14CUX_BAUD)
+{
+}
+
+/**
+ * No initialization is needed for the simulated ECU.
+ */
+void VirtualEcuTransport::init()
+{
+}
+
+/**
+ * "Connects" to the simulated ECU. The device name is ignored.
+ * @param device Ignored
+ * @param baud Baud rate of the simulated link, which determines how long each
+ *  operation takes
+ * @return Always true
+ */
+bool VirtualEcuTransport::connect(QString device, unsigned int baud)
+{
+  Q_UNUSED(device);
+
+  m_baud = (baud > 0) ? baud : C14CUX_BAUD;
+  m_connected = true;
+  return true;
+}
+
+void VirtualEcuTransport::disconnect()
+{
+  m_connected = false;
+}
+
+bool VirtualEcuTransport::isConnected()
+{
+  return m_connected;
+}
+
+/**
+ * Cancels the operation in progress. May be called from any thread.
+ */
+void VirtualEcuTransport::cancelRead()
+{
+  m_cancelRequested.storeRelease(1);
+}
+
+void VirtualEcuTransport::resetState()
+{
+}
+
+/**
+ * Estimates the number of bytes that an operation would put on the serial
+ * link, based on the ECU memory accesses that the library makes for it.
+ */
+unsigned int VirtualEcuTransport::wireBytes(const EcuRequest& request)
+{
+  unsigned int dataBytes = 0;
+  unsigned int accesses = 1;
+
+  switch (request.op)
+  {
+  case EcuOp_ReadMem:
+    dataBytes = request.args[1];
+    accesses = (dataBytes + s_blockReadSize - 1) / s_blockReadSize;
+    break;
+  case EcuOp_DumpROM:
+    dataBytes = s_romSize;
+    accesses = s_romSize / s_blockReadSize;
+    break;
+  case EcuOp_GetFuelMap:
+    dataBytes = (FUEL_MAP_ROWS * FUEL_MAP_COLUMNS) + 3;
+    accesses = 2;
+    break;
+  case EcuOp_GetRpmTable:
+    dataBytes = FUEL_MAP_COLUMNS * 2;
+    break;
+  case EcuOp_GetFaultCodes:
+  case EcuOp_ClearFaultCodes:
+  case EcuOp_GetTuneRevision:
+    dataBytes = 5;
+    break;
+  case EcuOp_DriveIdleAirControlMotor:
+    dataBytes = 1;
+    accesses = 3;
+    break;
+  case EcuOp_GetMAFReading:
+  case EcuOp_GetThrottlePosition:
+  case EcuOp_GetMainVoltage:
+  case EcuOp_GetTargetIdle:
+  case EcuOp_GetRPMLimit:
+    dataBytes = 2;
+    break;
+  default:
+    dataBytes = 1;
+    break;
+  }
+
+  return (accesses * s_requestOverheadBytes) + dataBytes;
+}
+
+/**
+ * Blocks for the time that the given number of bytes would take to transfer
+ * over the serial link.
+ * @return False if the wait was interrupted by a cancel request; true otherwise
+ */
+bool VirtualEcuTransport::waitForLink(unsigned int bytes)
+{
+  quint64 remainingUs = (quint64)bytes * s_bitsPerByte * 1000000 / m_baud;
+
+  while ((remainingUs > 0) && !m_cancelRequested.loadAcquire())
+  {
+    const unsigned long sliceUs = (unsigned long)qMin(remainingUs, (quint64)s_maxSleepSliceUs);
+    QThread::usleep(sliceUs);
+    remainingUs -= sliceUs;
+  }
+
+  return (m_cancelRequested.fetchAndStoreAcquire(0) == 0);
+}
+
+/**
+ * Performs an operation against the simulated ECU.
+ */
+bool VirtualEcuTransport::call(const EcuRequest& request, uint8_t* result, unsigned int resultSize)
+{
+  if (!m_connected || !waitForLink(wireBytes(request)))
+  {
+    return false;
+  }
+
+  m_ecu.update();
+
+  const VirtualEcu::State& s = m_ecu.state();
+  bool status = true;
+
+  switch (request.op)
+  {
+  case EcuOp_ReadMem:
+    m_ecu.readMem(request.args[0], request.args[1], result);
+    break;
+
+  case EcuOp_WriteMem:
+    m_ecu.writeMem(request.args[0], (uint8_t)request.args[1]);
+    break;
+
+  case EcuOp_DumpROM:
+    memcpy(result, m_ecu.rom(), s_romSize);
+    break;
+
+  case EcuOp_GetFaultCodes:
+    memset(result, 0, resultSize);
+    break;
+
+  case EcuOp_GetFuelMap:
+    {
+      EcuFuelMapResult* map = (EcuFuelMapResult*)result;
+      const uint8_t* data = m_ecu.fuelMap(request.args[0]);
+
+      if (data)
+      {
+        map->adjustmentFactor = m_ecu.fuelMapAdjustmentFactor(request.args[0]);
+        map->rowScaler = VirtualEcu::s_fuelMapRowScaler;
+        memcpy(map->data, data, sizeof(map->data));
+      }
+      else
+      {
+        status = false;
+      }
+    }
+    break;
+
+  case EcuOp_GetRpmTable:
+    m_ecu.getRpmTable((c14cux_rpmtable*)result);
+    break;
+
+  case EcuOp_GetTuneRevision:
+    {
+      EcuTuneRevisionResult* rev = (EcuTuneRevisionResult*)result;
+      rev->tune = VirtualEcu::s_tune;
+      rev->checksumFixer = VirtualEcu::s_checksumFixer;
+      rev->ident = VirtualEcu::s_ident;
+    }
+    break;
+
+  case EcuOp_GetRPMLimit:
+    *(uint16_t*)result = VirtualEcu::s_rpmLimit;
+    break;
+
+  case EcuOp_ClearFaultCodes:
+  case EcuOp_RunFuelPump:
+  case EcuOp_DriveIdleAirControlMotor:
+    break;
+
+  case EcuOp_GetMAFReading:
+    *(float*)result = (float)s.maf;
+    break;
+
+  case EcuOp_GetThrottlePosition:
+    *(float*)result = (float)s.throttle;
+    break;
+
+  case EcuOp_GetLambdaTrimShort:
+    *(int16_t*)result = (request.args[0] == C14CUX_Bank_Odd) ? s.lambdaTrimShortOdd : s.lambdaTrimShortEven;
+    break;
+
+  case EcuOp_GetLambdaTrimLong:
+    *(int16_t*)result = (request.args[0] == C14CUX_Bank_Odd) ? s.lambdaTrimLongOdd : s.lambdaTrimLongEven;
+    break;
+
+  case EcuOp_GetIdleBypassMotorPosition:
+    *(float*)result = (float)s.idleBypassPos;
+    break;
+
+  case EcuOp_GetMainVoltage:
+    *(float*)result = (float)s.mainVoltage;
+    break;
+
+  case EcuOp_GetTargetIdle:
+    *(uint16_t*)result = s.targetIdle;
+    break;
+
+  case EcuOp_GetIdleMode:
+    *(bool*)result = s.idleMode;
+    break;
+
+  case EcuOp_GetFuelPumpRelayState:
+    *(bool*)result = s.fuelPumpRelayOn;
+    break;
+
+  case EcuOp_GetGearSelection:
+    *(c14cux_gear*)result = s.gear;
+    break;
+
+  case EcuOp_GetCoolantTemp:
+    *(int16_t*)result = (int16_t)s.coolantTempF;
+    break;
+
+  case EcuOp_GetFuelTemp:
+    *(int16_t*)result = (int16_t)s.fuelTempF;
+    break;
+
+  case EcuOp_IsMILOn:
+    *(bool*)result = s.milOn;
+    break;
+
+  case EcuOp_GetCurrentFuelMap:
+    *result = s.fuelMapIndex;
+    break;
+
+  case EcuOp_GetCOTrimVoltage:
+    *(float*)result = (float)s.coTrimVoltage;
+    break;
+
+  default:
+    status = false;
+    break;
+  }
+
+  return status;
+}
@@ -0,0 +1,51 @@
+#ifndef VIRTUALECUTRANSPORT_H
+#define VIRTUALECUTRANSPORT_H
+
+#include <QAtomicInt>
+#include "ecutransport.h"
+#include "virtualecu.h"
+
+/**
+ * Transport backed by a simulated 14CUX. Each operation blocks for the time
+ * that its traffic would take on a real serial link at the configured baud
+ * rate, so that the polling engine sees realistic timing.
+ */
+class VirtualEcuTransport : public EcuTransport
+{
+public:
+  VirtualEcuTransport();
+
+  void init();
+  bool connect(QString device, unsigned int baud);
+  void disconnect();
+  bool isConnected();
+  void cancelRead();
+  void resetState();
+
+  bool call(const EcuRequest& request, uint8_t* result, unsigned int resultSize);
+
+private:
+  // Bytes of addressing/command overhead for each memory access, counting
+  // the echo of each byte sent
+  static const unsigned int s_requestOverheadBytes = 6;
+
+  // Size of the blocks in which large reads are performed
+  static const unsigned int s_blockReadSize = 256;
+
+  // Bits transmitted per byte (start bit, 8 data bits, stop bit)
+  static const unsigned int s_bitsPerByte = 10;
+
+  // Longest single sleep while waiting out link time, so that a cancel
+  // request is noticed promptly
+  static const unsigned int s_maxSleepSliceUs = 50000;
+
+  VirtualEcu m_ecu;
+  bool m_connected;
+  unsigned int m_baud;
+  QAtomicInt m_cancelRequested;
+
+  static unsigned int wireBytes(const EcuRequest& request);
+  bool waitForLink(unsigned int bytes);
+};
+
+#endif // VIRTUALECUTRANSPORT_H